@@ -101,6 +101,13 @@ EmuBlockIo2ReadBlocksEx (
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
 
   Status = Private->Io->ReadBlocks (Private->Io, MediaId, LBA, Token, BufferSize, Buffer);
+  if (!EFI_ERROR (Status) && (Token != NULL) && (Token->Event != NULL)) {
+    //
+    // The thunk completes the request before returning, and leaves
+    // signaling the caller's event to us.
+    //
+    gBS->SignalEvent (Token->Event);
+  }
 
   gBS->RestoreTPL (OldTpl);
   return Status;
@@ -158,6 +165,13 @@ EmuBlockIo2WriteBlocksEx (
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
 
   Status = Private->Io->WriteBlocks (Private->Io, MediaId, LBA, Token, BufferSize, Buffer);
+  if (!EFI_ERROR (Status) && (Token != NULL) && (Token->Event != NULL)) {
+    //
+    // The thunk completes the request before returning, and leaves
+    // signaling the caller's event to us.
+    //
+    gBS->SignalEvent (Token->Event);
+  }
 
   gBS->RestoreTPL (OldTpl);
   return Status;
@@ -203,6 +217,13 @@ EmuBlockIo2Flush (
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
 
   Status = Private->Io->FlushBlocks (Private->Io, Token);
+  if (!EFI_ERROR (Status) && (Token != NULL) && (Token->Event != NULL)) {
+    //
+    // The thunk completes the request before returning, and leaves
+    // signaling the caller's event to us.
+    //
+    gBS->SignalEvent (Token->Event);
+  }
 
   gBS->RestoreTPL (OldTpl);
   return Status;
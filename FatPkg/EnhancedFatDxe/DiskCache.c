@@ -24,6 +24,65 @@ Revision History
 
 #include "Fat.h"
 
+STATIC
+VOID
+FatClaimCacheTag (
+  IN CACHE_TAG          *CacheTag
+  )
+/*++
+
+Routine Description:
+
+  Take the cache page back from the read ahead filling it, if any.
+  The read ahead drops its data when it completes.
+
+Arguments:
+
+  CacheTag              - The Cache Tag for the cache page.
+
+Returns:
+
+  None.
+
+--*/
+{
+  if (CacheTag->ReadAhead != NULL) {
+    EfiAcquireLock (&FatTaskLock);
+    CacheTag->ReadAhead = NULL;
+    EfiReleaseLock (&FatTaskLock);
+  }
+}
+
+STATIC
+BOOLEAN
+FatDataPageCached (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
+  )
+/*++
+
+Routine Description:
+
+  Check whether the whole data page is in the Data cache.
+
+Arguments:
+
+  DiskCache             - The Data cache.
+  PageNo                - PageNo to check.
+
+Returns:
+
+  TRUE                  - The whole page is cached.
+  FALSE                 - The page is not cached, or only in part.
+
+--*/
+{
+  CACHE_TAG   *CacheTag;
+
+  CacheTag = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+  return (BOOLEAN) (CacheTag->PageNo == PageNo && CacheTag->RealSize == ((UINTN)1 << DiskCache->PageAlignment));
+}
+
 STATIC
 VOID
 FatFlushDataCacheRange (
@@ -79,6 +138,13 @@ Returns:
   for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
     GroupNo   = PageNo & GroupMask;
     CacheTag  = &DiskCache->CacheTag[GroupNo];
+    if (IoMode != READ_DISK && CacheTag->PageNo == PageNo) {
+      //
+      // A read ahead of this page would fill it with the data before the write.
+      //
+      FatClaimCacheTag (CacheTag);
+    }
+
     if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
       //
       // When reading data form disk directly, if some dirty data
@@ -220,6 +286,8 @@ Returns:
     return EFI_SUCCESS;
   }
 
+  FatClaimCacheTag (CacheTag);
+
   //
   // Write dirty cache page back to disk
   //
@@ -352,6 +420,7 @@ Returns:
   UINTN       PageNo;
   UINTN       AlignedPageCount;
   UINTN       OverRunPageNo;
+  UINTN       RunPageCount;
   DISK_CACHE  *DiskCache;
   UINT64      EntryPos;
   UINT8       PageAlignment;
@@ -393,19 +462,40 @@ Returns:
     //
     ASSERT (CacheDataType == CACHE_DATA);
 
-    EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
-    AlignedSize = AlignedPageCount << PageAlignment;
-    Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
-    if (EFI_ERROR (Status)) {
-      return Status;
+    while (AlignedPageCount > 0) {
+      //
+      // Read the pages in the cache, e.g. filled by a read ahead, from the cache,
+      // and the runs of pages between them from the disk
+      //
+      if (IoMode == READ_DISK && FatDataPageCached (DiskCache, PageNo)) {
+        RunPageCount = 1;
+        AlignedSize  = PageSize;
+        CopyMem (Buffer, DiskCache->CacheBase + ((PageNo & DiskCache->GroupMask) << PageAlignment), PageSize);
+      } else {
+        for (RunPageCount = 1; RunPageCount < AlignedPageCount; RunPageCount++) {
+          if (IoMode == READ_DISK && FatDataPageCached (DiskCache, PageNo + RunPageCount)) {
+            break;
+          }
+        }
+
+        EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
+        AlignedSize = RunPageCount << PageAlignment;
+        Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+        //
+        // If these access data over laps the relative cache range, these cache pages need
+        // to be updated.
+        //
+        FatFlushDataCacheRange (Volume, IoMode, PageNo, PageNo + RunPageCount, Buffer);
+      }
+
+      Buffer           += AlignedSize;
+      BufferSize       -= AlignedSize;
+      PageNo           += RunPageCount;
+      AlignedPageCount -= RunPageCount;
     }
-    //
-    // If these access data over laps the relative cache range, these cache pages need
-    // to be updated.
-    //
-    FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
-    Buffer      += AlignedSize;
-    BufferSize  -= AlignedSize;
   }
   //
   // The access of the OverRun data
@@ -421,6 +511,79 @@ Returns:
   return Status;
 }
 
+EFI_STATUS
+FatReadFatTable (
+  IN     FAT_VOLUME         *Volume,
+  IN     UINT64             Offset,
+  IN     UINTN              BufferSize,
+  OUT    UINT8              *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Read a large range of the first FAT directly from the disk, bypassing the
+  FAT cache, and patch the result with any dirty FAT cache pages which are
+  newer than the contents on the disk.
+  This is used to scan the whole FAT without thrashing the FAT cache.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Offset                - The starting byte offset of the FAT range to read.
+  BufferSize            - Size of Buffer.
+  Buffer                - Buffer receiving the FAT data.
+
+Returns:
+
+  EFI_SUCCESS           - The FAT range was read successfully.
+  Others                - An error occurred when reading the FAT.
+
+--*/
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       GroupIndex;
+  UINT64      PageStart;
+  UINT64      PageEnd;
+  UINT64      CopyStart;
+  UINT64      CopyEnd;
+
+  Status = FatDiskIo (Volume, READ_DISK, Offset, BufferSize, Buffer, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DiskCache = &Volume->DiskCache[CACHE_FAT];
+  if (!DiskCache->Dirty) {
+    return EFI_SUCCESS;
+  }
+
+  for (GroupIndex = 0; GroupIndex <= DiskCache->GroupMask; GroupIndex++) {
+    CacheTag = &DiskCache->CacheTag[GroupIndex];
+    if (CacheTag->RealSize == 0 || !CacheTag->Dirty) {
+      continue;
+    }
+    //
+    // Copy the overlapped part of the dirty cache page into the buffer
+    //
+    PageStart = DiskCache->BaseAddress + LShiftU64 (CacheTag->PageNo, DiskCache->PageAlignment);
+    PageEnd   = PageStart + CacheTag->RealSize;
+    CopyStart = MAX (PageStart, Offset);
+    CopyEnd   = MIN (PageEnd, Offset + BufferSize);
+    if (CopyStart < CopyEnd) {
+      CopyMem (
+        Buffer + (UINTN) (CopyStart - Offset),
+        DiskCache->CacheBase + (GroupIndex << DiskCache->PageAlignment) + (UINTN) (CopyStart - PageStart),
+        (UINTN) (CopyEnd - CopyStart)
+        );
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 FatVolumeFlushCache (
   IN FAT_VOLUME         *Volume,
@@ -480,6 +643,252 @@ Returns:
   return Status;
 }
 
+STATIC
+VOID
+FatDestroyReadAhead (
+  IN FAT_READ_AHEAD     *ReadAhead
+  )
+/*++
+
+Routine Description:
+
+  Free the read ahead.
+
+Arguments:
+
+  ReadAhead             - The read ahead to be freed.
+
+Returns:
+
+  None.
+
+--*/
+{
+  gBS->CloseEvent (ReadAhead->DiskIo2Token.Event);
+  FreePool (ReadAhead->Buffer);
+  FreePool (ReadAhead);
+}
+
+STATIC
+VOID
+EFIAPI
+FatOnReadAheadComplete (
+  IN  EFI_EVENT         Event,
+  IN  VOID              *Context
+  )
+/*++
+
+Routine Description:
+
+  Fill the cache page with the data of the completed read ahead, unless
+  the page was claimed by another access meanwhile, and free the read ahead.
+
+Arguments:
+
+  Event                 - Event whose notification function is being invoked.
+  Context               - The pointer to the FAT_READ_AHEAD.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_READ_AHEAD  *ReadAhead;
+  CACHE_TAG       *CacheTag;
+  DISK_CACHE      *DiskCache;
+  UINTN           GroupNo;
+
+  ASSERT (EfiGetCurrentTpl () == FatTaskLock.Tpl);
+
+  ReadAhead = (FAT_READ_AHEAD *) Context;
+  ASSERT (ReadAhead->Signature == FAT_READ_AHEAD_SIGNATURE);
+
+  CacheTag  = ReadAhead->CacheTag;
+  if (CacheTag != NULL && CacheTag->ReadAhead == ReadAhead) {
+    CacheTag->ReadAhead = NULL;
+    if (!EFI_ERROR (ReadAhead->DiskIo2Token.TransactionStatus)) {
+      DiskCache = &ReadAhead->Volume->DiskCache[CACHE_DATA];
+      GroupNo   = (UINTN) (CacheTag - DiskCache->CacheTag);
+      CopyMem (DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment), ReadAhead->Buffer, ReadAhead->BufferSize);
+      CacheTag->Dirty     = FALSE;
+      CacheTag->RealSize  = ReadAhead->BufferSize;
+    }
+  }
+
+  RemoveEntryList (&ReadAhead->Link);
+  FatDestroyReadAhead (ReadAhead);
+}
+
+VOID
+FatReadAhead (
+  IN FAT_VOLUME         *Volume,
+  IN UINT64             Offset,
+  IN UINTN              Length
+  )
+/*++
+
+Routine Description:
+
+  Read the Data cache pages which lie in full within the range through the
+  DiskIo2 protocol without waiting for the reads to complete.
+
+  Pages which are cached or being read ahead already are skipped, and so
+  are groups holding a dirty page. Nothing is read ahead while a
+  non-blocking write is in flight.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Offset                - The starting byte offset of the range on the disk.
+  Length                - The length of the range.
+
+Returns:
+
+  None.
+
+--*/
+{
+  EFI_STATUS      Status;
+  DISK_CACHE      *DiskCache;
+  CACHE_TAG       *CacheTag;
+  FAT_READ_AHEAD  *ReadAhead;
+  UINTN           PageNo;
+  UINTN           EndPageNo;
+  UINTN           PageSize;
+  UINT64          EntryPos;
+  UINT8           PageAlignment;
+
+  DiskCache = &Volume->DiskCache[CACHE_DATA];
+  if (Volume->DiskIo2 == NULL || Volume->PendingWrites != 0 || Offset < DiskCache->BaseAddress) {
+    return;
+  }
+
+  PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
+  EntryPos      = Offset - DiskCache->BaseAddress;
+  PageNo        = (UINTN) RShiftU64 (EntryPos + PageSize - 1, PageAlignment);
+  EndPageNo     = (UINTN) RShiftU64 (EntryPos + Length, PageAlignment);
+
+  for (; PageNo < EndPageNo; PageNo++) {
+    EntryPos = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+    if (EntryPos + PageSize > DiskCache->LimitAddress) {
+      break;
+    }
+
+    CacheTag = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+    if (CacheTag->ReadAhead != NULL ||
+        (CacheTag->RealSize > 0 && (CacheTag->PageNo == PageNo || CacheTag->Dirty))) {
+      continue;
+    }
+
+    ReadAhead = AllocateZeroPool (sizeof (*ReadAhead));
+    if (ReadAhead == NULL) {
+      break;
+    }
+
+    ReadAhead->Buffer = AllocatePool (PageSize);
+    if (ReadAhead->Buffer == NULL) {
+      FreePool (ReadAhead);
+      break;
+    }
+
+    ReadAhead->Signature  = FAT_READ_AHEAD_SIGNATURE;
+    ReadAhead->Volume     = Volume;
+    ReadAhead->CacheTag   = CacheTag;
+    ReadAhead->BufferSize = PageSize;
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    FatOnReadAheadComplete,
+                    ReadAhead,
+                    &ReadAhead->DiskIo2Token.Event
+                    );
+    if (EFI_ERROR (Status)) {
+      FreePool (ReadAhead->Buffer);
+      FreePool (ReadAhead);
+      break;
+    }
+
+    //
+    // The page held by the group is clean, drop it for the read ahead
+    //
+    CacheTag->PageNo    = PageNo;
+    CacheTag->RealSize  = 0;
+    EfiAcquireLock (&FatTaskLock);
+    CacheTag->ReadAhead = ReadAhead;
+    InsertTailList (&Volume->ReadAheads, &ReadAhead->Link);
+    EfiReleaseLock (&FatTaskLock);
+
+    Status = Volume->DiskIo2->ReadDiskEx (
+                                Volume->DiskIo2,
+                                Volume->MediaId,
+                                EntryPos,
+                                &ReadAhead->DiskIo2Token,
+                                PageSize,
+                                ReadAhead->Buffer
+                                );
+    if (EFI_ERROR (Status)) {
+      EfiAcquireLock (&FatTaskLock);
+      CacheTag->ReadAhead = NULL;
+      RemoveEntryList (&ReadAhead->Link);
+      EfiReleaseLock (&FatTaskLock);
+      FatDestroyReadAhead (ReadAhead);
+      break;
+    }
+  }
+}
+
+VOID
+FatWaitReadAhead (
+  IN FAT_VOLUME         *Volume
+  )
+/*++
+
+Routine Description:
+
+  Wait all the read aheads of the volume complete. The read aheads not
+  complete within FAT_READ_AHEAD_TIMEOUT, for example on a removed device,
+  are detached from the volume and free their buffers when they complete.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+
+Returns:
+
+  None.
+
+--*/
+{
+  BOOLEAN         ReadAheadDone;
+  UINTN           Timeout;
+  FAT_READ_AHEAD  *ReadAhead;
+
+  for (Timeout = 0; ; Timeout += FAT_READ_AHEAD_POLL_INTERVAL) {
+    EfiAcquireLock (&FatTaskLock);
+    ReadAheadDone = IsListEmpty (&Volume->ReadAheads);
+    EfiReleaseLock (&FatTaskLock);
+    if (ReadAheadDone || Timeout >= FAT_READ_AHEAD_TIMEOUT) {
+      break;
+    }
+
+    gBS->Stall (FAT_READ_AHEAD_POLL_INTERVAL);
+  }
+
+  EfiAcquireLock (&FatTaskLock);
+  while (!IsListEmpty (&Volume->ReadAheads)) {
+    ReadAhead = CR (Volume->ReadAheads.ForwardLink, FAT_READ_AHEAD, Link, FAT_READ_AHEAD_SIGNATURE);
+    DEBUG ((EFI_D_WARN, "FatWaitReadAhead: abandon the read ahead %p\n", ReadAhead));
+    RemoveEntryList (&ReadAhead->Link);
+    InitializeListHead (&ReadAhead->Link);
+    ReadAhead->CacheTag->ReadAhead = NULL;
+    ReadAhead->CacheTag            = NULL;
+    ReadAhead->Volume              = NULL;
+  }
+  EfiReleaseLock (&FatTaskLock);
+}
+
 EFI_STATUS
 FatInitializeDiskCache (
   IN FAT_VOLUME         *Volume
@@ -58,6 +58,7 @@ Revision History
 #define FAT_OFILE_SIGNATURE          SIGNATURE_32 ('f', 'a', 't', 'o')
 #define FAT_TASK_SIGNATURE           SIGNATURE_32 ('f', 'a', 't', 'T')
 #define FAT_SUBTASK_SIGNATURE        SIGNATURE_32 ('f', 'a', 't', 'S')
+#define FAT_READ_AHEAD_SIGNATURE     SIGNATURE_32 ('f', 'a', 't', 'R')
 
 #define ASSERT_VOLUME_LOCKED(a)      ASSERT_LOCKED (&FatFsLock)
 
@@ -100,6 +101,38 @@ Revision History
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// Non-blocking transfers are split into at most FAT_SUBTASK_MAX_COUNT
+// subtasks of at least FAT_SUBTASK_MIN_SIZE bytes each, which are all
+// outstanding on the DiskIo2 protocol at the same time
+//
+#define FAT_SUBTASK_MIN_SIZE              0x10000
+#define FAT_SUBTASK_MAX_COUNT             8
+
+//
+// A sequential file read reads ahead at most FAT_READ_AHEAD_PAGE_COUNT data
+// cache pages following the read through the DiskIo2 protocol
+//
+#define FAT_READ_AHEAD_PAGE_COUNT         4
+
+//
+// A volume being freed waits at most FAT_READ_AHEAD_TIMEOUT microseconds for
+// its read aheads, polling every FAT_READ_AHEAD_POLL_INTERVAL microseconds.
+// The read aheads still outstanding then free themselves when they complete
+//
+#define FAT_READ_AHEAD_TIMEOUT            (5 * 1000 * 1000)
+#define FAT_READ_AHEAD_POLL_INTERVAL      100
+
+//
+// The FAT is scanned in chunks of this size when building the free cluster
+// bitmap. It is a multiple of 3 bytes so that no FAT12 entry straddles two chunks.
+//
+#define FAT_FREE_BITMAP_SCAN_SIZE         0xC000
+
+#define FAT_BITMAP_IS_SET(Bitmap, Index)  (((Bitmap)[(Index) >> 3] & (1 << ((Index) & 7))) != 0)
+#define FAT_BITMAP_SET(Bitmap, Index)     ((Bitmap)[(Index) >> 3] |= (UINT8) (1 << ((Index) & 7)))
+#define FAT_BITMAP_CLEAR(Bitmap, Index)   ((Bitmap)[(Index) >> 3] &= (UINT8) ~(1 << ((Index) & 7)))
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -121,6 +154,7 @@ Revision History
 #define MAX_LANG_CODE_SIZE      100
 
 #define FAT_MAX_DIR_CACHE_COUNT 8
+#define FAT_EXTENT_MAP_MIN_COUNT 16
 #define FAT_MAX_DIRENTRY_COUNT  0xFFFF
 typedef CHAR8                   LC_ISO_639_2;
 
@@ -160,9 +194,10 @@ typedef enum {
 // Disk cache tag
 //
 typedef struct {
-  UINTN   PageNo;
-  UINTN   RealSize;
-  BOOLEAN Dirty;
+  UINTN                   PageNo;
+  UINTN                   RealSize;
+  BOOLEAN                 Dirty;
+  struct _FAT_READ_AHEAD  *ReadAhead;   // The read ahead filling the page, the page is invalid meanwhile
 } CACHE_TAG;
 
 typedef struct {
@@ -239,6 +274,30 @@ typedef struct {
   LIST_ENTRY          Link;
 } FAT_SUBTASK;
 
+//
+// A non-blocking read of a data cache page. The data is read into its own
+// buffer, and copied into the cache page when the read completes unless
+// the page was claimed by another access meanwhile.
+//
+typedef struct _FAT_READ_AHEAD {
+  UINTN               Signature;
+  EFI_DISK_IO2_TOKEN  DiskIo2Token;
+  struct _FAT_VOLUME  *Volume;
+  CACHE_TAG           *CacheTag;               // NULL if abandoned by the volume
+  VOID                *Buffer;
+  UINTN               BufferSize;
+  LIST_ENTRY          Link;                   // Link to other FAT_READ_AHEADs
+} FAT_READ_AHEAD;
+
+//
+// A run of physically contiguous clusters in a file's cluster chain
+//
+typedef struct {
+  UINTN               FileCluster;            // Index of the first cluster of this run within the file
+  UINTN               Cluster;                // The first cluster of this run on the disk
+  UINTN               Length;                 // Number of clusters in this run
+} FAT_EXTENT;
+
 //
 // FAT_OFILE - Each opened file
 //
@@ -281,6 +340,14 @@ typedef struct _FAT_OFILE {
   UINTN               Position; // within file
   UINT64              PosDisk;  // on the disk
   UINTN               PosRem;   // remaining in this disk run
+  UINTN               ReadEnd;  // position following the last read
+  //
+  // The extent map of the leading part of the cluster chain,
+  // built as the chain is read and sorted by FileCluster
+  //
+  FAT_EXTENT          *Extents;
+  UINTN               ExtentCount;
+  UINTN               ExtentMaxCount;
   //
   // The opened parent, full path length and currently opened child files
   //
@@ -345,6 +412,7 @@ typedef struct _FAT_VOLUME {
   FAT_INFO_SECTOR                 FatInfoSector;  // Free cluster info
   UINTN                           FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                         FreeInfoValid;  // If free cluster info is valid
+  UINT8                           *FreeBitmap;    // One bit per cluster, set if in use; built lazily
   //
   // Unpacked Fat BPB info
   //
@@ -385,6 +453,8 @@ typedef struct _FAT_VOLUME {
   //
   VOID                            *CacheBuffer;
   DISK_CACHE                      DiskCache[CACHE_MAX_TYPE];
+  LIST_ENTRY                      ReadAheads;     // List of all FAT_READ_AHEADs in flight
+  UINTN                           PendingWrites;  // Number of non-blocking writes in flight
 } FAT_VOLUME;
 
 //
@@ -802,12 +872,32 @@ FatAccessCache (
   IN     FAT_TASK            *Task
   );
 
+EFI_STATUS
+FatReadFatTable (
+  IN     FAT_VOLUME          *Volume,
+  IN     UINT64              Offset,
+  IN     UINTN               BufferSize,
+  OUT    UINT8               *Buffer
+  );
+
 EFI_STATUS
 FatVolumeFlushCache (
   IN FAT_VOLUME              *Volume,
   IN FAT_TASK                *Task
   );
 
+VOID
+FatReadAhead (
+  IN FAT_VOLUME              *Volume,
+  IN UINT64                  Offset,
+  IN UINTN                   Length
+  );
+
+VOID
+FatWaitReadAhead (
+  IN FAT_VOLUME              *Volume
+  );
+
 //
 // Flush.c
 //
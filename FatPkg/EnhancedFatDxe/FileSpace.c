@@ -147,6 +147,191 @@ Returns:
   return Accum;
 }
 
+STATIC
+EFI_STATUS
+FatBuildFreeBitmap (
+  IN FAT_VOLUME       *Volume
+  )
+/*++
+
+Routine Description:
+
+  Build the in-memory free cluster bitmap of the volume.
+  The FAT is read in large chunks directly from the disk and decoded in place,
+  instead of fetching every FAT entry through FatGetFatEntry ().
+
+Arguments:
+
+  Volume                - FAT file system volume.
+
+Returns:
+
+  EFI_SUCCESS           - The free cluster bitmap is built successfully.
+  EFI_DEVICE_ERROR      - The volume has a disk error.
+  EFI_OUT_OF_RESOURCES  - Not enough memory to build the bitmap.
+  other                 - An error occurred when reading the FAT.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT8       *Bitmap;
+  UINT8       *Buffer;
+  UINT8       *E12;
+  UINTN       EntryCount;
+  UINTN       EntriesPerChunk;
+  UINTN       ChunkEntries;
+  UINTN       ChunkPos;
+  UINTN       ChunkSize;
+  UINTN       Index;
+  UINTN       Entry;
+  UINTN       Value;
+
+  if (Volume->FreeBitmap != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if (Volume->DiskError) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  EntryCount  = Volume->MaxCluster + 2;
+  Bitmap      = AllocateZeroPool ((EntryCount + 7) / 8);
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Buffer = AllocatePool (FAT_FREE_BITMAP_SCAN_SIZE);
+  if (Buffer == NULL) {
+    FreePool (Bitmap);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  switch (Volume->FatType) {
+  case FAT12:
+    EntriesPerChunk = FAT_FREE_BITMAP_SCAN_SIZE * 2 / 3;
+    break;
+
+  case FAT16:
+    EntriesPerChunk = FAT_FREE_BITMAP_SCAN_SIZE / sizeof (UINT16);
+    break;
+
+  default:
+    EntriesPerChunk = FAT_FREE_BITMAP_SCAN_SIZE / sizeof (UINT32);
+  }
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < EntryCount; Index += ChunkEntries) {
+    ChunkEntries = MIN (EntriesPerChunk, EntryCount - Index);
+    //
+    // Compute the FAT range covering this chunk of entries
+    //
+    switch (Volume->FatType) {
+    case FAT12:
+      ChunkPos  = FAT_POS_FAT12 (Index);
+      ChunkSize = FAT_POS_FAT12 (ChunkEntries - 1) + sizeof (UINT16);
+      break;
+
+    case FAT16:
+      ChunkPos  = FAT_POS_FAT16 (Index);
+      ChunkSize = FAT_POS_FAT16 (ChunkEntries);
+      break;
+
+    default:
+      ChunkPos  = FAT_POS_FAT32 (Index);
+      ChunkSize = FAT_POS_FAT32 (ChunkEntries);
+    }
+
+    //
+    // Entries which are not backed by the FAT are treated as in use
+    //
+    SetMem (Buffer, FAT_FREE_BITMAP_SCAN_SIZE, 0xFF);
+    if (ChunkPos + ChunkSize > Volume->FatSize) {
+      ChunkSize = Volume->FatSize - ChunkPos;
+    }
+
+    Status = FatReadFatTable (Volume, Volume->FatPos + ChunkPos, ChunkSize, Buffer);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    for (Entry = 0; Entry < ChunkEntries; Entry++) {
+      switch (Volume->FatType) {
+      case FAT12:
+        E12   = Buffer + FAT_POS_FAT12 (Entry);
+        Value = E12[0] | (E12[1] << 8);
+        Value = FAT_ODD_CLUSTER_FAT12 (Entry) ? (Value >> 4) : (Value & FAT_CLUSTER_MASK_FAT12);
+        break;
+
+      case FAT16:
+        Value = ((UINT16 *) Buffer)[Entry];
+        break;
+
+      default:
+        Value = ((UINT32 *) Buffer)[Entry] & FAT_CLUSTER_MASK_FAT32;
+      }
+
+      if (Index + Entry < FAT_MIN_CLUSTER || Value != FAT_CLUSTER_FREE) {
+        FAT_BITMAP_SET (Bitmap, Index + Entry);
+      }
+    }
+  }
+
+  FreePool (Buffer);
+  if (EFI_ERROR (Status)) {
+    FreePool (Bitmap);
+    return Status;
+  }
+
+  Volume->FreeBitmap = Bitmap;
+  return EFI_SUCCESS;
+}
+
+STATIC
+UINTN
+FatFindFreeCluster (
+  IN FAT_VOLUME       *Volume,
+  IN UINTN            Start
+  )
+/*++
+
+Routine Description:
+
+  Search the free cluster bitmap for the first free cluster at or after Start.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Start                 - The cluster to start searching from.
+
+Returns:
+
+  The index of the free cluster, or MaxCluster + 2 if there is none.
+
+--*/
+{
+  UINTN Index;
+  UINTN Limit;
+
+  Limit = Volume->MaxCluster + 2;
+  for (Index = Start; Index < Limit;) {
+    //
+    // Skip fully allocated bytes of the bitmap at once
+    //
+    if ((Index & 7) == 0 && Volume->FreeBitmap[Index >> 3] == 0xFF) {
+      Index += 8;
+      continue;
+    }
+
+    if (!FAT_BITMAP_IS_SET (Volume->FreeBitmap, Index)) {
+      return Index;
+    }
+
+    Index++;
+  }
+
+  return Limit;
+}
+
 STATIC
 EFI_STATUS
 FatSetFatEntry (
@@ -198,6 +383,16 @@ Returns:
     }
   }
   //
+  // Keep the free cluster bitmap in sync
+  //
+  if (Volume->FreeBitmap != NULL && Index <= Volume->MaxCluster + 1) {
+    if (Value == FAT_CLUSTER_FREE) {
+      FAT_BITMAP_CLEAR (Volume->FreeBitmap, Index);
+    } else {
+      FAT_BITMAP_SET (Volume->FreeBitmap, Index);
+    }
+  }
+  //
   // Make sure the entry is in memory
   //
   Pos = FatLoadFatEntry (Volume, Index);
@@ -323,6 +518,25 @@ Returns:
   if (Volume->DiskError) {
     return (UINTN) FAT_CLUSTER_LAST;
   }
+  //
+  // Search the free cluster bitmap if it can be built
+  //
+  if (Volume->FreeBitmap != NULL || !EFI_ERROR (FatBuildFreeBitmap (Volume))) {
+    Cluster = FatFindFreeCluster (Volume, Volume->FatInfoSector.FreeInfo.NextCluster);
+    if (Cluster > Volume->MaxCluster + 1) {
+      //
+      // Wrap around to the beginning of the FAT
+      //
+      Cluster = FatFindFreeCluster (Volume, FAT_MIN_CLUSTER);
+      if (Cluster > Volume->MaxCluster + 1) {
+        return (UINTN) FAT_CLUSTER_LAST;
+      }
+    }
+
+    FAT_BITMAP_SET (Volume->FreeBitmap, Cluster);
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) (Cluster + 1);
+    return Cluster;
+  }
 
   for (;;) {
     //
@@ -354,6 +568,65 @@ Returns:
   return Cluster;
 }
 
+STATIC
+UINTN
+FatAllocateClusterRun (
+  IN  FAT_VOLUME      *Volume,
+  IN  UINTN           MaxCount,
+  OUT UINTN           *RunLength
+  )
+/*++
+
+Routine Description:
+
+  Allocate a run of up to MaxCount contiguous free clusters.
+  The run starts at the next free cluster and is extended as long as
+  the following clusters are free.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  MaxCount              - The maximum number of clusters to allocate.
+  RunLength             - The number of contiguous clusters allocated.
+
+Returns:
+
+  The index of the first cluster of the run
+
+--*/
+{
+  UINTN Cluster;
+  UINTN Next;
+  UINTN Length;
+
+  *RunLength  = 0;
+  Cluster     = FatAllocateCluster (Volume);
+  if (FAT_END_OF_FAT_CHAIN (Cluster)) {
+    return Cluster;
+  }
+
+  for (Length = 1; Length < MaxCount; Length++) {
+    Next = Cluster + Length;
+    if (Next > Volume->MaxCluster + 1) {
+      break;
+    }
+
+    if (Volume->FreeBitmap != NULL) {
+      if (FAT_BITMAP_IS_SET (Volume->FreeBitmap, Next)) {
+        break;
+      }
+
+      FAT_BITMAP_SET (Volume->FreeBitmap, Next);
+    } else if (FatGetFatEntry (Volume, Next) != FAT_CLUSTER_FREE) {
+      break;
+    }
+  }
+
+  Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) (Cluster + Length);
+  *RunLength = Length;
+  return Cluster;
+}
+
 STATIC
 UINTN
 FatSizeToClusters (
@@ -387,6 +660,187 @@ Returns:
   return Clusters;
 }
 
+STATIC
+FAT_EXTENT *
+FatFindExtent (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                ClusterIndex
+  )
+/*++
+
+Routine Description:
+
+  Binary search the extent map of the open file for the extent
+  which contains the cluster of the given index within the file.
+
+Arguments:
+
+  OFile                 - The open file.
+  ClusterIndex          - The index of the cluster within the file.
+
+Returns:
+
+  The extent containing the cluster, or NULL if it is not mapped yet.
+
+--*/
+{
+  FAT_EXTENT  *Extent;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
+
+  Low   = 0;
+  High  = OFile->ExtentCount;
+  while (Low < High) {
+    Middle  = (Low + High) / 2;
+    Extent  = &OFile->Extents[Middle];
+    if (ClusterIndex < Extent->FileCluster) {
+      High = Middle;
+    } else if (ClusterIndex >= Extent->FileCluster + Extent->Length) {
+      Low = Middle + 1;
+    } else {
+      return Extent;
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+EFI_STATUS
+FatExtendExtentMap (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                ClusterIndex
+  )
+/*++
+
+Routine Description:
+
+  Run the file's cluster chain from the end of the extent map until the
+  cluster of the given index within the file is mapped.
+
+Arguments:
+
+  OFile                 - The open file.
+  ClusterIndex          - The index of the cluster within the file.
+
+Returns:
+
+  EFI_SUCCESS           - The cluster is mapped.
+  EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  EFI_OUT_OF_RESOURCES  - Not enough memory to grow the extent map.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *NewExtents;
+  UINTN       NewMaxCount;
+  UINTN       MappedCount;
+  UINTN       Cluster;
+
+  Volume = OFile->Volume;
+  if (OFile->ExtentCount == 0) {
+    MappedCount = 0;
+    Cluster     = OFile->FileCluster;
+  } else {
+    Extent      = &OFile->Extents[OFile->ExtentCount - 1];
+    MappedCount = Extent->FileCluster + Extent->Length;
+    if (ClusterIndex < MappedCount) {
+      return EFI_SUCCESS;
+    }
+
+    Cluster = FatGetFatEntry (Volume, Extent->Cluster + Extent->Length - 1);
+  }
+
+  while (MappedCount <= ClusterIndex) {
+    if (Cluster < FAT_MIN_CLUSTER || Cluster >= FAT_CLUSTER_SPECIAL) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+    //
+    // Merge the cluster into the last extent if it is contiguous,
+    // otherwise start a new extent
+    //
+    Extent = NULL;
+    if (OFile->ExtentCount != 0) {
+      Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    }
+
+    if (Extent != NULL && Extent->Cluster + Extent->Length == Cluster) {
+      Extent->Length += 1;
+    } else {
+      if (OFile->ExtentCount == OFile->ExtentMaxCount) {
+        //
+        // Double the extent map, so that mapping a fragmented file
+        // reallocates it a logarithmic number of times
+        //
+        NewMaxCount = MAX (OFile->ExtentMaxCount * 2, FAT_EXTENT_MAP_MIN_COUNT);
+        NewExtents  = ReallocatePool (
+                        OFile->ExtentMaxCount * sizeof (FAT_EXTENT),
+                        NewMaxCount * sizeof (FAT_EXTENT),
+                        OFile->Extents
+                        );
+        if (NewExtents == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+
+        OFile->Extents        = NewExtents;
+        OFile->ExtentMaxCount = NewMaxCount;
+      }
+
+      Extent              = &OFile->Extents[OFile->ExtentCount];
+      Extent->FileCluster = MappedCount;
+      Extent->Cluster     = Cluster;
+      Extent->Length      = 1;
+      OFile->ExtentCount += 1;
+    }
+
+    MappedCount += 1;
+    Cluster      = FatGetFatEntry (Volume, Cluster);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FatTruncateExtentMap (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                ClusterCount
+  )
+/*++
+
+Routine Description:
+
+  Drop the part of the extent map beyond the first ClusterCount clusters of the file.
+
+Arguments:
+
+  OFile                 - The open file.
+  ClusterCount          - The number of clusters remaining in the file.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_EXTENT  *Extent;
+
+  while (OFile->ExtentCount != 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->FileCluster < ClusterCount) {
+      if (Extent->FileCluster + Extent->Length > ClusterCount) {
+        Extent->Length = ClusterCount - Extent->FileCluster;
+      }
+
+      break;
+    }
+
+    OFile->ExtentCount -= 1;
+  }
+}
+
 EFI_STATUS
 FatShrinkEof (
   IN FAT_OFILE            *OFile
@@ -459,6 +913,7 @@ Returns:
   OFile->FileCurrentCluster = OFile->FileCluster;
   OFile->FileLastCluster    = LastCluster;
   OFile->Dirty              = TRUE;
+  FatTruncateExtentMap (OFile, NewSize);
   //
   // Free the remaining cluster chain
   //
@@ -498,6 +953,8 @@ Returns:
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  UINTN       RunLength;
+  UINTN       Index;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -554,7 +1011,7 @@ Returns:
     LastCluster = OFile->FileLastCluster;
 
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      NewCluster = FatAllocateClusterRun (Volume, NewSize - CurSize, &RunLength);
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
           FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
@@ -572,8 +1029,15 @@ Returns:
         OFile->FileCurrentCluster = NewCluster;
       }
 
-      LastCluster = NewCluster;
-      CurSize += 1;
+      //
+      // Chain the contiguous run of clusters in one pass
+      //
+      for (Index = 1; Index < RunLength; Index++) {
+        FatSetFatEntry (Volume, NewCluster + Index - 1, NewCluster + Index);
+      }
+
+      LastCluster = NewCluster + RunLength - 1;
+      CurSize    += RunLength;
     }
     //
     // Terminate the cluster list
@@ -617,14 +1081,16 @@ Returns:
 
 --*/
 {
+  EFI_STATUS  Status;
   FAT_VOLUME  *Volume;
-  UINTN       ClusterSize;
+  FAT_EXTENT  *Extent;
+  UINTN       ClusterIndex;
   UINTN       Cluster;
   UINTN       StartPos;
   UINTN       Run;
+  UINT64      ExtentRun;
 
   Volume      = OFile->Volume;
-  ClusterSize = Volume->ClusterSize;
 
   ASSERT_VOLUME_LOCKED (Volume);
 
@@ -637,37 +1103,29 @@ Returns:
     Run             = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // Look up the cluster of the position in the extent map, running the
+    // file's cluster chain to extend the map if it is not mapped yet.
     //
-    Cluster     = OFile->FileCurrentCluster;
-    StartPos    = OFile->Position;
-    if (Position < StartPos || OFile->FileCluster == Cluster) {
-      StartPos  = 0;
-      Cluster   = OFile->FileCluster;
+    ClusterIndex = Position >> Volume->ClusterAlignment;
+    Status       = FatExtendExtentMap (OFile, ClusterIndex);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+      return Status;
     }
-
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
+    //
+    // Map ahead as far as the current access may reach, so that the
+    // number of consecutive clusters can be taken from the extent map.
+    //
+    Status = FatExtendExtentMap (OFile, (UINTN) RShiftU64 ((UINT64) Position + PosLimit - 1, Volume->ClusterAlignment));
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+      return Status;
     }
 
-    if (Cluster < FAT_MIN_CLUSTER) {
-      return EFI_VOLUME_CORRUPTED;
-    }
+    Extent    = FatFindExtent (OFile, ClusterIndex);
+    ASSERT (Extent != NULL);
+    Cluster   = Extent->Cluster + (ClusterIndex - Extent->FileCluster);
+    StartPos  = ClusterIndex << Volume->ClusterAlignment;
 
     OFile->PosDisk            = Volume->FirstClusterPos +
                                 LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
@@ -676,15 +1134,11 @@ Returns:
     OFile->Position           = StartPos;
 
     //
-    // Compute the number of consecutive clusters in the file
+    // Compute the number of consecutive clusters in the file. The end of
+    // the extent may be at 4GB, which doesn't fit a 32-bit UINTN.
     //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
-      }
-    }
+    ExtentRun = LShiftU64 (Extent->FileCluster + Extent->Length, Volume->ClusterAlignment) - Position;
+    Run    = (ExtentRun > MAX_UINTN) ? MAX_UINTN : (UINTN) ExtentRun;
   }
 
   OFile->PosRem = Run;
@@ -800,14 +1254,26 @@ Returns:
 
     Volume->FreeInfoValid                        = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount  = 0;
-    for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
-      if (Volume->DiskError) {
-        break;
+    if (Volume->FreeBitmap != NULL || !EFI_ERROR (FatBuildFreeBitmap (Volume))) {
+      //
+      // Count the free clusters from the in-memory bitmap
+      //
+      for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+        if (!FAT_BITMAP_IS_SET (Volume->FreeBitmap, Index)) {
+          Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+          Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
+        }
       }
+    } else {
+      for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+        if (Volume->DiskError) {
+          break;
+        }
 
-      if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
-        Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
-        Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
+        if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
+          Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+          Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
+        }
       }
     }
 
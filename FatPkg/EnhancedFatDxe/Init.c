@@ -75,6 +75,7 @@ Returns:
   Volume->VolumeInterface.OpenVolume  = FatOpenVolume;
   InitializeListHead (&Volume->CheckRef);
   InitializeListHead (&Volume->DirCacheList);
+  InitializeListHead (&Volume->ReadAheads);
   //
   // Initialize Root Directory entry
   //
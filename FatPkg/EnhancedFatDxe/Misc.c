@@ -162,7 +162,11 @@ Returns:
 {
   EFI_STATUS          Status;
   LIST_ENTRY          *Link;
+  LIST_ENTRY          *NextLink;
   FAT_SUBTASK         *Subtask;
+  FAT_VOLUME          *Volume;
+
+  Volume = IFile->OFile->Volume;
 
   //
   // Sometimes the Task doesn't contain any subtasks, signal the event directly.
@@ -179,13 +183,27 @@ Returns:
   EfiReleaseLock (&FatTaskLock);
 
   Status = EFI_SUCCESS;
+  //
+  // A subtask may complete before its submission returns, and its callback
+  // then frees it, and the task with its last subtask. So the next link is
+  // fetched before submitting, and the list is not walked with the list
+  // APIs, which validate the whole list.
+  //
   for ( Link = GetFirstNode (&Task->Subtasks)
-      ; !IsNull (&Task->Subtasks, Link)
-      ; Link = GetNextNode (&Task->Subtasks, Link)
+      ; Link != &Task->Subtasks
+      ; Link = NextLink
       ) {
-    Subtask = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
+    NextLink = Link->ForwardLink;
+    Subtask  = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
     if (Subtask->Write) {
-      
+      //
+      // No read ahead is started while a write is in flight, the read
+      // could be served by the device before the write
+      //
+      EfiAcquireLock (&FatTaskLock);
+      Volume->PendingWrites++;
+      EfiReleaseLock (&FatTaskLock);
+
       Status = IFile->OFile->Volume->DiskIo2->WriteDiskEx (
                                                 IFile->OFile->Volume->DiskIo2,
                                                 IFile->OFile->Volume->MediaId,
@@ -194,6 +212,11 @@ Returns:
                                                 Subtask->BufferSize,
                                                 Subtask->Buffer
                                                 );
+      if (EFI_ERROR (Status)) {
+        EfiAcquireLock (&FatTaskLock);
+        Volume->PendingWrites--;
+        EfiReleaseLock (&FatTaskLock);
+      }
     } else {
       Status = IFile->OFile->Volume->DiskIo2->ReadDiskEx (
                                                 IFile->OFile->Volume->DiskIo2,
@@ -316,6 +339,10 @@ Arguments:
   ASSERT (Task->Signature    == FAT_TASK_SIGNATURE);
   ASSERT (Subtask->Signature == FAT_SUBTASK_SIGNATURE);
 
+  if (Subtask->Write) {
+    Task->IFile->OFile->Volume->PendingWrites--;
+  }
+
   //
   // Remove the task unconditionally
   //
@@ -376,6 +403,8 @@ Returns:
   EFI_DISK_IO_PROTOCOL  *DiskIo;
   EFI_DISK_READ         IoFunction;
   FAT_SUBTASK           *Subtask;
+  UINTN                 SubtaskSize;
+  UINTN                 Length;
 
   //
   // Verify the IO is in devices range
@@ -400,30 +429,45 @@ Returns:
         Status      = IoFunction (DiskIo, Volume->MediaId, Offset, BufferSize, Buffer);
       } else {
         //
-        // Non-blocking access
+        // Non-blocking access.
+        // Split a large transfer into several subtasks so that the device
+        // can work on several requests of the same transfer concurrently.
         //
-        Subtask = AllocateZeroPool (sizeof (*Subtask));
-        if (Subtask == NULL) {
-          Status        = EFI_OUT_OF_RESOURCES;
-        } else {
-          Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
-          Subtask->Task       = Task;
-          Subtask->Write      = (BOOLEAN) (IoMode == WRITE_DISK);
-          Subtask->Offset     = Offset;
-          Subtask->Buffer     = Buffer;
-          Subtask->BufferSize = BufferSize;
-          Status = gBS->CreateEvent (
-                          EVT_NOTIFY_SIGNAL,
-                          TPL_NOTIFY,
-                          FatOnAccessComplete,
-                          Subtask,
-                          &Subtask->DiskIo2Token.Event
-                          );
-          if (!EFI_ERROR (Status)) {
-            InsertTailList (&Task->Subtasks, &Subtask->Link);
+        SubtaskSize = BufferSize;
+        if (BufferSize > FAT_SUBTASK_MIN_SIZE) {
+          SubtaskSize = ALIGN_VALUE ((BufferSize + FAT_SUBTASK_MAX_COUNT - 1) / FAT_SUBTASK_MAX_COUNT, FAT_SUBTASK_MIN_SIZE);
+        }
+
+        Status = EFI_SUCCESS;
+        while (BufferSize > 0 && !EFI_ERROR (Status)) {
+          Length  = MIN (SubtaskSize, BufferSize);
+          Subtask = AllocateZeroPool (sizeof (*Subtask));
+          if (Subtask == NULL) {
+            Status        = EFI_OUT_OF_RESOURCES;
           } else {
-            FreePool (Subtask);
+            Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
+            Subtask->Task       = Task;
+            Subtask->Write      = (BOOLEAN) (IoMode == WRITE_DISK);
+            Subtask->Offset     = Offset;
+            Subtask->Buffer     = Buffer;
+            Subtask->BufferSize = Length;
+            Status = gBS->CreateEvent (
+                            EVT_NOTIFY_SIGNAL,
+                            TPL_NOTIFY,
+                            FatOnAccessComplete,
+                            Subtask,
+                            &Subtask->DiskIo2Token.Event
+                            );
+            if (!EFI_ERROR (Status)) {
+              InsertTailList (&Task->Subtasks, &Subtask->Link);
+            } else {
+              FreePool (Subtask);
+            }
           }
+
+          Offset     += Length;
+          Buffer      = (UINT8 *) Buffer + Length;
+          BufferSize -= Length;
         }
       }
     }
@@ -557,12 +601,19 @@ Returns:
 --*/
 {
   //
-  // Free disk cache
+  // Free disk cache, after the read aheads filling it are done
   //
+  FatWaitReadAhead (Volume);
   if (Volume->CacheBuffer != NULL) {
     FreePool (Volume->CacheBuffer);
   }
   //
+  // Free the free cluster bitmap
+  //
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
+  }
+  //
   // Free directory cache
   //
   FatCleanupODirCache (Volume);
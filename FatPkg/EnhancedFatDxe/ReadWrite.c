@@ -531,9 +531,11 @@ Returns:
   UINTN       Len;
   EFI_STATUS  Status;
   UINTN       BufferSize;
+  UINTN       StartPosition;
 
-  BufferSize  = *DataBufferSize;
-  Volume      = OFile->Volume;
+  BufferSize    = *DataBufferSize;
+  StartPosition = Position;
+  Volume        = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
 
   Status = EFI_SUCCESS;
@@ -572,6 +574,22 @@ Returns:
     //
     ASSERT (Position <= OFile->FileSize);
   }
+
+  if (IoMode == READ_DATA && !EFI_ERROR (Status)) {
+    //
+    // Read ahead the data following a sequential read into the data cache
+    //
+    if (StartPosition == OFile->ReadEnd && Position < OFile->FileSize) {
+      Len = MIN (
+              OFile->FileSize - Position,
+              FAT_READ_AHEAD_PAGE_COUNT << Volume->DiskCache[CACHE_DATA].PageAlignment
+              );
+      if (!EFI_ERROR (FatOFilePosition (OFile, Position, Len))) {
+        FatReadAhead (Volume, OFile->PosDisk, MIN (Len, OFile->PosRem));
+      }
+    }
+    OFile->ReadEnd = Position;
+  }
   //
   // Update the number of bytes accessed
   //
@@ -1089,6 +1089,399 @@ Exit:
   return Status;
 }
 
+/**
+  Start a native command queuing (FPDMA QUEUED) data transfer on specific port.
+
+  The command takes a free command slot with its own command table, so up to
+  NcqMaxSlots commands (limited by the queue depth of the device) can be
+  outstanding on the port. The slot number is used as the queue tag. The HBA
+  clears the slot in PxSACT when the device reports its completion.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of non data transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_DEVICE_ERROR    The queued data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_NOT_READY       The command is queued or no command slot is free,
+                              only returned in non-blocking mode.
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can't be mapped for the transfer.
+  @retval EFI_SUCCESS         The queued data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciFpdmaTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS           *AhciRegisters,
+  IN     UINT8                        Port,
+  IN     UINT8                        PortMultiplier,
+  IN     BOOLEAN                      Read,
+  IN     EFI_ATA_COMMAND_BLOCK        *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK         *AtaStatusBlock,
+  IN OUT VOID                         *MemoryAddr,
+  IN     UINT32                       DataCount,
+  IN     UINT64                       Timeout,
+  IN     ATA_NONBLOCK_TASK            *Task
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PCI_IO_PROTOCOL           *PciIo;
+  EFI_PHYSICAL_ADDRESS          PhyAddr;
+  VOID                          *Map;
+  UINTN                         MapLength;
+  EFI_PCI_IO_PROTOCOL_OPERATION Flag;
+  EFI_AHCI_COMMAND_FIS          CFis;
+  EFI_AHCI_COMMAND_LIST         *CmdList;
+  EFI_AHCI_NCQ_COMMAND_TABLE    *CmdTable;
+  DATA_64                       Data64;
+  UINT32                        PrdtNumber;
+  UINT32                        PrdtIndex;
+  UINTN                         RemainedData;
+  UINT64                        MemAddr;
+  UINT32                        Offset;
+  UINT32                        SlotBit;
+  UINT32                        QueueDepth;
+  INTN                          Slot;
+  UINT64                        Delay;
+  EFI_TPL                       OldTpl;
+
+  PciIo = Instance->PciIo;
+  Map   = NULL;
+
+  if (Task == NULL) {
+    //
+    // Before starting the Blocking BlockIO operation, push to finish all non-blocking
+    // BlockIO tasks.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    while (!IsListEmpty (&Instance->NonBlockingTaskList)) {
+      AsyncNonBlockingTransferRoutine (NULL, Instance);
+      //
+      // Stall for 100us.
+      //
+      MicroSecondDelay (100);
+    }
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if ((Task == NULL) || !Task->IsStart) {
+    //
+    // The queued commands of another port have to complete first.
+    //
+    if ((Instance->NcqSlotBitMap != 0) && (Instance->NcqPort != Port)) {
+      return EFI_NOT_READY;
+    }
+
+    QueueDepth = Instance->NcqMaxSlots;
+    if ((Task != NULL) && (Task->QueueDepth < QueueDepth)) {
+      QueueDepth = Task->QueueDepth;
+    }
+
+    Slot = LowBitSet32 (~Instance->NcqSlotBitMap);
+    if ((Slot < 0) || ((UINT32) Slot >= QueueDepth)) {
+      return EFI_NOT_READY;
+    }
+
+    PrdtNumber = (UINT32)DivU64x32 (((UINT64)DataCount + EFI_AHCI_MAX_DATA_PER_PRDT - 1), EFI_AHCI_MAX_DATA_PER_PRDT);
+    if ((PrdtNumber == 0) || (PrdtNumber > EFI_AHCI_NCQ_MAX_PRDT)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (Read) {
+      Flag = EfiPciIoOperationBusMasterWrite;
+    } else {
+      Flag = EfiPciIoOperationBusMasterRead;
+    }
+
+    MapLength = DataCount;
+    Status = PciIo->Map (
+                      PciIo,
+                      Flag,
+                      MemoryAddr,
+                      &MapLength,
+                      &PhyAddr,
+                      &Map
+                      );
+
+    if (EFI_ERROR (Status) || (DataCount != MapLength)) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    //
+    // The queue tag is carried in bits 7:3 of the sector count field, the
+    // sector count itself is in the feature fields.
+    //
+    AhciBuildCommandFis (&CFis, AtaCommandBlock);
+    CFis.AhciCFisPmNum    = PortMultiplier;
+    CFis.AhciCFisSecCount = (UINT8) (Slot << 3);
+    CFis.AhciCFisDevHead  = (UINT8) (AtaCommandBlock->AtaDeviceHead | BIT6);
+
+    CmdTable = AhciRegisters->AhciNcqCommandTable + Slot;
+    ZeroMem (CmdTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+    CopyMem (&CmdTable->CommandFis, &CFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+    RemainedData = (UINTN) DataCount;
+    MemAddr      = PhyAddr;
+    for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+      if (RemainedData < EFI_AHCI_MAX_DATA_PER_PRDT) {
+        CmdTable->PrdtTable[PrdtIndex].AhciPrdtDbc = (UINT32)RemainedData - 1;
+      } else {
+        CmdTable->PrdtTable[PrdtIndex].AhciPrdtDbc = EFI_AHCI_MAX_DATA_PER_PRDT - 1;
+      }
+
+      Data64.Uint64 = MemAddr;
+      CmdTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+      CmdTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+      RemainedData -= EFI_AHCI_MAX_DATA_PER_PRDT;
+      MemAddr      += EFI_AHCI_MAX_DATA_PER_PRDT;
+    }
+    CmdTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
+
+    CmdList = AhciRegisters->AhciCmdList + Slot;
+    ZeroMem (CmdList, sizeof (EFI_AHCI_COMMAND_LIST));
+    CmdList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+    CmdList->AhciCmdW     = Read ? 0 : 1;
+    CmdList->AhciCmdPmp   = PortMultiplier;
+    CmdList->AhciCmdPrdtl = PrdtNumber;
+
+    Data64.Uint64 = (UINT64)(UINTN) (AhciRegisters->AhciNcqCommandTablePciAddr + Slot);
+    CmdList->AhciCmdCtba  = Data64.Uint32.Lower32;
+    CmdList->AhciCmdCtbau = Data64.Uint32.Upper32;
+
+    //
+    // The first queued command starts the port, the following ones are
+    // added while it is running.
+    //
+    if (Instance->NcqSlotBitMap == 0) {
+      Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+      AhciAndReg (PciIo, Offset, (UINT32)~(EFI_AHCI_PORT_CMD_DLAE | EFI_AHCI_PORT_CMD_ATAPI));
+
+      Status = AhciStartPort (PciIo, Port, Timeout);
+      if (EFI_ERROR (Status)) {
+        AhciStopCommand (PciIo, Port, Timeout);
+        AhciDisableFisReceive (PciIo, Port, Timeout);
+        PciIo->Unmap (PciIo, Map);
+        return Status;
+      }
+    }
+
+    SlotBit = (UINT32) (1 << Slot);
+    Instance->NcqSlotBitMap |= SlotBit;
+    Instance->NcqPort        = Port;
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWriteReg (PciIo, Offset, SlotBit);
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+    AhciWriteReg (PciIo, Offset, SlotBit);
+
+    if (Task != NULL) {
+      Task->IsStart = TRUE;
+      Task->Slot    = (UINT8) Slot;
+      Task->Map     = Map;
+      return EFI_NOT_READY;
+    }
+  } else {
+    Slot = Task->Slot;
+  }
+
+  //
+  // Wait for command compelte. A failing queued command sets PxIS.TFES and
+  // keeps its slot set in PxSACT.
+  //
+  SlotBit = (UINT32) (1 << Slot);
+  Delay   = DivU64x32 (Timeout, 1000) + 1;
+  while (TRUE) {
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+    if ((AhciReadReg (PciIo, Offset) & (EFI_AHCI_PORT_IS_TFES | EFI_AHCI_PORT_IS_HBFS | EFI_AHCI_PORT_IS_HBDS | EFI_AHCI_PORT_IS_IFS)) != 0) {
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    if ((AhciReadReg (PciIo, Offset) & SlotBit) == 0) {
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    if (Task != NULL) {
+      Task->RetryTimes--;
+      if (!Task->InfiniteWait && (Task->RetryTimes == 0)) {
+        Status = EFI_TIMEOUT;
+      } else {
+        Status = EFI_NOT_READY;
+      }
+      break;
+    }
+
+    if ((Timeout != 0) && (--Delay == 0)) {
+      Status = EFI_TIMEOUT;
+      break;
+    }
+
+    //
+    // Stall for 100 microseconds.
+    //
+    MicroSecondDelay (100);
+  }
+
+  if (Status == EFI_NOT_READY) {
+    return Status;
+  }
+
+  AhciDumpPortStatus (PciIo, Port, AtaStatusBlock);
+
+  if (!EFI_ERROR (Status)) {
+    Instance->NcqSlotBitMap &= ~SlotBit;
+
+    PciIo->Unmap (
+             PciIo,
+             (Task != NULL) ? Task->Map : Map
+             );
+    if (Task != NULL) {
+      Task->Map = NULL;
+    }
+
+    if (Instance->NcqSlotBitMap == 0) {
+      AhciStopCommand (
+        PciIo,
+        Port,
+        Timeout
+        );
+
+      AhciDisableFisReceive (
+        PciIo,
+        Port,
+        Timeout
+        );
+    }
+  } else {
+    //
+    // The device aborts all its queued commands when one of them fails, so
+    // all of them are terminated. AhciNcqAbort() fails the other non-blocking
+    // tasks which own a queued command, this one is completed by the caller.
+    //
+    if (Map != NULL) {
+      PciIo->Unmap (PciIo, Map);
+    }
+    AhciNcqAbort (Instance, Task, TRUE);
+    AhciNcqRecover (Instance, Port, PortMultiplier);
+  }
+
+  return Status;
+}
+
+/**
+  Abort all native command queuing commands outstanding on the controller.
+
+  Stopping the port clears all its outstanding commands. The data buffers of
+  the non-blocking tasks which own a queued command are unmapped. These tasks
+  can't complete any more, so they are removed from the task list and freed,
+  with their event signaled as a device error if IsSigEvent is TRUE.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Task              Optional. The non-blocking task which failed. It
+                                is unmapped but left to the caller to complete.
+  @param[in]  IsSigEvent        Indicate whether signal the event of the aborted
+                                tasks.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbort (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance,
+  IN ATA_NONBLOCK_TASK                *Task       OPTIONAL,
+  IN BOOLEAN                          IsSigEvent
+  )
+{
+  EFI_PCI_IO_PROTOCOL           *PciIo;
+  LIST_ENTRY                    *Entry;
+  LIST_ENTRY                    *NextEntry;
+  ATA_NONBLOCK_TASK             *Aborted;
+  EFI_TPL                       OldTpl;
+
+  if (Instance->NcqSlotBitMap == 0) {
+    return;
+  }
+
+  PciIo = Instance->PciIo;
+
+  AhciStopCommand (PciIo, Instance->NcqPort, ATA_ATAPI_TIMEOUT);
+  AhciDisableFisReceive (PciIo, Instance->NcqPort, ATA_ATAPI_TIMEOUT);
+
+  //
+  // The asynchronous timer works on the task list at TPL_NOTIFY.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  for (Entry = GetFirstNode (&Instance->NonBlockingTaskList);
+       !IsNull (&Instance->NonBlockingTaskList, Entry);
+       Entry = NextEntry) {
+    NextEntry = GetNextNode (&Instance->NonBlockingTaskList, Entry);
+    Aborted   = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if (!Aborted->IsStart ||
+        (Aborted->Packet->Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+      continue;
+    }
+
+    if (Aborted->Map != NULL) {
+      PciIo->Unmap (PciIo, Aborted->Map);
+      Aborted->Map = NULL;
+    }
+
+    if (Aborted == Task) {
+      continue;
+    }
+
+    RemoveEntryList (&Aborted->Link);
+    if (IsSigEvent) {
+      Aborted->Packet->Asb->AtaStatus = 0x01;
+      gBS->SignalEvent (Aborted->Event);
+    }
+    FreePool (Aborted);
+  }
+
+  Instance->NcqSlotBitMap = 0;
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Wait until no native command queuing command is outstanding.
+
+  A blocking command reuses the command list and slot 0, so it can't be
+  started while queued commands are in flight. The non-blocking tasks are
+  driven here until the queued commands complete.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+**/
+VOID
+EFIAPI
+AhciWaitNcqIdle (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance
+  )
+{
+  EFI_TPL                       OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (Instance->NcqSlotBitMap != 0) {
+    AsyncNonBlockingTransferRoutine (NULL, Instance);
+    //
+    // Stall for 100us.
+    //
+    MicroSecondDelay (100);
+  }
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   Start a non data transfer on specific port.
 
@@ -1250,28 +1643,25 @@ AhciStopCommand (
 }
 
 /**
-  Start command for give slot on specific port.
+  Start the command processing of the specific port without issuing a command.
 
   @param  PciIo              The PCI IO protocol instance.
   @param  Port               The number of port.
-  @param  CommandSlot        The number of Command Slot.
   @param  Timeout            The timeout value of start, uses 100ns as a unit.
 
-  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_DEVICE_ERROR   The port start unsuccessfully.
   @retval EFI_TIMEOUT        The operation is time out.
-  @retval EFI_SUCCESS        The command start successfully.
+  @retval EFI_SUCCESS        The port start successfully.
 
 **/
 EFI_STATUS
 EFIAPI
-AhciStartCommand (
+AhciStartPort (
   IN  EFI_PCI_IO_PROTOCOL       *PciIo,
   IN  UINT8                     Port,
-  IN  UINT8                     CommandSlot,
   IN  UINT64                    Timeout
   )
 {
-  UINT32     CmdSlotBit;
   EFI_STATUS Status;
   UINT32     PortStatus;
   UINT32     StartCmd;
@@ -1284,8 +1674,6 @@ AhciStartCommand (
   //
   Capability = AhciReadReg(PciIo, EFI_AHCI_CAPABILITY_OFFSET);
 
-  CmdSlotBit = (UINT32) (1 << CommandSlot);
-
   AhciClearPortStatus (
     PciIo,
     Port
@@ -1332,6 +1720,42 @@ AhciStartCommand (
   Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
   AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_ST | StartCmd);
 
+  return EFI_SUCCESS;
+}
+
+/**
+  Start command for give slot on specific port.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  Port               The number of port.
+  @param  CommandSlot        The number of Command Slot.
+  @param  Timeout            The timeout value of start, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_TIMEOUT        The operation is time out.
+  @retval EFI_SUCCESS        The command start successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciStartCommand (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  UINT8                     Port,
+  IN  UINT8                     CommandSlot,
+  IN  UINT64                    Timeout
+  )
+{
+  UINT32     CmdSlotBit;
+  EFI_STATUS Status;
+  UINT32     Offset;
+
+  CmdSlotBit = (UINT32) (1 << CommandSlot);
+
+  Status = AhciStartPort (PciIo, Port, Timeout);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   //
   // Setting the command
   //
@@ -1412,6 +1836,75 @@ AhciPortReset (
   return EFI_SUCCESS;
 }
 
+/**
+  Recover a port from a native command queuing error.
+
+  After a queued command fails, the device rejects further commands until the
+  NCQ Command Error log (log page 10h) is read. The port is restarted to issue
+  READ LOG EXT for the log, which also reports the tag of the failed command.
+  If the log can't be read, the port is reset with COMRESET.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port              The number of port.
+  @param[in]  PortMultiplier    The number of port multiplier.
+
+**/
+VOID
+EFIAPI
+AhciNcqRecover (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance,
+  IN UINT8                            Port,
+  IN UINT8                            PortMultiplier
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_ATA_COMMAND_BLOCK         AtaCommandBlock;
+  EFI_ATA_STATUS_BLOCK          AtaStatusBlock;
+  UINT8                         Log[EFI_AHCI_NCQ_ERROR_LOG_SIZE];
+
+  ZeroMem (&AtaCommandBlock, sizeof (EFI_ATA_COMMAND_BLOCK));
+  ZeroMem (&AtaStatusBlock, sizeof (EFI_ATA_STATUS_BLOCK));
+  ZeroMem (Log, sizeof (Log));
+
+  AtaCommandBlock.AtaCommand      = ATA_CMD_READ_LOG_EXT;
+  AtaCommandBlock.AtaSectorCount  = 1;
+  AtaCommandBlock.AtaSectorNumber = EFI_AHCI_NCQ_ERROR_LOG_ADDRESS;
+
+  //
+  // AhciPioTransfer() clears the error status and restarts the port before
+  // it issues the command, and stops the port again when it's done.
+  //
+  Status = AhciPioTransfer (
+             Instance->PciIo,
+             &Instance->AhciRegisters,
+             Port,
+             PortMultiplier,
+             NULL,
+             0,
+             TRUE,
+             &AtaCommandBlock,
+             &AtaStatusBlock,
+             Log,
+             sizeof (Log),
+             ATA_ATAPI_TIMEOUT,
+             NULL
+             );
+  if (!EFI_ERROR (Status) && ((Log[0] & EFI_AHCI_NCQ_ERROR_LOG_NQ) == 0)) {
+    DEBUG ((
+      EFI_D_ERROR,
+      "AhciNcqRecover: port %d tag %d failed, status 0x%x error 0x%x\n",
+      Port,
+      Log[0] & EFI_AHCI_NCQ_ERROR_LOG_TAG_MASK,
+      Log[2],
+      Log[3]
+      ));
+    return;
+  }
+
+  DEBUG ((EFI_D_ERROR, "AhciNcqRecover: port %d NCQ error log unavailable (%r), resetting\n", Port, Status));
+  AhciPortReset (Instance->PciIo, Port, ATA_ATAPI_TIMEOUT);
+}
+
 /**
   Do AHCI HBA reset.
 
@@ -2201,6 +2694,97 @@ Error6:
   return Status;
 }
 
+/**
+  Allocate the command tables of the native command queuing slots.
+
+  Each command slot gets its own command table with EFI_AHCI_NCQ_MAX_PRDT
+  PRDT entries, so that queued commands can be outstanding in all slots.
+
+  @param  PciIo                 The PCI IO protocol instance.
+  @param  AhciRegisters         The pointer to the EFI_AHCI_REGISTERS.
+  @param  MaxCommandSlotNumber  The number of command slots of the HBA.
+
+  @retval EFI_OUT_OF_RESOURCES  The command tables can't be allocated.
+  @retval EFI_DEVICE_ERROR      The command tables are above 4G and the HBA
+                                doesn't support 64-bit addressing.
+  @retval EFI_SUCCESS           The command tables are allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciCreateNcqCommandTables (
+  IN     EFI_PCI_IO_PROTOCOL    *PciIo,
+  IN OUT EFI_AHCI_REGISTERS     *AhciRegisters,
+  IN     UINT8                  MaxCommandSlotNumber
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Bytes;
+  VOID                  *Buffer;
+  UINT32                Capability;
+  UINT64                MaxNcqCommandTableSize;
+  EFI_PHYSICAL_ADDRESS  AhciNcqCommandTablePciAddr;
+
+  Capability             = AhciReadReg (PciIo, EFI_AHCI_CAPABILITY_OFFSET);
+  MaxNcqCommandTableSize = MaxCommandSlotNumber * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+
+  Buffer = NULL;
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+                    &Buffer,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Buffer, (UINTN)MaxNcqCommandTableSize);
+
+  Bytes  = (UINTN)MaxNcqCommandTableSize;
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Buffer,
+                    &Bytes,
+                    &AhciNcqCommandTablePciAddr,
+                    &AhciRegisters->MapNcqCommandTable
+                    );
+  if (EFI_ERROR (Status) || (Bytes != MaxNcqCommandTableSize)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error2;
+  }
+
+  if (((Capability & EFI_AHCI_CAP_S64A) == 0) && (AhciNcqCommandTablePciAddr > 0x100000000ULL)) {
+    //
+    // The AHCI HBA doesn't support 64bit addressing, so should not get a >4G pci bus master address.
+    //
+    Status = EFI_DEVICE_ERROR;
+    goto Error1;
+  }
+
+  AhciRegisters->AhciNcqCommandTable        = Buffer;
+  AhciRegisters->AhciNcqCommandTablePciAddr = (EFI_AHCI_NCQ_COMMAND_TABLE *)(UINTN)AhciNcqCommandTablePciAddr;
+  AhciRegisters->MaxNcqCommandTableSize     = MaxNcqCommandTableSize;
+  return EFI_SUCCESS;
+
+Error1:
+  PciIo->Unmap (
+           PciIo,
+           AhciRegisters->MapNcqCommandTable
+           );
+Error2:
+  PciIo->FreeBuffer (
+           PciIo,
+           EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+           Buffer
+           );
+  AhciRegisters->MapNcqCommandTable = NULL;
+  return Status;
+}
+
 /**
   Initialize ATA host controller at AHCI mode.
 
@@ -2295,6 +2879,25 @@ AhciModeInitialization (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Native command queuing is optional, the queued commands are rejected
+  // if it's disabled by PcdAtaNcqEnable or the command tables of the slots
+  // can't be allocated.
+  //
+  Instance->NcqMaxSlots = 0;
+  if (FeaturePcdGet (PcdAtaNcqEnable) && ((Capability & EFI_AHCI_CAP_SNCQ) != 0)) {
+    Status = AhciCreateNcqCommandTables (
+               PciIo,
+               AhciRegisters,
+               (UINT8) (((Capability & 0x1F00) >> 8) + 1)
+               );
+    if (!EFI_ERROR (Status)) {
+      Instance->NcqMaxSlots = (UINT8) (((Capability & 0x1F00) >> 8) + 1);
+    } else {
+      DEBUG ((EFI_D_WARN, "AhciModeInitialization: native command queuing disabled (%r)\n", Status));
+    }
+  }
+
   for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port ++) {
     if ((PortImplementBitMap & (BIT0 << Port)) != 0) {
       //
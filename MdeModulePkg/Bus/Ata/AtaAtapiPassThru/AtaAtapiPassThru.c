@@ -280,6 +280,11 @@ AtaPassThruPassThruExecute (
         //
         PortMultiplierPort = 0;
       }
+
+      if ((Task == NULL) && (Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+        AhciWaitNcqIdle (Instance);
+      }
+
       switch (Protocol) {
         case EFI_ATA_PASS_THRU_PROTOCOL_ATA_NON_DATA:
           Status = AhciNonDataTransfer (
@@ -363,6 +368,37 @@ AtaPassThruPassThruExecute (
                      Task
                      );
           break;
+        case EFI_ATA_PASS_THRU_PROTOCOL_FPDMA:
+          if (Packet->InTransferLength != 0) {
+            Status = AhciFpdmaTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       TRUE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->InDataBuffer,
+                       Packet->InTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          } else {
+            Status = AhciFpdmaTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       FALSE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->OutDataBuffer,
+                       Packet->OutTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          }
+          break;
         default :
           return EFI_UNSUPPORTED;
       }
@@ -392,23 +428,33 @@ AsyncNonBlockingTransferRoutine (
   )
 {
   LIST_ENTRY                   *Entry;
+  LIST_ENTRY                   *NextEntry;
   LIST_ENTRY                   *EntryHeader;
   ATA_NONBLOCK_TASK            *Task;
   EFI_STATUS                   Status;
   ATA_ATAPI_PASS_THRU_INSTANCE *Instance;
+  BOOLEAN                      IsQueued;
 
   Instance   = (ATA_ATAPI_PASS_THRU_INSTANCE *) Context;
   EntryHeader = &Instance->NonBlockingTaskList;
   //
   // Get the Taks from the Taks List and execute it, until there is
   // no task in the list or the device is busy with task (EFI_NOT_READY).
+  // A queued (FPDMA) command in flight doesn't hold back the queued commands
+  // behind it, so one pass both reaps the completed slots and fills the
+  // free ones.
   //
-  while (TRUE) {
-    if (!IsListEmpty (EntryHeader)) {
-      Entry = GetFirstNode (EntryHeader);
-      Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
-    } else {
-      return;
+  Entry = GetFirstNode (EntryHeader);
+  while (!IsNull (EntryHeader, Entry)) {
+    Task      = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    NextEntry = GetNextNode (EntryHeader, Entry);
+    IsQueued  = (BOOLEAN) (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA);
+
+    //
+    // Other commands can't be started while queued commands are outstanding.
+    //
+    if (!IsQueued && (Instance->NcqSlotBitMap != 0)) {
+      break;
     }
 
     Status = AtaPassThruPassThruExecute (
@@ -433,12 +479,18 @@ AsyncNonBlockingTransferRoutine (
     // is not finished yet. Otherwise the operation is successful.
     //
     if (Status == EFI_NOT_READY) {
+      if (IsQueued && Task->IsStart) {
+        Entry = NextEntry;
+        continue;
+      }
       break;
     } else {
       RemoveEntryList (&Task->Link);
       gBS->SignalEvent (Task->Event);
       FreePool (Task);
     }
+
+    Entry = NextEntry;
   }
 }
 
@@ -920,6 +972,17 @@ AtaAtapiPassThruStop (
 
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    if (AhciRegisters->AhciNcqCommandTable != NULL) {
+      PciIo->Unmap (
+               PciIo,
+               AhciRegisters->MapNcqCommandTable
+               );
+      PciIo->FreeBuffer (
+               PciIo,
+               EFI_SIZE_TO_PAGES ((UINTN) AhciRegisters->MaxNcqCommandTableSize),
+               AhciRegisters->AhciNcqCommandTable
+               );
+    }
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
@@ -1137,6 +1200,11 @@ DestroyAsynTaskList (
   EFI_TPL              OldTpl;
 
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  //
+  // Terminate the queued commands still outstanding in the controller.
+  //
+  AhciNcqAbort (Instance, NULL, IsSigEvent);
+
   if (!IsListEmpty (&Instance->NonBlockingTaskList)) {
     //
     // Free the Subtask list.
@@ -1355,6 +1423,16 @@ AtaPassThruPassThru (
     return EFI_BAD_BUFFER_SIZE;
   }
 
+  //
+  // Queued commands need native command queuing support in both the AHCI
+  // controller and the device.
+  //
+  if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) &&
+      ((Instance->Mode != EfiAtaAhciMode) || (Instance->NcqMaxSlots == 0) ||
+       ((IdentifyData->AtaData.serial_ata_capabilities & BIT8) == 0))) {
+    return EFI_UNSUPPORTED;
+  }
+
   //
   // For non-blocking mode, queue the Task into the list.
   //
@@ -1371,6 +1449,7 @@ AtaPassThruPassThru (
     Task->Event          = Event;
     Task->IsStart        = FALSE;
     Task->RetryTimes     = DivU64x32(Packet->Timeout, 1000) + 1;
+    Task->QueueDepth     = (UINT8) ((IdentifyData->AtaData.queue_depth & 0x1F) + 1);
     if (Packet->Timeout == 0) {
       Task->InfiniteWait = TRUE;
     } else {
@@ -2086,6 +2165,7 @@ ExtScsiPassThruPassThru (
         //
         PortMultiplier = 0;
       }
+      AhciWaitNcqIdle (Instance);
       Status = AhciPacketCommandExecute (Instance->PciIo, &Instance->AhciRegisters, Port, PortMultiplier, Packet);
       break;
     default :
@@ -120,6 +120,14 @@ typedef struct {
   //
   EFI_EVENT                         TimerEvent;
   LIST_ENTRY                        NonBlockingTaskList;
+
+  //
+  // For native command queuing. All ports share the command list, so only
+  // the queued commands of one port can be outstanding at a time.
+  //
+  UINT8                             NcqMaxSlots;
+  UINT8                             NcqPort;
+  UINT32                            NcqSlotBitMap;
 } ATA_ATAPI_PASS_THRU_INSTANCE;
 
 //
@@ -140,6 +148,8 @@ struct _ATA_NONBLOCK_TASK {
   VOID                              *TableMap;       // Pointer to PRD table map.
   EFI_ATA_DMA_PRD                   *MapBaseAddress; //  Pointer to range Base address for Map.
   UINTN                             PageCount;       //  The page numbers used by PCIO freebuffer.
+  UINT8                             Slot;            //  The command slot of a queued command.
+  UINT8                             QueueDepth;      //  The queue depth of the device.
 };
 
 //
@@ -1150,6 +1160,95 @@ AhciDmaTransfer (
   IN     ATA_NONBLOCK_TASK            *Task
   );
 
+/**
+  Start a native command queuing (FPDMA QUEUED) data transfer on specific port.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of non data transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_DEVICE_ERROR    The queued data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_NOT_READY       The command is queued or no command slot is free,
+                              only returned in non-blocking mode.
+  @retval EFI_BAD_BUFFER_SIZE The data buffer can't be mapped for the transfer.
+  @retval EFI_SUCCESS         The queued data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciFpdmaTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS           *AhciRegisters,
+  IN     UINT8                        Port,
+  IN     UINT8                        PortMultiplier,
+  IN     BOOLEAN                      Read,
+  IN     EFI_ATA_COMMAND_BLOCK        *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK         *AtaStatusBlock,
+  IN OUT VOID                         *MemoryAddr,
+  IN     UINT32                       DataCount,
+  IN     UINT64                       Timeout,
+  IN     ATA_NONBLOCK_TASK            *Task
+  );
+
+/**
+  Abort all native command queuing commands outstanding on the controller.
+
+  The non-blocking tasks which own a queued command are removed from the task
+  list and freed, except Task.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Task              Optional. The non-blocking task which failed. It
+                                is unmapped but left to the caller to complete.
+  @param[in]  IsSigEvent        Indicate whether signal the event of the aborted
+                                tasks.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbort (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance,
+  IN ATA_NONBLOCK_TASK                *Task       OPTIONAL,
+  IN BOOLEAN                          IsSigEvent
+  );
+
+/**
+  Recover a port from a native command queuing error.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port              The number of port.
+  @param[in]  PortMultiplier    The number of port multiplier.
+
+**/
+VOID
+EFIAPI
+AhciNcqRecover (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance,
+  IN UINT8                            Port,
+  IN UINT8                            PortMultiplier
+  );
+
+/**
+  Wait until no native command queuing command is outstanding.
+
+  @param[in]  Instance          A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+**/
+VOID
+EFIAPI
+AhciWaitNcqIdle (
+  IN ATA_ATAPI_PASS_THRU_INSTANCE     *Instance
+  );
+
 /**
   Start a PIO data transfer on specific port.
 
@@ -121,6 +121,11 @@ typedef struct {
 
   BOOLEAN                               UdmaValid;
   BOOLEAN                               Lba48Bit;
+  //
+  // Native command queuing is supported by the device and hasn't been
+  // rejected by the ATA pass thru yet.
+  //
+  BOOLEAN                               NcqValid;
 
   //
   // Cached data for ATA identify data
@@ -31,6 +31,9 @@
 #define ATA_CMD_TRUST_SEND        0x5E
 #define ATA_CMD_TRUST_SEND_DMA    0x5F
 
+#define ATA_CMD_READ_FPDMA_QUEUED  0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+
 //
 // Look up table (UdmaValid, IsWrite) for EFI_ATA_PASS_THRU_CMD_PROTOCOL
 //
@@ -330,6 +333,17 @@ IdentifyAtaDevice (
     }
   }
 
+  //
+  // Check whether the WORD 76 (Serial ATA capabilities) reports native
+  // command queuing. The queued commands are DMA commands.
+  //
+  AtaDevice->NcqValid = FALSE;
+  if (AtaDevice->UdmaValid &&
+      (IdentifyData->serial_ata_capabilities != 0xFFFF) &&
+      ((IdentifyData->serial_ata_capabilities & BIT8) != 0)) {
+    AtaDevice->NcqValid = TRUE;
+  }
+
   Capacity = GetAtapi6Capacity (AtaDevice);
   if (Capacity > MAX_28BIT_ADDRESSING_CAPACITY) {
     //
@@ -441,6 +455,90 @@ DiscoverAtaDevice (
   return Status;
 }
 
+/**
+  Transfer data from ATA device with a native command queuing command.
+
+  This function performs one READ/WRITE FPDMA QUEUED pass through transaction to
+  transfer data from/to ATA device. The queue tag is assigned by the ATA pass
+  through.
+
+  @param[in, out]  AtaDevice       The ATA child device involved for the operation.
+  @param[in, out]  TaskPacket      Pointer to a Pass Thru Command Packet. Optional,
+                                   if it is NULL, blocking mode, and use the packet
+                                   in AtaDevice. If it is not NULL, non blocking mode,
+                                   and pass down this Packet.
+  @param[in, out]  Buffer          The pointer to the current transaction buffer.
+  @param[in]       StartLba        The starting logical block address to be accessed.
+  @param[in]       TransferLength  The block number or sector count of the transfer.
+  @param[in]       IsWrite         Indicates whether it is a write operation.
+  @param[in]       Event           If Event is NULL, then blocking I/O is performed.
+                                   If Event is not NULL and non-blocking I/O is
+                                   supported,then non-blocking I/O is performed,
+                                   and Event will be signaled when the write
+                                   request is completed.
+
+  @retval EFI_SUCCESS       The data transfer is complete successfully.
+  @retval EFI_UNSUPPORTED   The ATA pass through doesn't support the queued commands.
+  @return others            Some error occurs when transferring data.
+
+**/
+EFI_STATUS
+TransferAtaDeviceQueued (
+  IN OUT ATA_DEVICE                       *AtaDevice,
+  IN OUT EFI_ATA_PASS_THRU_COMMAND_PACKET *TaskPacket, OPTIONAL
+  IN OUT VOID                             *Buffer,
+  IN EFI_LBA                              StartLba,
+  IN UINT32                               TransferLength,
+  IN BOOLEAN                              IsWrite,
+  IN EFI_EVENT                            Event OPTIONAL
+  )
+{
+  EFI_ATA_COMMAND_BLOCK             *Acb;
+  EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+
+  //
+  // Prepare for ATA command block. The sector count is in the feature fields,
+  // the sector count field carries the queue tag.
+  //
+  Acb = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
+  Acb->AtaCommand         = IsWrite ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+  Acb->AtaSectorNumber    = (UINT8) StartLba;
+  Acb->AtaCylinderLow     = (UINT8) RShiftU64 (StartLba, 8);
+  Acb->AtaCylinderHigh    = (UINT8) RShiftU64 (StartLba, 16);
+  Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
+  Acb->AtaCylinderLowExp  = (UINT8) RShiftU64 (StartLba, 32);
+  Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
+  Acb->AtaFeatures        = (UINT8) TransferLength;
+  Acb->AtaFeaturesExp     = (UINT8) (TransferLength >> 8);
+  Acb->AtaDeviceHead      = (UINT8) BIT6;
+
+  //
+  // Prepare for ATA pass through packet.
+  //
+  if (TaskPacket != NULL) {
+    Packet = ZeroMem (TaskPacket, sizeof (EFI_ATA_PASS_THRU_COMMAND_PACKET));
+  } else {
+    Packet = ZeroMem (&AtaDevice->Packet, sizeof (EFI_ATA_PASS_THRU_COMMAND_PACKET));
+  }
+
+  if (IsWrite) {
+    Packet->OutDataBuffer = Buffer;
+    Packet->OutTransferLength = TransferLength;
+  } else {
+    Packet->InDataBuffer = Buffer;
+    Packet->InTransferLength = TransferLength;
+  }
+
+  Packet->Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  Packet->Length   = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
+  //
+  // Use the same timeout as the DMA read/write operation, see TransferAtaDevice().
+  //
+  Packet->Timeout  = EFI_TIMER_PERIOD_SECONDS (DivU64x32 (MultU64x32 (TransferLength, AtaDevice->BlockMedia.BlockSize), 2100000) + 31);
+
+  return AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+}
+
 /**
   Transfer data from ATA device.
 
@@ -478,9 +576,29 @@ TransferAtaDevice (
   IN EFI_EVENT                            Event OPTIONAL
   )
 {
+  EFI_STATUS                        Status;
   EFI_ATA_COMMAND_BLOCK             *Acb;
   EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
 
+  //
+  // Use READ/WRITE FPDMA QUEUED when the device supports native command
+  // queuing, so that the ATA pass thru can keep several commands in flight.
+  // If the ATA pass thru rejects them, use the non-queued commands from now on.
+  //
+  if (AtaDevice->NcqValid) {
+    Status = TransferAtaDeviceQueued (AtaDevice, TaskPacket, Buffer, StartLba, TransferLength, IsWrite, Event);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+
+    DEBUG ((EFI_D_INFO, "AtaBus - native command queuing is not supported by the ATA pass thru\n"));
+    AtaDevice->NcqValid = FALSE;
+    if (TaskPacket != NULL) {
+      FreeAlignedBuffer (TaskPacket->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+      FreePool (TaskPacket->Acb);
+    }
+  }
+
   //
   // Ensure AtaDevice->UdmaValid, AtaDevice->Lba48Bit and IsWrite are valid boolean values
   //
@@ -813,7 +931,11 @@ AccessAtaDevice(
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // With native command queuing the sub tasks of several requests can be
+    // outstanding together, otherwise a request waits for the previous one.
+    //
+    if (!AtaDevice->NcqValid && !IsListEmpty (&AtaDevice->AtaSubTaskList)) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
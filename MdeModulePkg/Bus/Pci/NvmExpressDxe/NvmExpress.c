@@ -644,6 +644,25 @@ ProcessAsyncTaskList (
           sizeof(EFI_NVM_EXPRESS_COMPLETION)
           );
 
+        //
+        // Release the DMA resources of the command.
+        //
+        PciIo = Private->PciIo;
+        if (AsyncRequest->MapData != NULL) {
+          PciIo->Unmap (PciIo, AsyncRequest->MapData);
+        }
+        if (AsyncRequest->MapMeta != NULL) {
+          PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
+        }
+        if (AsyncRequest->PrpListHost != NULL) {
+          NvmeFreePrpList (
+            Private,
+            AsyncRequest->PrpListHost,
+            AsyncRequest->PrpListNo,
+            AsyncRequest->MapPrpList
+            );
+        }
+
         RemoveEntryList (Link);
         gBS->SignalEvent (AsyncRequest->CallerEvent);
         FreePool (AsyncRequest);
@@ -994,6 +1013,15 @@ NvmExpressDriverBindingStart (
       goto Exit;
     }
 
+    //
+    // The PRP list pool is an optimization only, the commands allocate
+    // their own PRP lists if it can't be created.
+    //
+    Status = NvmeCreatePrpPool (Private);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_WARN, "NvmExpressDriverBindingStart: no PRP list pool (%r)\n", Status));
+    }
+
     //
     // Start the asynchronous I/O completion monitor
     //
@@ -1072,6 +1100,10 @@ NvmExpressDriverBindingStart (
   return EFI_SUCCESS;
 
 Exit:
+  if (Private != NULL) {
+    NvmeDestroyPrpPool (Private);
+  }
+
   if ((Private != NULL) && (Private->Mapping != NULL)) {
     PciIo->Unmap (PciIo, Private->Mapping);
   }
@@ -1195,6 +1227,8 @@ NvmExpressDriverBindingStop (
         gBS->CloseEvent (Private->TimerEvent);
       }
 
+      NvmeDestroyPrpPool (Private);
+
       if (Private->Mapping != NULL) {
         Private->PciIo->Unmap (Private->PciIo, Private->Mapping);
       }
@@ -39,6 +39,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -79,6 +80,22 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 
 #define NVME_MAX_QUEUES                           3     // Number of queues supported by the driver
 
+//
+// Maximum number of commands a blocking read or write keeps outstanding
+// in the asynchronous I/O queue at the same time.
+//
+#define NVME_SYNC_IO_DEPTH                        NVME_ASYNC_CSQ_SIZE
+
+//
+// Number of slots in the PRP list pool, one for each command that can be
+// outstanding in the I/O queues. The free slots are tracked in a UINT64.
+//
+#define NVME_PRP_POOL_SLOTS                       (NVME_ASYNC_CSQ_SIZE + 1)
+//
+// Maximum number of PRP list pages in one slot of the PRP list pool.
+//
+#define NVME_PRP_POOL_MAX_SLOT_PAGES              4
+
 #define NVME_CONTROLLER_ID                        0
 
 //
@@ -156,6 +173,16 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
 
   VOID                                *Mapping;
 
+  //
+  // PRP list pool, NVME_PRP_POOL_SLOTS slots of PrpPoolSlotPages pages each.
+  // A set bit in PrpPoolFreeMask marks a free slot.
+  //
+  VOID                                *PrpPoolHost;
+  EFI_PHYSICAL_ADDRESS                PrpPoolPhyAddr;
+  VOID                                *PrpPoolMapping;
+  UINTN                               PrpPoolSlotPages;
+  UINT64                              PrpPoolFreeMask;
+
   //
   // For Non-blocking operations.
   //
@@ -293,6 +320,14 @@ typedef struct {
   EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET *Packet;
   UINT16                                   CommandId;
   EFI_EVENT                                CallerEvent;
+  //
+  // DMA resources released when the command completes.
+  //
+  VOID                                     *MapData;
+  VOID                                     *MapMeta;
+  VOID                                     *MapPrpList;
+  UINTN                                    PrpListNo;
+  VOID                                     *PrpListHost;
 } NVME_PASS_THRU_ASYNC_REQ;
 
 #define NVME_PASS_THRU_ASYNC_REQ_FROM_THIS(a) \
@@ -302,6 +337,17 @@ typedef struct {
       NVME_PASS_THRU_ASYNC_REQ_SIG                       \
       )
 
+//
+// One outstanding command of a blocking read or write.
+//
+typedef struct {
+  EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET CommandPacket;
+  EFI_NVM_EXPRESS_COMMAND                  Command;
+  EFI_NVM_EXPRESS_COMPLETION               Completion;
+  EFI_EVENT                                Event;
+  BOOLEAN                                  Busy;
+} NVME_SYNC_IO_SLOT;
+
 /**
   Retrieves a Unicode string that is the user readable name of the driver.
 
@@ -705,6 +751,63 @@ NvmExpressBuildDevicePath (
   IN OUT EFI_DEVICE_PATH_PROTOCOL                    **DevicePath
   );
 
+/**
+  Call back function when the timer event is signaled.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT                    Event,
+  IN VOID*                        Context
+  );
+
+/**
+  Create the pool of PRP list pages shared by the commands of the controller.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The PRP list pool is created.
+  @retval Others                     Fail to create the PRP list pool.
+
+**/
+EFI_STATUS
+NvmeCreatePrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  );
+
+/**
+  Destroy the pool of PRP list pages of the controller.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeDestroyPrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  );
+
+/**
+  Release the PRP lists created by NvmeCreatePrpList().
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]     PrpListHost         The host base address of PRP lists.
+  @param[in]     PrpListNo           The number of PRP List.
+  @param[in]     Mapping             The mapping value returned from NvmeCreatePrpList().
+
+**/
+VOID
+NvmeFreePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private,
+  IN VOID                             *PrpListHost,
+  IN UINTN                            PrpListNo,
+  IN VOID                             *Mapping
+  );
+
 /**
   Dump the execution status from a given completion queue entry.
 
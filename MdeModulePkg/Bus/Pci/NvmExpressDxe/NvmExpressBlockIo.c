@@ -147,6 +147,215 @@ WriteSectors (
   return Status;
 }
 
+/**
+  Read or write blocks with up to NVME_SYNC_IO_DEPTH commands outstanding in
+  the asynchronous I/O queue, and wait until all of them complete.
+
+  The transfer is split into commands of at most MaxTransferBlocks blocks. The
+  free slots are refilled and the completion queue is reaped in one loop, so
+  the controller always has work queued while the transfer is in progress.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Read                   TRUE to read from the device, FALSE to write to it.
+  @param  Buffer                 The buffer of the data transferred.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  MaxTransferBlocks      The maximum block number of a single command.
+  @param  Submitted              Return whether any command was submitted. When
+                                 not, the transfer can be retried another way.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_OUT_OF_RESOURCES   Fail to allocate the command slots.
+  @retval EFI_TIMEOUT            Some command didn't complete in time.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeReadWriteBatch (
+  IN NVME_DEVICE_PRIVATE_DATA           *Device,
+  IN BOOLEAN                            Read,
+  IN UINT64                             Buffer,
+  IN UINT64                             Lba,
+  IN UINTN                              Blocks,
+  IN UINT32                             MaxTransferBlocks,
+  OUT BOOLEAN                           *Submitted
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA             *Private;
+  NVME_SYNC_IO_SLOT                        *Slots;
+  NVME_SYNC_IO_SLOT                        *Slot;
+  NVME_CQ                                  *Completion;
+  EFI_EVENT                                TimerEvent;
+  EFI_STATUS                               Status;
+  EFI_TPL                                  OldTpl;
+  UINTN                                    SlotNum;
+  UINTN                                    Index;
+  UINTN                                    Outstanding;
+  UINT32                                   BlockSize;
+  UINT32                                   Count;
+  BOOLEAN                                  Progress;
+
+  Private     = Device->Controller;
+  BlockSize   = Device->Media.BlockSize;
+  TimerEvent  = NULL;
+  Outstanding = 0;
+  *Submitted  = FALSE;
+
+  SlotNum = (Blocks + MaxTransferBlocks - 1) / MaxTransferBlocks;
+  if (SlotNum > NVME_SYNC_IO_DEPTH) {
+    SlotNum = NVME_SYNC_IO_DEPTH;
+  }
+
+  Slots = AllocateZeroPool (SlotNum * sizeof (NVME_SYNC_IO_SLOT));
+  if (Slots == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < SlotNum; Index++) {
+    Status = gBS->CreateEvent (0, 0, NULL, NULL, &Slots[Index].Event);
+    if (EFI_ERROR (Status)) {
+      goto EXIT;
+    }
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    goto EXIT;
+  }
+
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    goto EXIT;
+  }
+
+  while (((Blocks > 0) && !EFI_ERROR (Status)) || (Outstanding > 0)) {
+    //
+    // Fill the free slots and reap the completion queue. Both run at the
+    // TPL of the asynchronous timer which also works on the queue.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    for (Index = 0; (Index < SlotNum) && (Blocks > 0) && !EFI_ERROR (Status); Index++) {
+      Slot = &Slots[Index];
+      if (Slot->Busy) {
+        continue;
+      }
+
+      Count = (Blocks > MaxTransferBlocks) ? MaxTransferBlocks : (UINT32) Blocks;
+
+      ZeroMem (&Slot->CommandPacket, sizeof (EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+      ZeroMem (&Slot->Command, sizeof (EFI_NVM_EXPRESS_COMMAND));
+      ZeroMem (&Slot->Completion, sizeof (EFI_NVM_EXPRESS_COMPLETION));
+
+      Slot->CommandPacket.NvmeCmd        = &Slot->Command;
+      Slot->CommandPacket.NvmeCompletion = &Slot->Completion;
+      Slot->CommandPacket.TransferBuffer = (VOID *)(UINTN)Buffer;
+      Slot->CommandPacket.TransferLength = Count * BlockSize;
+      Slot->CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+      Slot->CommandPacket.QueueType      = NVME_IO_QUEUE;
+
+      Slot->Command.Cdw0.Opcode = Read ? NVME_IO_READ_OPC : NVME_IO_WRITE_OPC;
+      Slot->Command.Nsid        = Device->NamespaceId;
+      Slot->Command.Cdw10       = (UINT32)Lba;
+      Slot->Command.Cdw11       = (UINT32)RShiftU64(Lba, 32);
+      Slot->Command.Cdw12       = (Count - 1) & 0xFFFF;
+      if (!Read) {
+        //
+        // Set Force Unit Access bit (bit 30) to use write-through behaviour
+        //
+        Slot->Command.Cdw12    |= BIT30;
+      }
+      Slot->Command.Flags       = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+
+      Status = Private->Passthru.PassThru (
+                                   &Private->Passthru,
+                                   Device->NamespaceId,
+                                   &Slot->CommandPacket,
+                                   Slot->Event
+                                   );
+      if (Status == EFI_NOT_READY) {
+        //
+        // The queue is full, retry when some command completes.
+        //
+        Status = EFI_SUCCESS;
+        break;
+      } else if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Slot->Busy = TRUE;
+      Outstanding++;
+      *Submitted = TRUE;
+
+      Blocks -= Count;
+      Buffer += MultU64x32 (Count, BlockSize);
+      Lba    += Count;
+    }
+
+    ProcessAsyncTaskList (NULL, Private);
+
+    gBS->RestoreTPL (OldTpl);
+
+    Progress = FALSE;
+    for (Index = 0; Index < SlotNum; Index++) {
+      Slot = &Slots[Index];
+      if (!Slot->Busy || EFI_ERROR (gBS->CheckEvent (Slot->Event))) {
+        continue;
+      }
+
+      Slot->Busy = FALSE;
+      Outstanding--;
+      Progress   = TRUE;
+
+      Completion = (NVME_CQ *) &Slot->Completion;
+      if ((Completion->Sct != 0) || (Completion->Sc != 0)) {
+        if (!EFI_ERROR (Status)) {
+          Status = EFI_DEVICE_ERROR;
+        }
+
+        //
+        // Dump completion entry status for debugging.
+        //
+        DEBUG_CODE_BEGIN();
+          NvmeDumpStatus (Completion);
+        DEBUG_CODE_END();
+      }
+    }
+
+    if (Progress) {
+      gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+    } else if (!EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+      //
+      // The outstanding commands still own their slots and may complete
+      // later, so the slots can't be released.
+      //
+      DEBUG ((EFI_D_ERROR, "%a: %Lu commands timed out\n", __FUNCTION__, (UINT64) Outstanding));
+      Status = EFI_TIMEOUT;
+      if (Outstanding > 0) {
+        Slots = NULL;
+      }
+      break;
+    }
+  }
+
+EXIT:
+  if (TimerEvent != NULL) {
+    gBS->CloseEvent (TimerEvent);
+  }
+
+  if (Slots != NULL) {
+    for (Index = 0; Index < SlotNum; Index++) {
+      if (Slots[Index].Event != NULL) {
+        gBS->CloseEvent (Slots[Index].Event);
+      }
+    }
+
+    FreePool (Slots);
+  }
+
+  return Status;
+}
+
 /**
   Read some blocks from the device.
 
@@ -173,6 +382,7 @@ NvmeRead (
   UINT32                           MaxTransferBlocks;
   UINTN                            OrginalBlocks;
   BOOLEAN                          IsEmpty;
+  BOOLEAN                          Submitted;
   EFI_TPL                          OldTpl;
 
   //
@@ -201,6 +411,22 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
+  //
+  // A transfer that needs several commands can keep them all in flight
+  // together, otherwise they go through the blocking I/O queue in turn.
+  //
+  if (FeaturePcdGet (PcdNvmExpressQueuedIo) && (Blocks > MaxTransferBlocks)) {
+    Status = NvmeReadWriteBatch (Device, TRUE, (UINT64)(UINTN)Buffer, Lba, Blocks, MaxTransferBlocks, &Submitted);
+    //
+    // Only go on with the blocking I/O queue if the batch failed before any
+    // command reached the device. A timed out command may still complete,
+    // so the buffer can't be handed to a new command.
+    //
+    if (!EFI_ERROR (Status) || Submitted) {
+      Blocks = 0;
+    }
+  }
+
   while (Blocks > 0) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
@@ -251,6 +477,7 @@ NvmeWrite (
   UINT32                           MaxTransferBlocks;
   UINTN                            OrginalBlocks;
   BOOLEAN                          IsEmpty;
+  BOOLEAN                          Submitted;
   EFI_TPL                          OldTpl;
 
   //
@@ -279,6 +506,22 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
+  //
+  // A transfer that needs several commands can keep them all in flight
+  // together, otherwise they go through the blocking I/O queue in turn.
+  //
+  if (FeaturePcdGet (PcdNvmExpressQueuedIo) && (Blocks > MaxTransferBlocks)) {
+    Status = NvmeReadWriteBatch (Device, FALSE, (UINT64)(UINTN)Buffer, Lba, Blocks, MaxTransferBlocks, &Submitted);
+    //
+    // Only go on with the blocking I/O queue if the batch failed before any
+    // command reached the device. A timed out command may still complete,
+    // so the buffer can't be handed to a new command.
+    //
+    if (!EFI_ERROR (Status) || Submitted) {
+      Blocks = 0;
+    }
+  }
+
   while (Blocks > 0) {
     if (Blocks > MaxTransferBlocks) {
       Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
@@ -198,23 +198,137 @@ NvmeDumpStatus (
   }
 }
 
+/**
+  Create the pool of PRP list pages shared by the commands of the controller.
+
+  The pool is allocated and mapped once. A command whose data buffer needs
+  PRP lists takes a slot of the pool, so it doesn't need to allocate and map
+  its own PRP list pages.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The PRP list pool is created.
+  @retval Others                     Fail to create the PRP list pool.
+
+**/
+EFI_STATUS
+NvmeCreatePrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  EFI_PCI_IO_PROTOCOL         *PciIo;
+  EFI_PHYSICAL_ADDRESS        PhyAddr;
+  UINT64                      MaxPages;
+  UINTN                       SlotPages;
+  UINTN                       Bytes;
+  EFI_STATUS                  Status;
+
+  PciIo = Private->PciIo;
+
+  //
+  // Size each slot for the PRP lists of the largest transfer the controller
+  // accepts, but don't let an unlimited MDTS blow up the pool.
+  //
+  SlotPages = NVME_PRP_POOL_MAX_SLOT_PAGES;
+  if ((Private->ControllerData->Mdts != 0) &&
+      (Private->ControllerData->Mdts + Private->Cap.Mpsmin + 12 < 32)) {
+    MaxPages  = EFI_SIZE_TO_PAGES (LShiftU64 (1, Private->ControllerData->Mdts + Private->Cap.Mpsmin + 12)) + 1;
+    MaxPages  = DivU64x32 (MaxPages, EFI_PAGE_SIZE / sizeof (UINT64) - 1) + 1;
+    if (MaxPages < SlotPages) {
+      SlotPages = (UINTN)MaxPages;
+    }
+  }
+
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    NVME_PRP_POOL_SLOTS * SlotPages,
+                    &Private->PrpPoolHost,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    Private->PrpPoolHost = NULL;
+    return Status;
+  }
+
+  Bytes  = EFI_PAGES_TO_SIZE (NVME_PRP_POOL_SLOTS * SlotPages);
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Private->PrpPoolHost,
+                    &Bytes,
+                    &PhyAddr,
+                    &Private->PrpPoolMapping
+                    );
+  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_PRP_POOL_SLOTS * SlotPages))) {
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, Private->PrpPoolMapping);
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+    PciIo->FreeBuffer (PciIo, NVME_PRP_POOL_SLOTS * SlotPages, Private->PrpPoolHost);
+    Private->PrpPoolHost    = NULL;
+    Private->PrpPoolMapping = NULL;
+    return Status;
+  }
+
+  Private->PrpPoolPhyAddr   = PhyAddr;
+  Private->PrpPoolSlotPages = SlotPages;
+  Private->PrpPoolFreeMask  = MAX_UINT64;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Destroy the pool of PRP list pages of the controller.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeDestroyPrpPool (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  EFI_PCI_IO_PROTOCOL         *PciIo;
+
+  PciIo = Private->PciIo;
+
+  if (Private->PrpPoolMapping != NULL) {
+    PciIo->Unmap (PciIo, Private->PrpPoolMapping);
+    Private->PrpPoolMapping = NULL;
+  }
+
+  if (Private->PrpPoolHost != NULL) {
+    PciIo->FreeBuffer (PciIo, NVME_PRP_POOL_SLOTS * Private->PrpPoolSlotPages, Private->PrpPoolHost);
+    Private->PrpPoolHost = NULL;
+  }
+
+  Private->PrpPoolFreeMask = 0;
+}
+
 /**
   Create PRP lists for data transfer which is larger than 2 memory pages.
   Note here we calcuate the number of required PRP lists and allocate them at one time.
 
-  @param[in]     PciIo               A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  The PRP lists are taken from the PRP list pool of the controller when a
+  slot is free and large enough, otherwise they are allocated and mapped for
+  this command only.
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
   @param[in]     PhysicalAddr        The physical base address of data buffer.
   @param[in]     Pages               The number of pages to be transfered.
   @param[out]    PrpListHost         The host base address of PRP lists.
   @param[in,out] PrpListNo           The number of PRP List.
-  @param[out]    Mapping             The mapping value returned from PciIo.Map().
+  @param[out]    Mapping             The mapping value returned from PciIo.Map(), or NULL
+                                     if the PRP lists are taken from the pool.
 
   @retval The pointer to the first PRP List of the PRP lists.
 
 **/
 VOID*
 NvmeCreatePrpList (
-  IN     EFI_PCI_IO_PROTOCOL          *PciIo,
+  IN     NVME_CONTROLLER_PRIVATE_DATA *Private,
   IN     EFI_PHYSICAL_ADDRESS         PhysicalAddr,
   IN     UINTN                        Pages,
      OUT VOID                         **PrpListHost,
@@ -222,6 +336,7 @@ NvmeCreatePrpList (
      OUT VOID                         **Mapping
   )
 {
+  EFI_PCI_IO_PROTOCOL         *PciIo;
   UINTN                       PrpEntryNo;
   UINT64                      PrpListBase;
   UINTN                       PrpListIndex;
@@ -230,6 +345,11 @@ NvmeCreatePrpList (
   EFI_PHYSICAL_ADDRESS        PrpListPhyAddr;
   UINTN                       Bytes;
   EFI_STATUS                  Status;
+  INTN                        Slot;
+  EFI_TPL                     OldTpl;
+
+  PciIo    = Private->PciIo;
+  *Mapping = NULL;
 
   //
   // The number of Prp Entry in a memory page.
@@ -250,32 +370,54 @@ NvmeCreatePrpList (
     Remainder = PrpEntryNo - 1;
   }
 
-  Status = PciIo->AllocateBuffer (
-                    PciIo,
-                    AllocateAnyPages,
-                    EfiBootServicesData,
-                    *PrpListNo,
-                    PrpListHost,
-                    0
-                    );
-
-  if (EFI_ERROR (Status)) {
-    return NULL;
+  //
+  // Take a free slot of the PRP list pool, which is already mapped.
+  //
+  Slot = -1;
+  if (*PrpListNo <= Private->PrpPoolSlotPages) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Slot   = LowBitSet64 (Private->PrpPoolFreeMask);
+    if (Slot >= 0) {
+      Private->PrpPoolFreeMask &= ~LShiftU64 (1, (UINTN)Slot);
+    }
+    gBS->RestoreTPL (OldTpl);
   }
 
   Bytes = EFI_PAGES_TO_SIZE (*PrpListNo);
-  Status = PciIo->Map (
-                    PciIo,
-                    EfiPciIoOperationBusMasterCommonBuffer,
-                    *PrpListHost,
-                    &Bytes,
-                    &PrpListPhyAddr,
-                    Mapping
-                    );
+  if (Slot >= 0) {
+    *PrpListHost   = (UINT8 *)Private->PrpPoolHost + EFI_PAGES_TO_SIZE ((UINTN)Slot * Private->PrpPoolSlotPages);
+    PrpListPhyAddr = Private->PrpPoolPhyAddr + EFI_PAGES_TO_SIZE ((UINTN)Slot * Private->PrpPoolSlotPages);
+  } else {
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      *PrpListNo,
+                      PrpListHost,
+                      0
+                      );
 
-  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (*PrpListNo))) {
-    DEBUG ((EFI_D_ERROR, "NvmeCreatePrpList: create PrpList failure!\n"));
-    goto EXIT;
+    if (EFI_ERROR (Status)) {
+      return NULL;
+    }
+
+    Status = PciIo->Map (
+                      PciIo,
+                      EfiPciIoOperationBusMasterCommonBuffer,
+                      *PrpListHost,
+                      &Bytes,
+                      &PrpListPhyAddr,
+                      Mapping
+                      );
+
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (*PrpListNo))) {
+      DEBUG ((EFI_D_ERROR, "NvmeCreatePrpList: create PrpList failure!\n"));
+      if (!EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, *Mapping);
+      }
+      *Mapping = NULL;
+      goto EXIT;
+    }
   }
   //
   // Fill all PRP lists except of last one.
@@ -315,6 +457,49 @@ EXIT:
   return NULL;
 }
 
+/**
+  Release the PRP lists created by NvmeCreatePrpList().
+
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]     PrpListHost         The host base address of PRP lists.
+  @param[in]     PrpListNo           The number of PRP List.
+  @param[in]     Mapping             The mapping value returned from NvmeCreatePrpList().
+
+**/
+VOID
+NvmeFreePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private,
+  IN VOID                             *PrpListHost,
+  IN UINTN                            PrpListNo,
+  IN VOID                             *Mapping
+  )
+{
+  UINTN                       Offset;
+  UINTN                       Slot;
+  EFI_TPL                     OldTpl;
+
+  if ((Private->PrpPoolHost != NULL) &&
+      ((UINTN)PrpListHost >= (UINTN)Private->PrpPoolHost) &&
+      ((UINTN)PrpListHost < (UINTN)Private->PrpPoolHost + EFI_PAGES_TO_SIZE (NVME_PRP_POOL_SLOTS * Private->PrpPoolSlotPages))) {
+    //
+    // Give the slot back to the PRP list pool.
+    //
+    Offset = (UINTN)PrpListHost - (UINTN)Private->PrpPoolHost;
+    Slot   = Offset / EFI_PAGES_TO_SIZE (Private->PrpPoolSlotPages);
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Private->PrpPoolFreeMask |= LShiftU64 (1, Slot);
+    gBS->RestoreTPL (OldTpl);
+    return;
+  }
+
+  if (Mapping != NULL) {
+    Private->PciIo->Unmap (Private->PciIo, Mapping);
+  }
+
+  Private->PciIo->FreeBuffer (Private->PciIo, PrpListNo, PrpListHost);
+}
+
 
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
@@ -558,8 +743,9 @@ NvmExpressPassThru (
     // Create PrpList for remaining data buffer.
     //
     PhyAddr = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
-    Prp = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+    Prp = NvmeCreatePrpList (Private, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
     if (Prp == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
       goto EXIT;
     }
 
@@ -593,6 +779,33 @@ NvmExpressPassThru (
     Sq->Payload.Raw.Cdw15 = Packet->NvmeCmd->Cdw15;
   }
 
+  //
+  // For non-blocking requests, keep the DMA resources with the request
+  // and release them when the command completes. The request must be
+  // queued before the doorbell is rung so the completion can't be missed.
+  //
+  if ((Event != NULL) && (QueueId != 0)) {
+    AsyncRequest = AllocateZeroPool (sizeof (NVME_PASS_THRU_ASYNC_REQ));
+    if (AsyncRequest == NULL) {
+      Status = EFI_DEVICE_ERROR;
+      goto EXIT;
+    }
+
+    AsyncRequest->Signature     = NVME_PASS_THRU_ASYNC_REQ_SIG;
+    AsyncRequest->Packet        = Packet;
+    AsyncRequest->CommandId     = Sq->Cid;
+    AsyncRequest->CallerEvent   = Event;
+    AsyncRequest->MapData       = MapData;
+    AsyncRequest->MapMeta       = MapMeta;
+    AsyncRequest->MapPrpList    = MapPrpList;
+    AsyncRequest->PrpListNo     = PrpListNo;
+    AsyncRequest->PrpListHost   = (Prp != NULL) ? PrpListHost : NULL;
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
+    gBS->RestoreTPL (OldTpl);
+  }
+
   //
   // Ring the submission queue doorbell.
   //
@@ -617,21 +830,6 @@ NvmExpressPassThru (
   // in the submission queue.
   //
   if ((Event != NULL) && (QueueId != 0)) {
-    AsyncRequest = AllocateZeroPool (sizeof (NVME_PASS_THRU_ASYNC_REQ));
-    if (AsyncRequest == NULL) {
-      Status = EFI_DEVICE_ERROR;
-      goto EXIT;
-    }
-
-    AsyncRequest->Signature     = NVME_PASS_THRU_ASYNC_REQ_SIG;
-    AsyncRequest->Packet        = Packet;
-    AsyncRequest->CommandId     = Sq->Cid;
-    AsyncRequest->CallerEvent   = Event;
-
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
-    gBS->RestoreTPL (OldTpl);
-
     return EFI_SUCCESS;
   }
 
@@ -723,15 +921,8 @@ EXIT:
              );
   }
 
-  if (MapPrpList != NULL) {
-    PciIo->Unmap (
-             PciIo,
-             MapPrpList
-             );
-  }
-
   if (Prp != NULL) {
-    PciIo->FreeBuffer (PciIo, PrpListNo, PrpListHost);
+    NvmeFreePrpList (Private, PrpListHost, PrpListNo, MapPrpList);
   }
 
   if (TimerEvent != NULL) {
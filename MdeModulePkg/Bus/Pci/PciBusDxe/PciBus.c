@@ -39,6 +39,19 @@ UINTN                                         gPciHostBridgeNumber = 0;
 BOOLEAN                                       gFullEnumeration     = TRUE;
 UINT64                                        gAllOne              = 0xFFFFFFFFFFFFFFFFULL;
 UINT64                                        gAllZero             = 0;
+//
+// Bytes of config space accessed through the root bridges, reported
+// for every root bridge when its devices are collected.
+//
+UINT64                                        gPciConfigReadCount  = 0;
+UINT64                                        gPciConfigWriteCount = 0;
+//
+// The config header of every device is shadowed while the PCI bus
+// is enumerated, the bytes read from it are counted.
+//
+BOOLEAN                                       gPciConfigShadowEnabled    = FALSE;
+UINTN                                         gPciConfigShadowGeneration = 0;
+UINT64                                        gPciConfigShadowHitCount   = 0;
 
 EFI_PCI_PLATFORM_PROTOCOL                     *gPciPlatformProtocol;
 EFI_PCI_OVERRIDE_PROTOCOL                     *gPciOverrideProtocol;
@@ -317,7 +330,18 @@ PciBusDriverBindingStart (
   // After enumeration, a database that records all the device information will be created
   //
   //
+  gPciConfigShadowGeneration++;
+  gPciConfigShadowEnabled = FeaturePcdGet (PcdPciConfigShadow);
   Status = PciEnumerator (Controller);
+  gPciConfigShadowEnabled = FALSE;
+
+  DEBUG ((
+    EFI_D_INFO,
+    "PciBus: %ld bytes of config reads served from the shadow, %ld bytes of config reads and %ld bytes of config writes issued\n",
+    gPciConfigShadowHitCount,
+    gPciConfigReadCount,
+    gPciConfigWriteCount
+    ));
 
   if (EFI_ERROR (Status)) {
     return Status;
@@ -44,6 +44,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/DevicePathLib.h>
 #include <Library/PcdLib.h>
 #include <Library/PeCoffLib.h>
+#include <Library/TimerLib.h>
 
 #include <IndustryStandard/Pci.h>
 #include <IndustryStandard/PeImage.h>
@@ -289,8 +290,26 @@ struct _PCI_IO_DEVICE {
   // This field is used to support this case.
   //
   UINT16                                    BridgeIoAlignment;
+
+  //
+  // Shadow of the config header used during enumeration, with a bit
+  // for every dword that holds the value last read or seeded.
+  //
+  UINT32                                    ConfigShadow[sizeof (PCI_TYPE00) / sizeof (UINT32)];
+  UINT16                                    ConfigShadowValid;
+  UINT16                                    ConfigShadowMask;
+  UINTN                                     ConfigShadowGeneration;
 };
 
+//
+// The dwords of the config header the shadow may hold, bit N standing for
+// the dword at offset N * 4. Command/Status and BIST change without config
+// writes; the bus numbers of a bridge are programmed through the root bridge
+// directly and its secondary status changes without config writes.
+//
+#define PCI_CONFIG_SHADOW_DEVICE_MASK  0xFFF5
+#define PCI_CONFIG_SHADOW_BRIDGE_MASK  0xFF35
+
 #define PCI_IO_DEVICE_FROM_PCI_IO_THIS(a) \
   CR (a, PCI_IO_DEVICE, PciIo, PCI_IO_DEVICE_SIGNATURE)
 
@@ -321,6 +340,17 @@ extern EFI_PCI_PLATFORM_PROTOCOL                    *gPciPlatformProtocol;
 extern EFI_PCI_OVERRIDE_PROTOCOL                    *gPciOverrideProtocol;
 extern BOOLEAN                                      mReserveIsaAliases;
 extern BOOLEAN                                      mReserveVgaAliases;
+extern UINT64                                       gPciConfigReadCount;
+extern UINT64                                       gPciConfigWriteCount;
+extern BOOLEAN                                      gPciConfigShadowEnabled;
+extern UINTN                                        gPciConfigShadowGeneration;
+extern UINT64                                       gPciConfigShadowHitCount;
+
+//
+// Bytes of config space accessed by Count operations of Width. The low two
+// bits of both the PCI I/O and the root bridge I/O widths encode the size.
+//
+#define PCI_CONFIG_ACCESS_BYTES(Width, Count)  LShiftU64 ((UINT64) (Count), (UINTN) (Width) & 0x03)
 
 /**
   Macro that checks whether device is a GFX device.
@@ -432,6 +432,7 @@ PciAssignBusNumber (
 
         Address   = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, 0x18);
 
+        gPciConfigWriteCount += sizeof (UINT16);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint16,
@@ -444,6 +445,7 @@ PciAssignBusNumber (
         // Initialize SubBusNumber to SecondBus
         //
         Address = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, 0x1A);
+        gPciConfigWriteCount += sizeof (UINT8);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint8,
@@ -457,6 +459,7 @@ PciAssignBusNumber (
         if (IS_PCI_BRIDGE (&Pci)) {
 
           Register8 = 0xFF;
+          gPciConfigWriteCount += sizeof (UINT8);
           Status = PciRootBridgeIo->Pci.Write (
                                           PciRootBridgeIo,
                                           EfiPciWidthUint8,
@@ -481,6 +484,7 @@ PciAssignBusNumber (
         //
         Address = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, 0x1A);
 
+        gPciConfigWriteCount += sizeof (UINT8);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint8,
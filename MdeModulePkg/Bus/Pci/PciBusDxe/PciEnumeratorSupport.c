@@ -50,6 +50,7 @@ PciDevicePresent (
   //
   // Read the Vendor ID register
   //
+  gPciConfigReadCount += sizeof (UINT32);
   Status = PciRootBridgeIo->Pci.Read (
                                   PciRootBridgeIo,
                                   EfiPciWidthUint32,
@@ -62,6 +63,7 @@ PciDevicePresent (
     //
     // Read the entire config header for the device
     //
+    gPciConfigReadCount += sizeof (PCI_TYPE00);
     Status = PciRootBridgeIo->Pci.Read (
                                     PciRootBridgeIo,
                                     EfiPciWidthUint32,
@@ -202,6 +204,61 @@ PciPciDeviceInfoCollector (
   return EFI_SUCCESS;
 }
 
+/**
+  Collect all the resource information under the root bridge and report
+  how many config space accesses and how much time it took.
+
+  @param RootBridge     Root bridge instance.
+  @param StartBusNumber Bus number of begining.
+
+  @retval EFI_SUCCESS   PCI device is found.
+  @retval other         Some error occurred when reading PCI bridge information.
+
+**/
+EFI_STATUS
+PciRootBridgeDeviceInfoCollector (
+  IN PCI_IO_DEVICE                      *RootBridge,
+  IN UINT8                              StartBusNumber
+  )
+{
+  EFI_STATUS          Status;
+  UINT64              ReadCount;
+  UINT64              WriteCount;
+  UINT64              HitCount;
+  UINT64              Begin;
+  UINT64              End;
+  UINT64              CounterStart;
+  UINT64              CounterEnd;
+  UINT64              Elapsed;
+
+  ReadCount  = gPciConfigReadCount;
+  WriteCount = gPciConfigWriteCount;
+  HitCount   = gPciConfigShadowHitCount;
+  Begin      = GetPerformanceCounter ();
+
+  Status = PciPciDeviceInfoCollector (RootBridge, StartBusNumber);
+
+  End = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    Elapsed = Begin - End;
+  } else {
+    Elapsed = End - Begin;
+  }
+
+  DEBUG ((
+    EFI_D_INFO,
+    "PciBus: Collected devices from bus %02x with %ld bytes of config reads, %ld bytes read from shadow and %ld bytes of config writes in %ld us\n",
+    StartBusNumber,
+    gPciConfigReadCount - ReadCount,
+    gPciConfigShadowHitCount - HitCount,
+    gPciConfigWriteCount - WriteCount,
+    DivU64x32 (GetTimeInNanoSecond (Elapsed), 1000)
+    ));
+
+  return Status;
+}
+
 /**
   Seach required device and create PCI device instance.
 
@@ -2127,6 +2184,7 @@ CreatePciIoDevice (
   PciIoDevice->IsPciExp           = FALSE;
 
   CopyMem (&(PciIoDevice->Pci), Pci, sizeof (PCI_TYPE01));
+  PciConfigShadowInit (PciIoDevice);
 
   //
   // Initialize the PCI I/O instance structure
@@ -2443,7 +2501,7 @@ PciEnumeratorLight (
     //
     RootBridgeDev->PciRootBridgeIo = PciRootBridgeIo;
 
-    Status = PciPciDeviceInfoCollector (
+    Status = PciRootBridgeDeviceInfoCollector (
                RootBridgeDev,
                (UINT8) MinBus
                );
@@ -2735,6 +2793,7 @@ ResetAllPpbBusNumber (
 
         Register  = 0;
         Address   = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, 0x18);
+        gPciConfigReadCount += sizeof (UINT32);
         Status    = PciRootBridgeIo->Pci.Read (
                                            PciRootBridgeIo,
                                            EfiPciWidthUint32,
@@ -2752,6 +2811,7 @@ ResetAllPpbBusNumber (
         // Reset register 18h, 19h, 1Ah on PCI Bridge
         //
         Register &= 0xFF000000;
+        gPciConfigWriteCount += sizeof (UINT32);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint32,
@@ -56,6 +56,23 @@ PciPciDeviceInfoCollector (
   IN UINT8                              StartBusNumber
   );
 
+/**
+  Collect all the resource information under the root bridge and report
+  how many config space accesses and how much time it took.
+
+  @param RootBridge     Root bridge instance.
+  @param StartBusNumber Bus number of begining.
+
+  @retval EFI_SUCCESS   PCI device is found.
+  @retval other         Some error occurred when reading PCI bridge information.
+
+**/
+EFI_STATUS
+PciRootBridgeDeviceInfoCollector (
+  IN PCI_IO_DEVICE                      *RootBridge,
+  IN UINT8                              StartBusNumber
+  );
+
 /**
   Seach required device and create PCI device instance.
 
@@ -175,6 +175,170 @@ PciIoVerifyConfigAccess (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the bits of the shadowed dwords which the config space range overlaps.
+
+  @param Offset       The offset within the PCI configuration space.
+  @param Length       The length in bytes of the range.
+
+  @return The bit mask of the dwords, bit N standing for the dword at offset N * 4.
+
+**/
+UINT32
+PciConfigShadowBits (
+  IN UINTN                      Offset,
+  IN UINTN                      Length
+  )
+{
+  UINTN                         First;
+  UINTN                         Last;
+
+  if ((Length == 0) || (Offset >= sizeof (PCI_TYPE00))) {
+    return 0;
+  }
+
+  First = Offset / sizeof (UINT32);
+  Last  = MIN (Offset + Length - 1, sizeof (PCI_TYPE00) - 1) / sizeof (UINT32);
+
+  return (UINT32) (((1 << (Last + 1)) - 1) & ~((1 << First) - 1));
+}
+
+/**
+  Seed the config space shadow of the PCI device from its config header.
+
+  @param PciIoDevice  Pci device instance.
+
+**/
+VOID
+PciConfigShadowInit (
+  IN PCI_IO_DEVICE              *PciIoDevice
+  )
+{
+  CopyMem (PciIoDevice->ConfigShadow, &PciIoDevice->Pci, sizeof (PciIoDevice->ConfigShadow));
+
+  if (IS_PCI_BRIDGE (&PciIoDevice->Pci)) {
+    PciIoDevice->ConfigShadowMask = PCI_CONFIG_SHADOW_BRIDGE_MASK;
+  } else if (IS_CARDBUS_BRIDGE (&PciIoDevice->Pci)) {
+    PciIoDevice->ConfigShadowMask = 0;
+  } else {
+    PciIoDevice->ConfigShadowMask = PCI_CONFIG_SHADOW_DEVICE_MASK;
+  }
+
+  PciIoDevice->ConfigShadowValid      = PciIoDevice->ConfigShadowMask;
+  PciIoDevice->ConfigShadowGeneration = gPciConfigShadowGeneration;
+}
+
+/**
+  Drop the shadowed dwords of the config header which the config space
+  range overlaps, so that they are read from the device again.
+
+  @param PciIoDevice  Pci device instance.
+  @param Offset       The offset within the PCI configuration space.
+  @param Length       The length in bytes of the range.
+
+**/
+VOID
+PciConfigShadowInvalidate (
+  IN PCI_IO_DEVICE              *PciIoDevice,
+  IN UINTN                      Offset,
+  IN UINTN                      Length
+  )
+{
+  PciIoDevice->ConfigShadowValid &= (UINT16) ~PciConfigShadowBits (Offset, Length);
+}
+
+/**
+  Serve a config space read from the shadow of the PCI device.
+
+  The shadow is only used during enumeration, and only when every dword
+  the read covers is shadowed.
+
+  @param PciIoDevice  Pci device instance.
+  @param Width        Signifies the width of the operations.
+  @param Offset       The offset within the PCI configuration space.
+  @param Count        The number of operations to perform.
+  @param Buffer       The destination buffer to store the results.
+
+  @retval TRUE        The read is served from the shadow.
+  @retval FALSE       The read needs to go to the device.
+
+**/
+BOOLEAN
+PciConfigShadowRead (
+  IN  PCI_IO_DEVICE             *PciIoDevice,
+  IN  EFI_PCI_IO_PROTOCOL_WIDTH Width,
+  IN  UINT32                    Offset,
+  IN  UINTN                     Count,
+  OUT VOID                      *Buffer
+  )
+{
+  UINTN                         Length;
+  UINT32                        Bits;
+
+  if (!gPciConfigShadowEnabled || (Width > EfiPciIoWidthUint32)) {
+    return FALSE;
+  }
+
+  if (PciIoDevice->ConfigShadowGeneration != gPciConfigShadowGeneration) {
+    //
+    // The shadow is left from a former enumeration, the device may
+    // have been reprogrammed since then.
+    //
+    PciIoDevice->ConfigShadowValid      = 0;
+    PciIoDevice->ConfigShadowGeneration = gPciConfigShadowGeneration;
+    return FALSE;
+  }
+
+  Length = Count << Width;
+  if ((Length == 0) || (Offset + Length > sizeof (PciIoDevice->ConfigShadow))) {
+    return FALSE;
+  }
+
+  Bits = PciConfigShadowBits (Offset, Length);
+  if ((PciIoDevice->ConfigShadowValid & Bits) != Bits) {
+    return FALSE;
+  }
+
+  CopyMem (Buffer, (UINT8 *) PciIoDevice->ConfigShadow + Offset, Length);
+  gPciConfigShadowHitCount += Length;
+  return TRUE;
+}
+
+/**
+  Record the dwords of the config header read from the PCI device into its shadow.
+
+  @param PciIoDevice  Pci device instance.
+  @param Width        Signifies the width of the operations.
+  @param Offset       The offset within the PCI configuration space.
+  @param Count        The number of operations performed.
+  @param Buffer       The buffer holding the data read.
+
+**/
+VOID
+PciConfigShadowUpdate (
+  IN PCI_IO_DEVICE              *PciIoDevice,
+  IN EFI_PCI_IO_PROTOCOL_WIDTH  Width,
+  IN UINT32                     Offset,
+  IN UINTN                      Count,
+  IN VOID                       *Buffer
+  )
+{
+  UINTN                         Length;
+
+  if (!gPciConfigShadowEnabled || (Width != EfiPciIoWidthUint32) ||
+      (PciIoDevice->ConfigShadowGeneration != gPciConfigShadowGeneration)) {
+    return;
+  }
+
+  Length = Count * sizeof (UINT32);
+  if (((Offset & 0x03) != 0) || (Offset + Length > sizeof (PciIoDevice->ConfigShadow))) {
+    return;
+  }
+
+  CopyMem ((UINT8 *) PciIoDevice->ConfigShadow + Offset, Buffer, Length);
+  PciIoDevice->ConfigShadowValid |= (UINT16) (PciConfigShadowBits (Offset, Length) & PciIoDevice->ConfigShadowMask);
+}
+
 /**
   Reads from the memory space of a PCI controller. Returns either when the polling exit criteria is
   satisfied or after a defined duration.
@@ -737,6 +901,10 @@ PciIoConfigRead (
   if (EFI_ERROR (Status)) {
     return Status;
   }
+
+  if (PciConfigShadowRead (PciIoDevice, Width, Offset, Count, Buffer)) {
+    return EFI_SUCCESS;
+  }
   
   //
   // If request is not aligned, then convert request to EfiPciIoWithXXXUint8
@@ -748,6 +916,7 @@ PciIoConfigRead (
     }
   }    
 
+  gPciConfigReadCount += PCI_CONFIG_ACCESS_BYTES (Width, Count);
   Status = PciIoDevice->PciRootBridgeIo->Pci.Read (
                                                PciIoDevice->PciRootBridgeIo,
                                                (EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH) Width,
@@ -762,6 +931,8 @@ PciIoConfigRead (
       EFI_IO_BUS_PCI | EFI_IOB_EC_READ_ERROR,
       PciIoDevice->DevicePath
       );
+  } else {
+    PciConfigShadowUpdate (PciIoDevice, Width, Offset, Count, Buffer);
   }
 
   return Status;
@@ -817,6 +988,8 @@ PciIoConfigWrite (
     }
   }  
   
+  PciConfigShadowInvalidate (PciIoDevice, Offset, Count << (Width & 0x03));
+  gPciConfigWriteCount += PCI_CONFIG_ACCESS_BYTES (Width, Count);
   Status = PciIoDevice->PciRootBridgeIo->Pci.Write (
                                               PciIoDevice->PciRootBridgeIo,
                                               (EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH) Width,
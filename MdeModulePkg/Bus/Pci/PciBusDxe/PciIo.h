@@ -72,6 +72,33 @@ PciIoVerifyConfigAccess (
   IN UINT64                     *Offset
   );
 
+/**
+  Seed the config space shadow of the PCI device from its config header.
+
+  @param PciIoDevice  Pci device instance.
+
+**/
+VOID
+PciConfigShadowInit (
+  IN PCI_IO_DEVICE              *PciIoDevice
+  );
+
+/**
+  Drop the shadowed dwords of the config header which the config space
+  range overlaps, so that they are read from the device again.
+
+  @param PciIoDevice  Pci device instance.
+  @param Offset       The offset within the PCI configuration space.
+  @param Length       The length in bytes of the range.
+
+**/
+VOID
+PciConfigShadowInvalidate (
+  IN PCI_IO_DEVICE              *PciIoDevice,
+  IN UINTN                      Offset,
+  IN UINTN                      Length
+  );
+
 /**
   Reads from the memory space of a PCI controller. Returns either when the polling exit criteria is
   satisfied or after a defined duration.
@@ -1172,6 +1172,7 @@ PciScanBus (
         Register  = (UINT16) ((SecondBus << 8) | (UINT16) StartBusNumber);
         Address   = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, PCI_BRIDGE_PRIMARY_BUS_REGISTER_OFFSET);
 
+        gPciConfigWriteCount += sizeof (UINT16);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint16,
@@ -1192,6 +1193,7 @@ PciScanBus (
           //
           Register  = 0xFF;
           Address   = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, PCI_BRIDGE_SUBORDINATE_BUS_REGISTER_OFFSET);
+          gPciConfigWriteCount += sizeof (UINT8);
           Status = PciRootBridgeIo->Pci.Write (
                                           PciRootBridgeIo,
                                           EfiPciWidthUint8,
@@ -1247,6 +1249,7 @@ PciScanBus (
         //
         Address = EFI_PCI_ADDRESS (StartBusNumber, Device, Func, PCI_BRIDGE_SUBORDINATE_BUS_REGISTER_OFFSET);
 
+        gPciConfigWriteCount += sizeof (UINT8);
         Status = PciRootBridgeIo->Pci.Write (
                                         PciRootBridgeIo,
                                         EfiPciWidthUint8,
@@ -1630,7 +1633,7 @@ PciHostBridgeEnumerator (
     // A database that records all the information about pci device subject to this
     // root bridge will then be created
     //
-    Status = PciPciDeviceInfoCollector (
+    Status = PciRootBridgeDeviceInfoCollector (
               RootBridgeDev,
               (UINT8) MinBus
               );
@@ -272,6 +272,7 @@ GetOpRomInfo (
   AllOnes = 0xfffffffe;
   Address = EFI_PCI_ADDRESS (Bus, Device, Function, RomBarIndex);
 
+  gPciConfigWriteCount += sizeof (UINT32);
   Status = PciRootBridgeIo->Pci.Write (
                                   PciRootBridgeIo,
                                   EfiPciWidthUint32,
@@ -279,6 +280,7 @@ GetOpRomInfo (
                                   1,
                                   &AllOnes
                                   );
+  PciConfigShadowInvalidate (PciIoDevice, RomBarIndex, sizeof (UINT32));
   if (EFI_ERROR (Status)) {
     return EFI_NOT_FOUND;
   }
@@ -286,6 +288,7 @@ GetOpRomInfo (
   //
   // Read back
   //
+  gPciConfigReadCount += sizeof (UINT32);
   Status = PciRootBridgeIo->Pci.Read(
                                   PciRootBridgeIo,
                                   EfiPciWidthUint32,
@@ -934,6 +934,7 @@ XhcControlTransfer (
   if (Urb->DataMap != NULL) {
     Status = Xhc->PciIo->Unmap (Xhc->PciIo, Urb->DataMap);
     ASSERT_EFI_ERROR (Status);
+    Urb->DataMap = NULL;
     if (EFI_ERROR (Status)) {
       Status = EFI_DEVICE_ERROR;
       goto FREE_URB;
@@ -1116,7 +1117,7 @@ XhcControlTransfer (
   }
 
 FREE_URB:
-  FreePool (Urb);
+  XhcFreeUrb (Xhc, Urb);
 
 ON_EXIT:
 
@@ -2064,7 +2065,9 @@ XhcDriverBindingStart (
   //
   // Start the asynchronous interrupt monitor
   //
-  Status = gBS->SetTimer (Xhc->PollTimer, TimerPeriodic, XHC_ASYNC_TIMER_INTERVAL);
+  Xhc->PollInterval  = XHC_ASYNC_TIMER_INTERVAL;
+  Xhc->PollIdleTicks = 0;
+  Status = gBS->SetTimer (Xhc->PollTimer, TimerPeriodic, Xhc->PollInterval);
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "XhcDriverBindingStart: failed to start async interrupt monitor\n"));
     XhcHaltHC (Xhc, XHC_GENERIC_TIMEOUT);
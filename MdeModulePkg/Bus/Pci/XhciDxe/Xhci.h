@@ -31,6 +31,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/UefiLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PcdLib.h>
 
 #include <IndustryStandard/Pci.h>
 
@@ -65,6 +66,20 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 // The unit is 100us, takes 1ms as interval.
 //
 #define XHC_ASYNC_TIMER_INTERVAL     EFI_TIMER_PERIOD_MILLISECONDS(1)
+//
+// XHC async transfer timer doubles its interval after XHC_ASYNC_IDLE_TICKS
+// ticks without any completed async transfer, up to the max interval.
+// The unit is 100ns, takes 8ms as max interval.
+//
+#define XHC_ASYNC_TIMER_MAX_INTERVAL EFI_TIMER_PERIOD_MILLISECONDS(8)
+#define XHC_ASYNC_IDLE_TICKS         16
+//
+// XHC sync transfer polls the event ring every 1us first, and doubles the
+// interval every XHC_POLL_BACKOFF_COUNT polls while the transfer is pending.
+// The unit is microsecond, takes 64us as max interval.
+//
+#define XHC_POLL_BACKOFF_COUNT       16
+#define XHC_POLL_MAX_INTERVAL        (64)
 
 //
 // XHC raises TPL to TPL_NOTIFY to serialize all its operations
@@ -180,6 +195,17 @@ struct _USB_DEV_CONTEXT {
   //
   VOID                      *EndpointTransferRing[31];
   //
+  // The URB whose TRBs are queued on every endpoint. Transfer events are
+  // dispatched to their URB by the slot id and endpoint id they carry.
+  //
+  URB                       *PendingUrb[31];
+  //
+  // The cost of polling the device: the polls of its transfers and the
+  // transfer events dispatched to it.
+  //
+  UINT64                    PollCount;
+  UINT64                    EventCount;
+  //
   // The device descriptor which is stored to support XHCI's Evaluate_Context cmd.
   //
   EFI_USB_DEVICE_DESCRIPTOR DevDesc;
@@ -217,6 +243,8 @@ struct _USB_XHCI_INSTANCE {
   //
   EFI_EVENT                 ExitBootServiceEvent;
   EFI_EVENT                 PollTimer;
+  UINT64                    PollInterval;
+  UINTN                     PollIdleTicks;
   LIST_ENTRY                AsyncIntTransfers;
 
   UINT8                     CapLength;    ///< Capability Register Length
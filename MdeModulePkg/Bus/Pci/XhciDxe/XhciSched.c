@@ -198,10 +198,27 @@ XhcFreeUrb (
   IN URB                  *Urb
   )
 {
+  UINT8                 SlotId;
+  UINT8                 Dci;
+
   if ((Xhc == NULL) || (Urb == NULL)) {
     return;
   }
-  
+
+  //
+  // Drop the URB from the endpoint it is pending on, so that no later
+  // transfer event gets dispatched to it.
+  //
+  if (Urb->Ring != &Xhc->CmdRing) {
+    SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
+    if (SlotId != 0) {
+      Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
+      if ((Dci != 0) && (Dci < 32) && (Xhc->UsbDevContext[SlotId].PendingUrb[Dci-1] == Urb)) {
+        Xhc->UsbDevContext[SlotId].PendingUrb[Dci-1] = NULL;
+      }
+    }
+  }
+
   if (Urb->DataMap != NULL) {
     Xhc->PciIo->Unmap (Xhc->PciIo, Urb->DataMap);
   }
@@ -448,6 +465,12 @@ XhcCreateTransferTrb (
       break;
   }
 
+  //
+  // The TRBs just queued are the newest ones on the endpoint, so the
+  // transfer events of the endpoint belong to this URB from now on.
+  //
+  Xhc->UsbDevContext[SlotId].PendingUrb[Dci-1] = Urb;
+
   return EFI_SUCCESS;
 }
 
@@ -1038,37 +1061,57 @@ IsTransferRingTrb (
   IN  URB                 *Urb
   )
 {
-  TRB_TEMPLATE  *CheckedTrb;
-  UINTN         Index;
+  TRB_TEMPLATE  *RingStart;
 
-  CheckedTrb = Urb->Ring->RingSeg0;
+  RingStart = Urb->Ring->RingSeg0;
 
   ASSERT (Urb->Ring->TrbNumber == CMD_RING_TRB_NUMBER || Urb->Ring->TrbNumber == TR_RING_TRB_NUMBER);
 
-  for (Index = 0; Index < Urb->Ring->TrbNumber; Index++) {
-    if (Trb == CheckedTrb) {
-      return TRUE;
-    }
-    CheckedTrb++;
+  //
+  // The ring is a single segment of contiguous TRBs.
+  //
+  return (BOOLEAN) ((Trb >= RingStart) && (Trb < RingStart + Urb->Ring->TrbNumber));
+}
+
+/**
+  Look up the URB a transfer event belongs to by the slot id and the
+  endpoint id the event carries.
+
+  @param  Xhc             The XHCI Instance.
+  @param  EvtTrb          The transfer event.
+
+  @return The URB pending on the endpoint, or NULL if there is none.
+
+**/
+URB *
+XhcGetPendingUrb (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  EVT_TRB_TRANSFER    *EvtTrb
+  )
+{
+  if ((EvtTrb->SlotId == 0) || (EvtTrb->EndpointId == 0)) {
+    return NULL;
   }
 
-  return FALSE;
+  return Xhc->UsbDevContext[EvtTrb->SlotId].PendingUrb[EvtTrb->EndpointId - 1];
 }
 
 /**
-  Check the URB's execution result and update the URB's
-  result accordingly.
+  Drain all new events from the event ring in one pass and update the
+  URBs they complete, then advance the event ring dequeue pointer.
 
-  @param  Xhc             The XHCI Instance.
-  @param  Urb             The URB to check result.
+  Transfer events are dispatched to the URB pending on the endpoint they
+  report, command completion events to the command URB being executed.
 
-  @return Whether the result of URB transfer is finialized.
+  @param  Xhc             The XHCI Instance.
+  @param  Urb             The URB being executed, or NULL if it's the async
+                          transfer monitor draining the ring.
 
 **/
-BOOLEAN
-XhcCheckUrbResult (
+VOID
+XhcProcessEventRing (
   IN  USB_XHCI_INSTANCE   *Xhc,
-  IN  URB                 *Urb
+  IN  URB                 *Urb OPTIONAL
   )
 {
   EVT_TRB_TRANSFER        *EvtTrb;
@@ -1083,22 +1126,9 @@ XhcCheckUrbResult (
   UINT32                  Low;
   EFI_PHYSICAL_ADDRESS    PhyAddr;
 
-  ASSERT ((Xhc != NULL) && (Urb != NULL));
-
-  Status   = EFI_SUCCESS;
+  EvtTrb   = NULL;
   AsyncUrb = NULL;
 
-  if (Urb->Finished) {
-    goto EXIT;
-  }
-
-  EvtTrb = NULL;
-
-  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
-    Urb->Result |= EFI_USB_ERR_SYSTEM;
-    goto EXIT;
-  }
-
   //
   // Traverse the event ring to find out all new events from the previous check.
   //
@@ -1109,7 +1139,7 @@ XhcCheckUrbResult (
       //
       // All new events are handled, return directly.
       //
-      goto EXIT;
+      break;
     }
 
     //
@@ -1118,7 +1148,7 @@ XhcCheckUrbResult (
     if ((EvtTrb->Type != TRB_TYPE_COMMAND_COMPLT_EVENT) && (EvtTrb->Type != TRB_TYPE_TRANS_EVENT)) {
       continue;
     }
-    
+
     //
     // Need convert pci device address to host address
     //
@@ -1131,38 +1161,52 @@ XhcCheckUrbResult (
     // This way is used to avoid that those completed async transfer events don't get
     // handled in time and are flushed by newer coming events.
     //
-    if (IsTransferRingTrb (TRBPtr, Urb)) {
-      CheckedUrb = Urb;
-    } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {    
-      CheckedUrb = AsyncUrb;
-    } else {
-      continue;
+    CheckedUrb = NULL;
+    if (FeaturePcdGet (PcdXhciPollOptimization) && (EvtTrb->Type == TRB_TYPE_TRANS_EVENT)) {
+      CheckedUrb = XhcGetPendingUrb (Xhc, EvtTrb);
+      if ((CheckedUrb != NULL) && !IsTransferRingTrb (TRBPtr, CheckedUrb)) {
+        CheckedUrb = NULL;
+      }
     }
-  
+
+    if (CheckedUrb == NULL) {
+      if ((Urb != NULL) && IsTransferRingTrb (TRBPtr, Urb)) {
+        CheckedUrb = Urb;
+      } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {
+        CheckedUrb = AsyncUrb;
+      } else {
+        continue;
+      }
+    }
+
+    if ((EvtTrb->Type == TRB_TYPE_TRANS_EVENT) && (EvtTrb->SlotId != 0)) {
+      Xhc->UsbDevContext[EvtTrb->SlotId].EventCount++;
+    }
+
     switch (EvtTrb->Completecode) {
       case TRB_COMPLETION_STALL_ERROR:
         CheckedUrb->Result  |= EFI_USB_ERR_STALL;
         CheckedUrb->Finished = TRUE;
         DEBUG ((EFI_D_ERROR, "XhcCheckUrbResult: STALL_ERROR! Completecode = %x\n",EvtTrb->Completecode));
-        goto EXIT;
+        continue;
 
       case TRB_COMPLETION_BABBLE_ERROR:
         CheckedUrb->Result  |= EFI_USB_ERR_BABBLE;
         CheckedUrb->Finished = TRUE;
         DEBUG ((EFI_D_ERROR, "XhcCheckUrbResult: BABBLE_ERROR! Completecode = %x\n",EvtTrb->Completecode));
-        goto EXIT;
+        continue;
 
       case TRB_COMPLETION_DATA_BUFFER_ERROR:
         CheckedUrb->Result  |= EFI_USB_ERR_BUFFER;
         CheckedUrb->Finished = TRUE;
         DEBUG ((EFI_D_ERROR, "XhcCheckUrbResult: ERR_BUFFER! Completecode = %x\n",EvtTrb->Completecode));
-        goto EXIT;
+        continue;
 
       case TRB_COMPLETION_USB_TRANSACTION_ERROR:
         CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
         CheckedUrb->Finished = TRUE;
         DEBUG ((EFI_D_ERROR, "XhcCheckUrbResult: TRANSACTION_ERROR! Completecode = %x\n",EvtTrb->Completecode));
-        goto EXIT;
+        continue;
 
       case TRB_COMPLETION_SHORT_PACKET:
       case TRB_COMPLETION_SUCCESS:
@@ -1183,7 +1227,7 @@ XhcCheckUrbResult (
         DEBUG ((EFI_D_ERROR, "Transfer Default Error Occur! Completecode = 0x%x!\n",EvtTrb->Completecode));
         CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
         CheckedUrb->Finished = TRUE;
-        goto EXIT;
+        continue;
     }
 
     //
@@ -1203,8 +1247,6 @@ XhcCheckUrbResult (
     }
   }
 
-EXIT:
-
   //
   // Advance event ring to last available entry
   //
@@ -1225,6 +1267,36 @@ EXIT:
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET, XHC_LOW_32BIT (PhyAddr) | BIT3);
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4, XHC_HIGH_32BIT (PhyAddr));
   }
+}
+
+/**
+  Check the URB's execution result and update the URB's
+  result accordingly.
+
+  @param  Xhc             The XHCI Instance.
+  @param  Urb             The URB to check result.
+
+  @return Whether the result of URB transfer is finialized.
+
+**/
+BOOLEAN
+XhcCheckUrbResult (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 *Urb
+  )
+{
+  ASSERT ((Xhc != NULL) && (Urb != NULL));
+
+  if (Urb->Finished) {
+    return TRUE;
+  }
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    Urb->Result |= EFI_USB_ERR_SYSTEM;
+    return Urb->Finished;
+  }
+
+  XhcProcessEventRing (Xhc, Urb);
 
   return Urb->Finished;
 }
@@ -1252,8 +1324,10 @@ XhcExecTransfer (
   )
 {
   EFI_STATUS              Status;
-  UINTN                   Index;
-  UINT64                  Loop;
+  UINT64                  Elapsed;
+  UINT64                  Limit;
+  UINTN                   Interval;
+  UINTN                   Polls;
   UINT8                   SlotId;
   UINT8                   Dci;
   BOOLEAN                 Finished;
@@ -1271,22 +1345,42 @@ XhcExecTransfer (
   }
 
   Status = EFI_SUCCESS;
-  Loop   = Timeout * XHC_1_MILLISECOND;
+  Limit  = Timeout * XHC_1_MILLISECOND;
   if (Timeout == 0) {
-    Loop = 0xFFFFFFFF;
+    Limit = 0xFFFFFFFF;
   }
 
   XhcRingDoorBell (Xhc, SlotId, Dci);
 
-  for (Index = 0; Index < Loop; Index++) {
+  //
+  // Poll the event ring every microsecond first so that short transfers
+  // complete with the least latency, and back off while the transfer is
+  // still pending to save the register and event ring accesses.
+  //
+  Finished = FALSE;
+  Elapsed  = 0;
+  Interval = XHC_1_MICROSECOND;
+  Polls    = 0;
+  while (Elapsed < Limit) {
     Finished = XhcCheckUrbResult (Xhc, Urb);
+    Polls++;
     if (Finished) {
       break;
     }
-    gBS->Stall (XHC_1_MICROSECOND);
+    gBS->Stall (Interval);
+    Elapsed += Interval;
+
+    if (FeaturePcdGet (PcdXhciPollOptimization) &&
+        ((Polls % XHC_POLL_BACKOFF_COUNT) == 0) && (Interval < XHC_POLL_MAX_INTERVAL)) {
+      Interval <<= 1;
+    }
   }
 
-  if (Index == Loop) {
+  if (SlotId != 0) {
+    Xhc->UsbDevContext[SlotId].PollCount += Polls;
+  }
+
+  if (!Finished) {
     Urb->Result = EFI_USB_ERR_TIMEOUT;
     Status      = EFI_TIMEOUT;
   } else if (Urb->Result != EFI_USB_NOERROR) {
@@ -1467,11 +1561,27 @@ XhcMonitorAsyncRequests (
   UINT8                   SlotId;
   EFI_STATUS              Status;
   EFI_TPL                 OldTpl;
+  BOOLEAN                 HcError;
+  BOOLEAN                 Completed;
+  UINT64                  Interval;
 
   OldTpl = gBS->RaiseTPL (XHC_TPL);
 
   Xhc    = (USB_XHCI_INSTANCE*) Context;
 
+  //
+  // Drain the event ring once for all the async transfers, the events
+  // are dispatched to their URBs by the endpoint they report.
+  //
+  HcError   = FALSE;
+  Completed = FALSE;
+  if (!IsListEmpty (&Xhc->AsyncIntTransfers)) {
+    HcError = (BOOLEAN) (XhcIsHalt (Xhc) || XhcIsSysError (Xhc));
+    if (!HcError) {
+      XhcProcessEventRing (Xhc, NULL);
+    }
+  }
+
   EFI_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->AsyncIntTransfers) {
     Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
 
@@ -1483,16 +1593,20 @@ XhcMonitorAsyncRequests (
       continue;
     }
 
+    Xhc->UsbDevContext[SlotId].PollCount++;
+    if (HcError && !Urb->Finished) {
+      Urb->Result |= EFI_USB_ERR_SYSTEM;
+    }
+
     //
-    // Check the result of URB execution. If it is still
-    // active, check the next one.
+    // If the URB is still active, check the next one.
     //
-    XhcCheckUrbResult (Xhc, Urb);
-
     if (!Urb->Finished) {
       continue;
     }
 
+    Completed = TRUE;
+
     //
     // Flush any PCI posted write transactions from a PCI host
     // bridge to system memory.
@@ -1547,6 +1661,29 @@ XhcMonitorAsyncRequests (
 
     XhcUpdateAsyncRequest (Xhc, Urb);
   }
+
+  //
+  // Slow down the monitor timer while no async transfer completes, and
+  // speed it up again as soon as one does.
+  //
+  Interval = Xhc->PollInterval;
+  if (!FeaturePcdGet (PcdXhciPollOptimization)) {
+    Interval = XHC_ASYNC_TIMER_INTERVAL;
+  } else if (Completed) {
+    Xhc->PollIdleTicks = 0;
+    Interval           = XHC_ASYNC_TIMER_INTERVAL;
+  } else if (++Xhc->PollIdleTicks >= XHC_ASYNC_IDLE_TICKS) {
+    Xhc->PollIdleTicks = 0;
+    if (Interval < XHC_ASYNC_TIMER_MAX_INTERVAL) {
+      Interval = MIN (Interval * 2, XHC_ASYNC_TIMER_MAX_INTERVAL);
+    }
+  }
+
+  if (Interval != Xhc->PollInterval) {
+    Xhc->PollInterval = Interval;
+    gBS->SetTimer (Xhc->PollTimer, TimerPeriodic, Interval);
+  }
+
   gBS->RestoreTPL (OldTpl);
 }
 
@@ -2444,6 +2581,11 @@ XhcDisableSlotCmd (
   // asynchronous interrupt pipe after the device is disabled. It needs the device address mapping info to
   // remove urb from XHCI's asynchronous transfer list.
   //
+  DEBUG ((EFI_D_INFO, "XhcDisableSlotCmd: Slot %d polled %ld times for %ld transfer events\n",
+    SlotId, Xhc->UsbDevContext[SlotId].PollCount, Xhc->UsbDevContext[SlotId].EventCount));
+  ZeroMem (Xhc->UsbDevContext[SlotId].PendingUrb, sizeof (Xhc->UsbDevContext[SlotId].PendingUrb));
+  Xhc->UsbDevContext[SlotId].PollCount  = 0;
+  Xhc->UsbDevContext[SlotId].EventCount = 0;
   Xhc->UsbDevContext[SlotId].Enabled = FALSE;
   Xhc->UsbDevContext[SlotId].SlotId  = 0;
 
@@ -2551,6 +2693,11 @@ XhcDisableSlotCmd64 (
   // asynchronous interrupt pipe after the device is disabled. It needs the device address mapping info to
   // remove urb from XHCI's asynchronous transfer list.
   //
+  DEBUG ((EFI_D_INFO, "XhcDisableSlotCmd64: Slot %d polled %ld times for %ld transfer events\n",
+    SlotId, Xhc->UsbDevContext[SlotId].PollCount, Xhc->UsbDevContext[SlotId].EventCount));
+  ZeroMem (Xhc->UsbDevContext[SlotId].PendingUrb, sizeof (Xhc->UsbDevContext[SlotId].PendingUrb));
+  Xhc->UsbDevContext[SlotId].PollCount  = 0;
+  Xhc->UsbDevContext[SlotId].EventCount = 0;
   Xhc->UsbDevContext[SlotId].Enabled = FALSE;
   Xhc->UsbDevContext[SlotId].SlotId  = 0;
 
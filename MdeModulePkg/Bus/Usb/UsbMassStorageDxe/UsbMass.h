@@ -31,12 +31,14 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/UefiLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/PcdLib.h>
 
 typedef struct _USB_MASS_TRANSPORT USB_MASS_TRANSPORT;
 typedef struct _USB_MASS_DEVICE    USB_MASS_DEVICE;
 
 #include "UsbMassBot.h"
 #include "UsbMassCbi.h"
+#include "UsbMassUas.h"
 #include "UsbMassBoot.h"
 #include "UsbMassDiskInfo.h"
 #include "UsbMassImpl.h"
@@ -159,7 +161,7 @@ EFI_STATUS
 ///
 /// This structure contains information necessary to select the
 /// proper transport protocol. The mass storage class defines
-/// two transport protocols. One is the CBI, and the other is BOT.
+/// three transport protocols: the CBI, the BOT and the UAS.
 /// CBI is being obseleted. The design is made modular by this
 /// structure so that the CBI protocol can be easily removed when
 /// it is no longer necessary.
@@ -188,6 +190,7 @@ struct _USB_MASS_DEVICE {
   EFI_DISK_INFO_PROTOCOL    DiskInfo;
   USB_BOOT_INQUIRY_DATA     InquiryData;
   BOOLEAN                   Cdb16Byte;
+  UINT32                    MaxTransferSize; ///< Max bytes carried by one READ/WRITE command
 };
 
 #endif
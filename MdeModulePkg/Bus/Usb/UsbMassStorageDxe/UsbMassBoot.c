@@ -770,6 +770,32 @@ ON_ERROR:
 }
 
 
+/**
+  Get the max number of blocks carried by one READ/WRITE command.
+
+  The limit follows the max carried size of the device, but never falls below
+  USB_BOOT_IO_BLOCKS and never exceeds the 16 bit transfer length of READ10.
+
+  @param  UsbMass                The USB mass storage device
+
+  @return The max number of blocks carried by one READ/WRITE command.
+
+**/
+UINTN
+UsbBootGetMaxTransferBlocks (
+  IN USB_MASS_DEVICE        *UsbMass
+  )
+{
+  UINTN                     MaxBlock;
+
+  MaxBlock = UsbMass->MaxTransferSize / UsbMass->BlockIoMedia.BlockSize;
+  if (MaxBlock < USB_BOOT_IO_BLOCKS) {
+    MaxBlock = USB_BOOT_IO_BLOCKS;
+  }
+
+  return MIN (MaxBlock, MAX_UINT16);
+}
+
 /**
   Read some blocks from the device.
 
@@ -806,7 +832,7 @@ UsbBootReadBlocks (
     // on the device. We must split the total block because the READ10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) MIN (TotalBlock, UsbBootGetMaxTransferBlocks (UsbMass));
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -882,7 +908,7 @@ UsbBootWriteBlocks (
     // on the device. We must split the total block because the WRITE10
     // command only has 16 bit transfer length (in the unit of block).
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) MIN (TotalBlock, UsbBootGetMaxTransferBlocks (UsbMass));
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -956,7 +982,7 @@ UsbBootReadBlocks16 (
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) MIN (TotalBlock, UsbBootGetMaxTransferBlocks (UsbMass));
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -1030,7 +1056,7 @@ UsbBootWriteBlocks16 (
     //
     // Split the total blocks into smaller pieces.
     //
-    Count     = (UINT16)((TotalBlock < USB_BOOT_IO_BLOCKS) ? TotalBlock : USB_BOOT_IO_BLOCKS);
+    Count     = (UINT16) MIN (TotalBlock, UsbBootGetMaxTransferBlocks (UsbMass));
     ByteSize  = (UINT32)Count * BlockSize;
 
     //
@@ -1069,6 +1095,53 @@ UsbBootWriteBlocks16 (
   return Status;
 }
 
+/**
+  Get the max bytes carried by one READ/WRITE command of the USB mass storage device.
+
+  The speed of the device isn't reported by the USB I/O Protocol, so it is
+  told from the max packet size of the bulk endpoints of the active setting.
+
+  @param  UsbIo                  The USB I/O Protocol instance
+
+  @return The max bytes carried by one READ/WRITE command.
+
+**/
+UINT32
+UsbBootGetMaxTransferSize (
+  IN EFI_USB_IO_PROTOCOL    *UsbIo
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR   EndPoint;
+  EFI_STATUS                    Status;
+  UINT16                        MaxPacketSize;
+  UINT8                         Index;
+
+  MaxPacketSize = 0;
+
+  if (!FeaturePcdGet (PcdUsbMassLargeTransfer)) {
+    return USB_BOOT_MAX_CARRY_SIZE;
+  }
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+  if (!EFI_ERROR (Status)) {
+    for (Index = 0; Index < Interface.NumEndpoints; Index++) {
+      Status = UsbIo->UsbGetEndpointDescriptor (UsbIo, Index, &EndPoint);
+      if (!EFI_ERROR (Status) && USB_IS_BULK_ENDPOINT (EndPoint.Attributes)) {
+        MaxPacketSize = MAX (MaxPacketSize, EndPoint.MaxPacketSize);
+      }
+    }
+  }
+
+  if (MaxPacketSize >= 1024) {
+    return USB_BOOT_MAX_CARRY_SIZE_SS;
+  } else if (MaxPacketSize >= 512) {
+    return USB_BOOT_MAX_CARRY_SIZE_HS;
+  }
+
+  return USB_BOOT_MAX_CARRY_SIZE;
+}
+
 /**
   Use the USB clear feature control transfer to clear the endpoint stall condition.
 
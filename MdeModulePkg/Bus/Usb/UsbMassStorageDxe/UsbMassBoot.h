@@ -64,10 +64,21 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define USB_PDT_SIMPLE_DIRECT           0x0E       ///< Simplified direct access device
 
 //
-// Other parameters, Max carried size is 512B * 128 = 64KB
+// Other parameters, Min carried size is 512B * 128 = 64KB
 //
 #define USB_BOOT_IO_BLOCKS              128
 
+//
+// Max carried size of a READ/WRITE command, chosen by the bulk max packet
+// size of the device. Full speed devices keep the 64KB. High speed devices
+// carry 120KB, which old USB keys are known to handle. SuperSpeed devices
+// carry 1MB, their data phase is queued to the host controller as a single
+// transfer.
+//
+#define USB_BOOT_MAX_CARRY_SIZE         SIZE_64KB
+#define USB_BOOT_MAX_CARRY_SIZE_HS      (240 * 512)
+#define USB_BOOT_MAX_CARRY_SIZE_SS      SIZE_1MB
+
 //
 // Retry mass command times, set by experience
 //
@@ -351,6 +362,19 @@ UsbBootWriteBlocks16 (
   );
 
 
+/**
+  Get the max bytes carried by one READ/WRITE command of the USB mass storage device.
+
+  @param  UsbIo                  The USB I/O Protocol instance
+
+  @return The max bytes carried by one READ/WRITE command.
+
+**/
+UINT32
+UsbBootGetMaxTransferSize (
+  IN EFI_USB_IO_PROTOCOL    *UsbIo
+  );
+
 /**
   Use the USB clear feature control transfer to clear the endpoint stall condition.
 
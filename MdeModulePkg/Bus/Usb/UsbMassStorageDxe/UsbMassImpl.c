@@ -14,7 +14,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "UsbMass.h"
 
-#define USB_MASS_TRANSPORT_COUNT    3
+#define USB_MASS_TRANSPORT_COUNT    4
 //
 // Array of USB transport interfaces. 
 //
@@ -22,6 +22,7 @@ USB_MASS_TRANSPORT *mUsbMassTransport[USB_MASS_TRANSPORT_COUNT] = {
   &mUsbCbi0Transport,
   &mUsbCbi1Transport,
   &mUsbBotTransport,
+  &mUsbUasTransport,
 };
 
 EFI_DRIVER_BINDING_PROTOCOL gUSBMassDriverBinding = {
@@ -375,6 +376,7 @@ UsbMassInitMedia (
   @param  Transport       The pointer to pointer to USB_MASS_TRANSPORT.
   @param  Context         The parameter for USB_MASS_DEVICE.Context.
   @param  MaxLun          Get the MaxLun if is BOT dev.
+  @param  MaxTransferSize Get the max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS     The initialization is successful.
   @retval EFI_UNSUPPORTED No matching transport protocol is found.
@@ -387,7 +389,8 @@ UsbMassInitTransport (
   IN  EFI_HANDLE                   Controller,
   OUT USB_MASS_TRANSPORT           **Transport,
   OUT VOID                         **Context,
-  OUT UINT8                        *MaxLun
+  OUT UINT8                        *MaxLun,
+  OUT UINT32                       *MaxTransferSize
   )
 {
   EFI_USB_IO_PROTOCOL           *UsbIo;
@@ -415,13 +418,22 @@ UsbMassInitTransport (
   
   Status = EFI_UNSUPPORTED;
 
+  //
+  // A UAS device usually presents BOT in its default alternate setting and
+  // UAS in another one. Prefer UAS, and keep BOT if it can't be used.
+  //
+  if (Interface.InterfaceProtocol == USB_MASS_STORE_BOT) {
+    *Transport = &mUsbUasTransport;
+    Status     = (*Transport)->Init (UsbIo, Context);
+  }
+
   //
   // Traverse the USB_MASS_TRANSPORT arrary and try to find the
   // matching transport protocol.
   // If not found, return EFI_UNSUPPORTED.
   // If found, execute USB_MASS_TRANSPORT.Init() to initialize the transport context.
   //
-  for (Index = 0; Index < USB_MASS_TRANSPORT_COUNT; Index++) {
+  for (Index = 0; EFI_ERROR (Status) && (Index < USB_MASS_TRANSPORT_COUNT); Index++) {
     *Transport = mUsbMassTransport[Index];
 
     if (Interface.InterfaceProtocol == (*Transport)->Protocol) {
@@ -443,6 +455,11 @@ UsbMassInitTransport (
     (*Transport)->GetMaxLun (*Context, MaxLun);
   }
 
+  //
+  // Get the command size after the transport selects its alternate setting.
+  //
+  *MaxTransferSize = UsbBootGetMaxTransferSize (UsbIo);
+
 ON_EXIT:
   gBS->CloseProtocol (
          Controller,
@@ -462,6 +479,7 @@ ON_EXIT:
   @param  Context              Parameter for USB_MASS_DEVICE.Context.
   @param  DevicePath           The remaining device path.
   @param  MaxLun               The max LUN number.
+  @param  MaxTransferSize      The max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS          At least one LUN is initialized successfully.
   @retval EFI_NOT_FOUND        Fail to initialize any of multiple LUNs.
@@ -474,7 +492,8 @@ UsbMassInitMultiLun (
   IN USB_MASS_TRANSPORT            *Transport,
   IN VOID                          *Context,
   IN EFI_DEVICE_PATH_PROTOCOL      *DevicePath,
-  IN UINT8                         MaxLun
+  IN UINT8                         MaxLun,
+  IN UINT32                        MaxTransferSize
   )
 {
   USB_MASS_DEVICE                  *UsbMass;
@@ -506,6 +525,7 @@ UsbMassInitMultiLun (
     UsbMass->Transport            = Transport;
     UsbMass->Context              = Context;
     UsbMass->Lun                  = Index;
+    UsbMass->MaxTransferSize      = MaxTransferSize;
     
     //
     // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -600,6 +620,7 @@ UsbMassInitMultiLun (
   @param  Controller      The device to initialize.
   @param  Transport       Pointer to USB_MASS_TRANSPORT.
   @param  Context         Parameter for USB_MASS_DEVICE.Context.
+  @param  MaxTransferSize The max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS     Initialization succeeds.
   @retval Other           Initialization fails.
@@ -610,7 +631,8 @@ UsbMassInitNonLun (
   IN EFI_DRIVER_BINDING_PROTOCOL   *This,
   IN EFI_HANDLE                    Controller,
   IN USB_MASS_TRANSPORT            *Transport,
-  IN VOID                          *Context
+  IN VOID                          *Context,
+  IN UINT32                        MaxTransferSize
   )
 {
   USB_MASS_DEVICE             *UsbMass;
@@ -646,6 +668,7 @@ UsbMassInitNonLun (
   UsbMass->OpticalStorage       = FALSE;
   UsbMass->Transport            = Transport;
   UsbMass->Context              = Context;
+  UsbMass->MaxTransferSize      = MaxTransferSize;
   
   //
   // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -795,6 +818,7 @@ USBMassDriverBindingStart (
   EFI_DEVICE_PATH_PROTOCOL      *DevicePath;
   VOID                          *Context;
   UINT8                         MaxLun;
+  UINT32                        MaxTransferSize;
   EFI_STATUS                    Status;
   EFI_USB_IO_PROTOCOL           *UsbIo; 
   EFI_TPL                       OldTpl;
@@ -804,8 +828,9 @@ USBMassDriverBindingStart (
   Transport = NULL;
   Context   = NULL;
   MaxLun    = 0;
+  MaxTransferSize = 0;
 
-  Status = UsbMassInitTransport (This, Controller, &Transport, &Context, &MaxLun);
+  Status = UsbMassInitTransport (This, Controller, &Transport, &Context, &MaxLun, &MaxTransferSize);
 
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "USBMassDriverBindingStart: UsbMassInitTransport (%r)\n", Status));
@@ -815,7 +840,7 @@ USBMassDriverBindingStart (
     //
     // Initialize data for device that does not support multiple LUNSs.
     //
-    Status = UsbMassInitNonLun (This, Controller, Transport, Context);
+    Status = UsbMassInitNonLun (This, Controller, Transport, Context, MaxTransferSize);
     if (EFI_ERROR (Status)) { 
       DEBUG ((EFI_D_ERROR, "USBMassDriverBindingStart: UsbMassInitNonLun (%r)\n", Status));
     }
@@ -861,7 +886,7 @@ USBMassDriverBindingStart (
     // Initialize data for device that supports multiple LUNs.
     // EFI_SUCCESS is returned if at least 1 LUN is initialized successfully.
     //
-    Status = UsbMassInitMultiLun (This, Controller, Transport, Context, DevicePath, MaxLun);
+    Status = UsbMassInitMultiLun (This, Controller, Transport, Context, DevicePath, MaxLun, MaxTransferSize);
     if (EFI_ERROR (Status)) {
       gBS->CloseProtocol (
               Controller,
@@ -0,0 +1,675 @@
+/** @file
+  Implementation of the USB Attached SCSI transport protocol, according to
+  Universal Serial Bus Mass Storage Class - USB Attached SCSI Protocol (UASP), Revision 1.0.
+  Only the high speed protocol without bulk streams is implemented. The commands
+  are issued one at a time, so a single tag is outstanding.
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "UsbMass.h"
+
+//
+// Definition of USB UAS Transport Protocol
+//
+USB_MASS_TRANSPORT mUsbUasTransport = {
+  USB_MASS_STORE_UAS,
+  UsbUasInit,
+  UsbUasExecCommand,
+  UsbUasResetDevice,
+  NULL,
+  UsbUasCleanUp
+};
+
+/**
+  Select the alternate setting of the UAS interface.
+
+  The USB bus driver switches the endpoints of the USB I/O Protocol instance
+  when it sees the SET_INTERFACE request.
+
+  @param  UsbUas                The USB UAS device
+  @param  AlternateSetting      The alternate setting to select
+
+  @retval EFI_SUCCESS           The alternate setting is selected.
+  @retval Others                Failed to select the alternate setting.
+
+**/
+EFI_STATUS
+UsbUasSelectSetting (
+  IN USB_UAS_PROTOCOL         *UsbUas,
+  IN UINT8                    AlternateSetting
+  )
+{
+  EFI_USB_DEVICE_REQUEST      Request;
+  EFI_STATUS                  Status;
+  UINT32                      Result;
+  UINT32                      Timeout;
+
+  Request.RequestType = 0x01;
+  Request.Request     = USB_REQ_SET_INTERFACE;
+  Request.Value       = AlternateSetting;
+  Request.Index       = UsbUas->Interface.InterfaceNumber;
+  Request.Length      = 0;
+  Timeout             = USB_UAS_CONTROL_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbControlTransfer (
+                            UsbUas->UsbIo,
+                            &Request,
+                            EfiUsbNoData,
+                            Timeout,
+                            NULL,
+                            0,
+                            &Result
+                            );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return UsbUas->UsbIo->UsbGetInterfaceDescriptor (UsbUas->UsbIo, &UsbUas->Interface);
+}
+
+/**
+  Locate the UAS alternate setting of the interface and its four pipes.
+
+  The USB I/O Protocol only reports the endpoints of the active setting, and
+  none of the class specific descriptors. So the whole configuration descriptor
+  is read to find the Pipe Usage descriptors.
+
+  @param  UsbUas                The USB UAS device
+
+  @retval EFI_SUCCESS           The UAS alternate setting and its pipes are found.
+  @retval EFI_UNSUPPORTED       The interface has no usable UAS alternate setting.
+  @retval Others                Failed to read the configuration descriptor.
+
+**/
+EFI_STATUS
+UsbUasGetPipes (
+  IN OUT USB_UAS_PROTOCOL       *UsbUas
+  )
+{
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  EFI_USB_DEVICE_DESCRIPTOR     DevDesc;
+  EFI_USB_CONFIG_DESCRIPTOR     ConfigDesc;
+  EFI_USB_DEVICE_REQUEST        Request;
+  EFI_USB_INTERFACE_DESCRIPTOR  *IfDesc;
+  EFI_USB_ENDPOINT_DESCRIPTOR   *EpDesc;
+  USB_UAS_PIPE_USAGE_DESCRIPTOR *PipeDesc;
+  UINT8                         *Buffer;
+  UINT8                         *Desc;
+  UINTN                         Offset;
+  UINT8                         Index;
+  UINT8                         Endpoint;
+  BOOLEAN                       InUasSetting;
+  UINT32                        Result;
+  UINT32                        Timeout;
+  EFI_STATUS                    Status;
+
+  UsbIo = UsbUas->UsbIo;
+
+  Status = UsbIo->UsbGetDeviceDescriptor (UsbIo, &DevDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = UsbIo->UsbGetConfigDescriptor (UsbIo, &ConfigDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Buffer = AllocatePool (ConfigDesc.TotalLength);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Read the configuration descriptors until the active one is found.
+  //
+  Status  = EFI_NOT_FOUND;
+  Timeout = USB_UAS_CONTROL_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+  for (Index = 0; Index < DevDesc.NumConfigurations; Index++) {
+    Request.RequestType = 0x80;
+    Request.Request     = USB_REQ_GET_DESCRIPTOR;
+    Request.Value       = (UINT16) ((USB_DESC_TYPE_CONFIG << 8) | Index);
+    Request.Index       = 0;
+    Request.Length      = ConfigDesc.TotalLength;
+
+    Status = UsbIo->UsbControlTransfer (
+                      UsbIo,
+                      &Request,
+                      EfiUsbDataIn,
+                      Timeout,
+                      Buffer,
+                      ConfigDesc.TotalLength,
+                      &Result
+                      );
+    if (!EFI_ERROR (Status) &&
+        (((EFI_USB_CONFIG_DESCRIPTOR *) Buffer)->ConfigurationValue == ConfigDesc.ConfigurationValue)) {
+      break;
+    }
+
+    Status = EFI_NOT_FOUND;
+  }
+
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  //
+  // Walk the descriptors of the UAS alternate setting of this interface. Each
+  // endpoint descriptor is followed by a Pipe Usage descriptor, possibly with a
+  // SuperSpeed endpoint companion descriptor in between.
+  //
+  InUasSetting = FALSE;
+  Endpoint     = 0;
+
+  for (Offset = 0; Offset + 2 <= ConfigDesc.TotalLength; Offset += Desc[0]) {
+    Desc = Buffer + Offset;
+    if ((Desc[0] < 2) || (Offset + Desc[0] > ConfigDesc.TotalLength)) {
+      break;
+    }
+
+    if (Desc[1] == USB_DESC_TYPE_INTERFACE) {
+      if (USB_UAS_PIPES_FOUND (UsbUas)) {
+        break;
+      }
+
+      IfDesc       = (EFI_USB_INTERFACE_DESCRIPTOR *) Desc;
+      InUasSetting = (BOOLEAN) ((IfDesc->InterfaceNumber == UsbUas->Interface.InterfaceNumber) &&
+                                (IfDesc->InterfaceClass == USB_MASS_STORE_CLASS) &&
+                                (IfDesc->InterfaceProtocol == USB_MASS_STORE_UAS));
+      if (InUasSetting) {
+        UsbUas->AlternateSetting = IfDesc->AlternateSetting;
+      }
+      Endpoint = 0;
+
+    } else if (InUasSetting && (Desc[1] == USB_DESC_TYPE_ENDPOINT)) {
+      EpDesc   = (EFI_USB_ENDPOINT_DESCRIPTOR *) Desc;
+      Endpoint = 0;
+      if (USB_IS_BULK_ENDPOINT (EpDesc->Attributes)) {
+        Endpoint = EpDesc->EndpointAddress;
+        UsbUas->MaxPacketSize = MAX (UsbUas->MaxPacketSize, ReadUnaligned16 (&EpDesc->MaxPacketSize));
+      }
+
+    } else if (InUasSetting && (Endpoint != 0) &&
+               (Desc[1] == USB_UAS_DESC_TYPE_PIPE_USAGE) &&
+               (Desc[0] >= sizeof (USB_UAS_PIPE_USAGE_DESCRIPTOR))) {
+      PipeDesc = (USB_UAS_PIPE_USAGE_DESCRIPTOR *) Desc;
+      switch (PipeDesc->PipeId) {
+      case USB_UAS_PIPE_ID_COMMAND:
+        if (USB_IS_OUT_ENDPOINT (Endpoint)) {
+          UsbUas->CommandEndpoint = Endpoint;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_STATUS:
+        if (USB_IS_IN_ENDPOINT (Endpoint)) {
+          UsbUas->StatusEndpoint = Endpoint;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_DATA_IN:
+        if (USB_IS_IN_ENDPOINT (Endpoint)) {
+          UsbUas->DataInEndpoint = Endpoint;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_DATA_OUT:
+        if (USB_IS_OUT_ENDPOINT (Endpoint)) {
+          UsbUas->DataOutEndpoint = Endpoint;
+        }
+        break;
+
+      default:
+        break;
+      }
+      Endpoint = 0;
+    }
+  }
+
+  Status = USB_UAS_PIPES_FOUND (UsbUas) ? EFI_SUCCESS : EFI_UNSUPPORTED;
+
+ON_EXIT:
+  FreePool (Buffer);
+  return Status;
+}
+
+/**
+  Initializes USB UAS protocol.
+
+  This function initializes the USB mass storage class UAS protocol. A device
+  whose current setting is BOT is switched to its UAS alternate setting if
+  it has one. It will save its context which is a USB_UAS_PROTOCOL structure
+  in the Context if Context isn't NULL.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL       *UsbIo,
+  OUT VOID                      **Context OPTIONAL
+  )
+{
+  USB_UAS_PROTOCOL              *UsbUas;
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_STATUS                    Status;
+
+  if (!FeaturePcdGet (PcdUsbMassUasSupport)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Only check the active setting if the context isn't requested,
+  // the device is left untouched.
+  //
+  if (Context == NULL) {
+    if ((Interface.InterfaceProtocol != USB_MASS_STORE_UAS) || (Interface.NumEndpoints < 4)) {
+      return EFI_UNSUPPORTED;
+    }
+    return EFI_SUCCESS;
+  }
+
+  if ((Interface.InterfaceProtocol != USB_MASS_STORE_UAS) &&
+      (Interface.InterfaceProtocol != USB_MASS_STORE_BOT)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UsbUas = AllocateZeroPool (sizeof (USB_UAS_PROTOCOL));
+  ASSERT (UsbUas != NULL);
+
+  UsbUas->UsbIo = UsbIo;
+  CopyMem (&UsbUas->Interface, &Interface, sizeof (Interface));
+
+  Status = UsbUasGetPipes (UsbUas);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  if (UsbUas->MaxPacketSize >= USB_UAS_SUPER_SPEED_MAX_PACKET) {
+    DEBUG ((EFI_D_INFO, "UsbUasInit: SuperSpeed UAS needs bulk streams, not supported\n"));
+    Status = EFI_UNSUPPORTED;
+    goto ON_ERROR;
+  }
+
+  if (Interface.AlternateSetting != UsbUas->AlternateSetting) {
+    Status = UsbUasSelectSetting (UsbUas, UsbUas->AlternateSetting);
+    if (EFI_ERROR (Status) || (UsbUas->Interface.InterfaceProtocol != USB_MASS_STORE_UAS)) {
+      DEBUG ((EFI_D_ERROR, "UsbUasInit: failed to select alternate setting %d (%r)\n", UsbUas->AlternateSetting, Status));
+      UsbUasSelectSetting (UsbUas, Interface.AlternateSetting);
+      Status = EFI_UNSUPPORTED;
+      goto ON_ERROR;
+    }
+  }
+
+  //
+  // The USB UAS protocol uses the tag to match the command and its status.
+  //
+  UsbUas->Tag = 0x01;
+
+  *Context = UsbUas;
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  FreePool (UsbUas);
+  return Status;
+}
+
+/**
+  Send the Command IU to the device using the command pipe.
+
+  @param  UsbUas                The USB UAS device
+  @param  Cmd                   The command to transfer to device
+  @param  CmdLen                The length of the command
+  @param  Lun                   The number of logic unit
+  @param  Tag                   The tag of the command
+
+  @retval EFI_SUCCESS           The command is sent to the device.
+  @retval Others                Failed to send the command to device
+
+**/
+EFI_STATUS
+UsbUasSendCommand (
+  IN USB_UAS_PROTOCOL         *UsbUas,
+  IN UINT8                    *Cmd,
+  IN UINT8                    CmdLen,
+  IN UINT8                    Lun,
+  IN UINT16                   Tag
+  )
+{
+  USB_UAS_COMMAND_IU        CmdIu;
+  EFI_STATUS                Status;
+  UINT32                    Result;
+  UINTN                     DataLen;
+  UINTN                     Timeout;
+
+  ASSERT ((CmdLen > 0) && (CmdLen <= USB_UAS_MAX_CMDLEN));
+
+  ZeroMem (&CmdIu, sizeof (USB_UAS_COMMAND_IU));
+  CmdIu.IuId   = USB_UAS_IU_COMMAND;
+  CmdIu.Tag    = SwapBytes16 (Tag);
+  CmdIu.Lun[1] = Lun;
+  CopyMem (CmdIu.Cdb, Cmd, CmdLen);
+
+  Result  = 0;
+  DataLen = sizeof (USB_UAS_COMMAND_IU);
+  Timeout = USB_UAS_SEND_CMD_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbBulkTransfer (
+                            UsbUas->UsbIo,
+                            UsbUas->CommandEndpoint,
+                            &CmdIu,
+                            &DataLen,
+                            Timeout,
+                            &Result
+                            );
+  if (EFI_ERROR (Status) && USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+    UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->CommandEndpoint);
+  }
+
+  return Status;
+}
+
+/**
+  Transfer the data between the device and host using the data pipes.
+
+  @param  UsbUas                The USB UAS device
+  @param  DataDir               The direction of the data
+  @param  Data                  The buffer to hold data
+  @param  TransLen              The expected length of the data
+  @param  Timeout               The time to wait the command to complete
+
+  @retval EFI_SUCCESS           The data is transferred
+  @retval Others                Failed to transfer data
+
+**/
+EFI_STATUS
+UsbUasDataTransfer (
+  IN USB_UAS_PROTOCOL         *UsbUas,
+  IN EFI_USB_DATA_DIRECTION   DataDir,
+  IN OUT UINT8                *Data,
+  IN OUT UINTN                *TransLen,
+  IN UINT32                   Timeout
+  )
+{
+  UINT8                       Endpoint;
+  EFI_STATUS                  Status;
+  UINT32                      Result;
+
+  if (DataDir == EfiUsbDataIn) {
+    Endpoint = UsbUas->DataInEndpoint;
+  } else {
+    Endpoint = UsbUas->DataOutEndpoint;
+  }
+
+  Result  = 0;
+  Timeout = Timeout / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbBulkTransfer (
+                            UsbUas->UsbIo,
+                            Endpoint,
+                            Data,
+                            TransLen,
+                            Timeout,
+                            &Result
+                            );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbUasDataTransfer: (%r) Result=0x%x\n", Status, Result));
+    if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbUas->UsbIo, Endpoint);
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Receive the next IU of the command from the status pipe.
+
+  @param  UsbUas                The USB UAS device
+  @param  Tag                   The tag of the command
+  @param  Timeout               The time to wait the command to complete
+  @param  StatusIu              The buffer to receive the IU
+
+  @retval EFI_SUCCESS           An IU of the command is received.
+  @retval EFI_DEVICE_ERROR      The IU doesn't belong to the command.
+  @retval Others                Failed to receive the IU.
+
+**/
+EFI_STATUS
+UsbUasGetStatus (
+  IN  USB_UAS_PROTOCOL        *UsbUas,
+  IN  UINT16                  Tag,
+  IN  UINT32                  Timeout,
+  OUT USB_UAS_SENSE_IU        *StatusIu
+  )
+{
+  EFI_STATUS                  Status;
+  UINT32                      Result;
+  UINTN                       Len;
+
+  ZeroMem (StatusIu, sizeof (USB_UAS_SENSE_IU));
+  Result  = 0;
+  Len     = sizeof (USB_UAS_SENSE_IU);
+  Timeout = Timeout / USB_MASS_1_MILLISECOND;
+
+  Status = UsbUas->UsbIo->UsbBulkTransfer (
+                            UsbUas->UsbIo,
+                            UsbUas->StatusEndpoint,
+                            StatusIu,
+                            &Len,
+                            Timeout,
+                            &Result
+                            );
+  if (EFI_ERROR (Status)) {
+    if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->StatusEndpoint);
+    }
+    return Status;
+  }
+
+  if ((Len < OFFSET_OF (USB_UAS_SENSE_IU, StatusQualifier)) || (SwapBytes16 (StatusIu->Tag) != Tag)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Call the USB Mass Storage Class UAS protocol to issue the command
+  and wait for its data and status information units.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to excute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  )
+{
+  USB_UAS_PROTOCOL          *UsbUas;
+  USB_UAS_SENSE_IU          StatusIu;
+  EFI_STATUS                Status;
+  UINTN                     TransLen;
+  UINT16                    Tag;
+
+  *CmdStatus  = USB_MASS_CMD_FAIL;
+  UsbUas      = (USB_UAS_PROTOCOL *) Context;
+
+  //
+  // The device returns the sense data of a failed command in its Sense IU.
+  // Answer the REQUEST SENSE command which follows from the saved copy.
+  //
+  if ((*(UINT8 *) Cmd == USB_BOOT_REQUEST_SENSE_OPCODE) && (UsbUas->SenseLen != 0)) {
+    TransLen = MIN (DataLen, UsbUas->SenseLen);
+    CopyMem (Data, UsbUas->SenseData, TransLen);
+    UsbUas->SenseLen = 0;
+    *CmdStatus       = USB_MASS_CMD_SUCCESS;
+    return EFI_SUCCESS;
+  }
+
+  UsbUas->SenseLen = 0;
+  Tag              = UsbUas->Tag;
+  UsbUas->Tag      = (UINT16) ((Tag == MAX_UINT16) ? 1 : (Tag + 1));
+
+  Status = UsbUasSendCommand (UsbUas, Cmd, CmdLen, Lun, Tag);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbUasExecCommand: UsbUasSendCommand (%r)\n", Status));
+    return Status;
+  }
+
+  Status = UsbUasGetStatus (UsbUas, Tag, Timeout, &StatusIu);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbUasExecCommand: UsbUasGetStatus (%r)\n", Status));
+    return Status;
+  }
+
+  //
+  // The device asks for the data phase with a READ READY or WRITE READY IU,
+  // or it returns the Sense IU directly if the command has failed.
+  //
+  if ((StatusIu.IuId == USB_UAS_IU_READ_READY) || (StatusIu.IuId == USB_UAS_IU_WRITE_READY)) {
+    if ((StatusIu.IuId == USB_UAS_IU_READ_READY) != (DataDir == EfiUsbDataIn)) {
+      DEBUG ((EFI_D_ERROR, "UsbUasExecCommand: IU 0x%x mismatches the data direction\n", StatusIu.IuId));
+      return EFI_DEVICE_ERROR;
+    }
+
+    //
+    // Don't return immediately even data transfer failed. The host should
+    // attempt to receive the Sense IU no matter whether it succeeds or fails.
+    //
+    TransLen = (UINTN) DataLen;
+    Status   = UsbUasDataTransfer (UsbUas, DataDir, Data, &TransLen, Timeout);
+    if (Status == EFI_DEVICE_ERROR) {
+      return Status;
+    }
+
+    Status = UsbUasGetStatus (UsbUas, Tag, Timeout, &StatusIu);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "UsbUasExecCommand: UsbUasGetStatus (%r)\n", Status));
+      return Status;
+    }
+  }
+
+  if (StatusIu.IuId != USB_UAS_IU_SENSE) {
+    DEBUG ((EFI_D_ERROR, "UsbUasExecCommand: unexpected IU 0x%x\n", StatusIu.IuId));
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (StatusIu.Status == USB_UAS_STATUS_GOOD) {
+    *CmdStatus = USB_MASS_CMD_SUCCESS;
+  } else {
+    UsbUas->SenseLen = (UINT8) MIN (SwapBytes16 (StatusIu.SenseLen), USB_UAS_MAX_SENSE_LEN);
+    CopyMem (UsbUas->SenseData, StatusIu.SenseData, UsbUas->SenseLen);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  If FALSE, just clear the stall condition of the pipes.
+                                If TRUE, additionally reset parent hub port.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID                    *Context,
+  IN  BOOLEAN                 ExtendedVerification
+  )
+{
+  USB_UAS_PROTOCOL        *UsbUas;
+  EFI_STATUS              Status;
+
+  UsbUas = (USB_UAS_PROTOCOL *) Context;
+
+  if (ExtendedVerification) {
+    Status = UsbUas->UsbIo->UsbPortReset (UsbUas->UsbIo);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    //
+    // The port reset returns the interface to its default setting.
+    //
+    if (UsbUas->AlternateSetting != 0) {
+      Status = UsbUasSelectSetting (UsbUas, UsbUas->AlternateSetting);
+      if (EFI_ERROR (Status)) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+  }
+
+  //
+  // UAS has no class specific reset request, clear the stall condition of all pipes.
+  //
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->CommandEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->StatusEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->DataInEndpoint);
+  UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->DataOutEndpoint);
+
+  UsbUas->SenseLen = 0;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Clean up the resource used by this UAS protocol.
+
+  @param  Context         The context of the UAS protocol, that is, USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS     The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID                    *Context
+  )
+{
+  FreePool (Context);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/** @file
+  Definition for the USB Attached SCSI transport protocol, based on the
+  "Universal Serial Bus Mass Storage Class - USB Attached SCSI Protocol (UASP)"
+  Revision 1.0, and T10 "USB Attached SCSI (UAS)".
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _EFI_USBMASS_UAS_H_
+#define _EFI_USBMASS_UAS_H_
+
+extern USB_MASS_TRANSPORT mUsbUasTransport;
+
+#define USB_MASS_STORE_UAS       0x62       ///< USB Attached SCSI
+
+//
+// Class specific Pipe Usage descriptor, it follows each endpoint
+// descriptor of the UAS interface to tell the role of the pipe.
+//
+#define USB_UAS_DESC_TYPE_PIPE_USAGE  0x24
+#define USB_UAS_PIPE_ID_COMMAND       0x01  ///< Command pipe, Bulk-Out
+#define USB_UAS_PIPE_ID_STATUS        0x02  ///< Status pipe, Bulk-In
+#define USB_UAS_PIPE_ID_DATA_IN       0x03  ///< Data-In pipe, Bulk-In
+#define USB_UAS_PIPE_ID_DATA_OUT      0x04  ///< Data-Out pipe, Bulk-Out
+
+//
+// Information unit IDs
+//
+#define USB_UAS_IU_COMMAND       0x01
+#define USB_UAS_IU_SENSE         0x03
+#define USB_UAS_IU_RESPONSE      0x04
+#define USB_UAS_IU_READ_READY    0x06
+#define USB_UAS_IU_WRITE_READY   0x07
+
+#define USB_UAS_PIPES_FOUND(UsbUas) \
+          (((UsbUas)->CommandEndpoint != 0) && ((UsbUas)->StatusEndpoint != 0) && \
+           ((UsbUas)->DataInEndpoint != 0) && ((UsbUas)->DataOutEndpoint != 0))
+
+#define USB_UAS_MAX_CMDLEN       16         ///< Maxium length of the CDB without additional CDB bytes
+#define USB_UAS_MAX_SENSE_LEN    18         ///< Length of the fixed format sense data kept for REQUEST SENSE
+
+//
+// SCSI status codes returned in the Sense IU
+//
+#define USB_UAS_STATUS_GOOD      0x00
+
+//
+// SuperSpeed UAS devices move the data through bulk streams, which the
+// host controller drivers don't provide. Only the high speed protocol
+// without streams is supported, recognized by the bulk max packet size.
+//
+#define USB_UAS_SUPER_SPEED_MAX_PACKET  1024
+
+//
+// Usb UAS transport timeout, set by experience
+//
+#define USB_UAS_SEND_CMD_TIMEOUT      (3 * USB_MASS_1_SECOND)
+#define USB_UAS_CONTROL_TIMEOUT       (3 * USB_MASS_1_SECOND)
+
+#pragma pack(1)
+///
+/// The Command IU, sent through the command pipe.
+///
+typedef struct {
+  UINT8               IuId;
+  UINT8               Reserved0;
+  UINT16              Tag;            ///< Big endian
+  UINT8               TaskAttribute;  ///< Bits 0~2, 0 ~ Simple task
+  UINT8               Reserved1;
+  UINT8               AddCdbLen;      ///< Additional CDB length in dwords, bits 2~7
+  UINT8               Reserved2;
+  UINT8               Lun[8];
+  UINT8               Cdb[USB_UAS_MAX_CMDLEN];
+} USB_UAS_COMMAND_IU;
+
+///
+/// The Sense IU, received through the status pipe when a command completes.
+///
+typedef struct {
+  UINT8               IuId;
+  UINT8               Reserved0;
+  UINT16              Tag;            ///< Big endian
+  UINT16              StatusQualifier;
+  UINT8               Status;
+  UINT8               Reserved1[7];
+  UINT16              SenseLen;       ///< Big endian
+  UINT8               SenseData[252];
+} USB_UAS_SENSE_IU;
+
+///
+/// The Pipe Usage descriptor.
+///
+typedef struct {
+  UINT8               Length;
+  UINT8               DescriptorType;
+  UINT8               PipeId;
+  UINT8               Reserved;
+} USB_UAS_PIPE_USAGE_DESCRIPTOR;
+#pragma pack()
+
+typedef struct {
+  //
+  // Put Interface at the first field to make it easy to distinguish BOT/CBI/UAS Protocol instance
+  //
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  UINT8                         AlternateSetting;
+  UINT8                         CommandEndpoint;
+  UINT8                         StatusEndpoint;
+  UINT8                         DataInEndpoint;
+  UINT8                         DataOutEndpoint;
+  UINT16                        MaxPacketSize;
+  UINT16                        Tag;
+  //
+  // Sense data of the last failed command. The device reports it in the Sense IU
+  // rather than holding it for a following REQUEST SENSE command.
+  //
+  UINT8                         SenseLen;
+  UINT8                         SenseData[USB_UAS_MAX_SENSE_LEN];
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+} USB_UAS_PROTOCOL;
+
+/**
+  Initializes USB UAS protocol.
+
+  This function initializes the USB mass storage class UAS protocol. A device
+  whose current setting is BOT is switched to its UAS alternate setting if
+  it has one. It will save its context which is a USB_UAS_PROTOCOL structure
+  in the Context if Context isn't NULL.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL       *UsbIo,
+  OUT VOID                      **Context OPTIONAL
+  );
+
+/**
+  Call the USB Mass Storage Class UAS protocol to issue the command
+  and wait for its data and status information units.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to excute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  );
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  If FALSE, just clear the stall condition of the pipes.
+                                If TRUE, additionally reset parent hub port.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID                    *Context,
+  IN  BOOLEAN                 ExtendedVerification
+  );
+
+/**
+  Clean up the resource used by this UAS protocol.
+
+  @param  Context         The context of the UAS protocol, that is, USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS     The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID                    *Context
+  );
+
+#endif
@@ -1470,6 +1470,7 @@ NetLibIp6ToStr (
 #define  NET_BUF_HEAD         1    // Trim or allocate space from head
 #define  NET_BUF_TAIL         0    // Trim or allocate space from tail
 #define  NET_VECTOR_OWN_FIRST 0x01  // We allocated the 1st block in the vector
+#define  NET_VECTOR_EMBED_BULK 0x02 // The only block is allocated behind the vector
 
 #define NET_CHECK_SIGNATURE(PData, SIGNATURE) \
   ASSERT (((PData) != NULL) && ((PData)->Signature == (SIGNATURE)))
@@ -1494,7 +1495,7 @@ typedef struct {
   INTN                RefCnt;  // Reference count to share NET_VECTOR.
   NET_VECTOR_EXT_FREE Free;    // external function to free NET_VECTOR
   VOID                *Arg;    // opeque argument to Free
-  UINT32              Flag;    // Flags, NET_VECTOR_OWN_FIRST
+  UINT32              Flag;    // Flags, NET_VECTOR_OWN_FIRST, NET_VECTOR_EMBED_BULK
   UINT32              Len;     // Total length of the assocated BLOCKs
 
   UINT32              BlockNum;
@@ -20,6 +20,313 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+//
+// Released NET_BUF heads and single block NET_VECTORs are kept on
+// freelists instead of going back to the pool. The library is linked
+// into every network driver, so each driver has its own freelists.
+// Heads have room for NET_BUF_CACHE_BLOCK_OP block operations, vectors
+// are sorted into two classes by the size of the data behind them.
+//
+#define NET_BUF_CACHE_BLOCK_OP    4
+#define NET_BUF_CACHE_DEPTH       64
+#define NET_BUF_CACHE_SMALL_BULK  256
+#define NET_BUF_CACHE_LARGE_BULK  2048
+
+typedef struct _NET_CACHE_ENTRY {
+  struct _NET_CACHE_ENTRY   *Next;
+} NET_CACHE_ENTRY;
+
+typedef struct {
+  NET_CACHE_ENTRY           *Head;
+  UINT32                    Count;
+  UINTN                     Size;       // The size of each cached memory block
+} NET_CACHE;
+
+typedef struct {
+  UINT64                    NetbufAllocated;
+  UINT64                    PoolAllocated;
+  UINT64                    CacheHit;
+} NET_BUF_STATISTICS;
+
+NET_CACHE           mNetbufHeadCache = {
+  NULL, 0, NET_BUF_SIZE (NET_BUF_CACHE_BLOCK_OP)
+};
+
+NET_CACHE           mNetVectorCache[2] = {
+  { NULL, 0, NET_VECTOR_SIZE (1) + NET_BUF_CACHE_SMALL_BULK },
+  { NULL, 0, NET_VECTOR_SIZE (1) + NET_BUF_CACHE_LARGE_BULK }
+};
+
+NET_BUF_STATISTICS  mNetbufStatistics;
+
+
+/**
+  Get a memory block from the cache, or allocate one from the pool
+  if the cache is empty.
+
+  @param[in]  Cache          The cache to get the memory block from.
+
+  @return                    Pointer to the memory block, or NULL if the
+                             allocation failed due to resource limit.
+
+**/
+VOID *
+NetCacheAllocate (
+  IN NET_CACHE              *Cache
+  )
+{
+  NET_CACHE_ENTRY           *Entry;
+  EFI_TPL                   OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  Entry  = Cache->Head;
+
+  if (Entry != NULL) {
+    Cache->Head = Entry->Next;
+    Cache->Count--;
+    mNetbufStatistics.CacheHit++;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Entry == NULL) {
+    mNetbufStatistics.PoolAllocated++;
+    Entry = AllocatePool (Cache->Size);
+  }
+
+  return Entry;
+}
+
+
+/**
+  Return a memory block to the cache, or to the pool if the cache
+  is full.
+
+  @param[in]  Cache          The cache the memory block belongs to.
+  @param[in]  Buffer         The memory block to release.
+
+**/
+VOID
+NetCacheFree (
+  IN NET_CACHE              *Cache,
+  IN VOID                   *Buffer
+  )
+{
+  NET_CACHE_ENTRY           *Entry;
+  EFI_TPL                   OldTpl;
+
+  Entry  = (NET_CACHE_ENTRY *) Buffer;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (Cache->Count < NET_BUF_CACHE_DEPTH) {
+    Entry->Next = Cache->Head;
+    Cache->Head = Entry;
+    Cache->Count++;
+    Entry       = NULL;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Entry != NULL) {
+    FreePool (Entry);
+  }
+}
+
+
+/**
+  Release all the memory blocks held by the cache.
+
+  @param[in]  Cache          The cache to flush.
+
+**/
+VOID
+NetCacheFlush (
+  IN NET_CACHE              *Cache
+  )
+{
+  NET_CACHE_ENTRY           *Entry;
+
+  while (Cache->Head != NULL) {
+    Entry       = Cache->Head;
+    Cache->Head = Entry->Next;
+    FreePool (Entry);
+  }
+
+  Cache->Count = 0;
+}
+
+
+/**
+  Allocate the memory of a NET_BUF which has BlockOpNum's NET_BLOCK_OP.
+  The memory isn't initialized.
+
+  @param[in]  BlockOpNum     The number of NET_BLOCK_OP in the net buffer
+
+  @return                    Pointer to the allocated NET_BUF, or NULL if the
+                             allocation failed due to resource limit.
+
+**/
+NET_BUF *
+NetbufAllocHead (
+  IN UINT32                 BlockOpNum
+  )
+{
+  mNetbufStatistics.NetbufAllocated++;
+
+  if (BlockOpNum <= NET_BUF_CACHE_BLOCK_OP) {
+    return NetCacheAllocate (&mNetbufHeadCache);
+  }
+
+  mNetbufStatistics.PoolAllocated++;
+  return AllocatePool (NET_BUF_SIZE (BlockOpNum));
+}
+
+
+/**
+  Release the memory of a NET_BUF allocated by NetbufAllocHead.
+
+  @param[in]  Nbuf           Pointer to the NET_BUF to release.
+
+**/
+VOID
+NetbufFreeHead (
+  IN NET_BUF                *Nbuf
+  )
+{
+  if (Nbuf->BlockOpNum <= NET_BUF_CACHE_BLOCK_OP) {
+    NetCacheFree (&mNetbufHeadCache, Nbuf);
+  } else {
+    FreePool (Nbuf);
+  }
+}
+
+
+/**
+  Get the cache which holds the single block NET_VECTOR of Len bytes
+  data allocated right behind it.
+
+  @param[in]  Len            The length of the block.
+
+  @return                    Pointer to the cache, or NULL if the vector is
+                             too large to be cached.
+
+**/
+NET_CACHE *
+NetVectorGetCache (
+  IN UINT32                 Len
+  )
+{
+  if (Len <= NET_BUF_CACHE_SMALL_BULK) {
+    return &mNetVectorCache[0];
+  } else if (Len <= NET_BUF_CACHE_LARGE_BULK) {
+    return &mNetVectorCache[1];
+  }
+
+  return NULL;
+}
+
+
+/**
+  Allocate a single block NET_VECTOR with the Len bytes of the block in
+  the same memory. The vector is initialized, but the block data isn't.
+
+  @param[in]  Len            The length of the block.
+
+  @return                    Pointer to the allocated NET_VECTOR, or NULL if the
+                             allocation failed due to resource limit.
+
+**/
+NET_VECTOR *
+NetbufAllocEmbedVector (
+  IN UINT32                 Len
+  )
+{
+  NET_VECTOR                *Vector;
+  NET_CACHE                 *Cache;
+
+  Cache = NetVectorGetCache (Len);
+
+  if (Cache != NULL) {
+    Vector = NetCacheAllocate (Cache);
+  } else {
+    mNetbufStatistics.PoolAllocated++;
+    Vector = AllocatePool (NET_VECTOR_SIZE (1) + Len);
+  }
+
+  if (Vector == NULL) {
+    return NULL;
+  }
+
+  ZeroMem (Vector, NET_VECTOR_SIZE (1));
+
+  Vector->Signature     = NET_VECTOR_SIGNATURE;
+  Vector->RefCnt        = 1;
+  Vector->Flag          = NET_VECTOR_EMBED_BULK;
+  Vector->Len           = Len;
+  Vector->BlockNum      = 1;
+  Vector->Block[0].Bulk = (UINT8 *) Vector + NET_VECTOR_SIZE (1);
+  Vector->Block[0].Len  = Len;
+
+  return Vector;
+}
+
+
+/**
+  Release the memory of a NET_VECTOR allocated by NetbufAllocEmbedVector.
+
+  @param[in]  Vector         Pointer to the NET_VECTOR to release.
+
+**/
+VOID
+NetbufFreeEmbedVector (
+  IN NET_VECTOR             *Vector
+  )
+{
+  NET_CACHE                 *Cache;
+
+  Cache = NetVectorGetCache (Vector->Len);
+
+  if (Cache != NULL) {
+    NetCacheFree (Cache, Vector);
+  } else {
+    FreePool (Vector);
+  }
+}
+
+
+/**
+  Release the NET_BUF and NET_VECTOR memory kept on the freelists when
+  the driver this library is linked to is unloaded.
+
+  @param[in]  ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in]  SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS        The freelists are released.
+
+**/
+EFI_STATUS
+EFIAPI
+NetbufCacheDestructor (
+  IN EFI_HANDLE             ImageHandle,
+  IN EFI_SYSTEM_TABLE       *SystemTable
+  )
+{
+  DEBUG ((
+    EFI_D_INFO,
+    "NetLib: %Ld NET_BUF allocated, %Ld pool allocations, %Ld from cache\n",
+    mNetbufStatistics.NetbufAllocated,
+    mNetbufStatistics.PoolAllocated,
+    mNetbufStatistics.CacheHit
+    ));
+
+  NetCacheFlush (&mNetbufHeadCache);
+  NetCacheFlush (&mNetVectorCache[0]);
+  NetCacheFlush (&mNetVectorCache[1]);
+
+  return EFI_SUCCESS;
+}
+
 
 /**
   Allocate and build up the sketch for a NET_BUF.
@@ -49,18 +356,21 @@ NetbufAllocStruct (
   //
   // Allocate three memory blocks.
   //
-  Nbuf = AllocateZeroPool (NET_BUF_SIZE (BlockOpNum));
+  Nbuf = NetbufAllocHead (BlockOpNum);
 
   if (Nbuf == NULL) {
     return NULL;
   }
 
+  ZeroMem (Nbuf, NET_BUF_SIZE (BlockOpNum));
+
   Nbuf->Signature           = NET_BUF_SIGNATURE;
   Nbuf->RefCnt              = 1;
   Nbuf->BlockOpNum          = BlockOpNum;
   InitializeListHead (&Nbuf->List);
 
   if (BlockNum != 0) {
+    mNetbufStatistics.PoolAllocated++;
     Vector = AllocateZeroPool (NET_VECTOR_SIZE (BlockNum));
 
     if (Vector == NULL) {
@@ -77,7 +387,7 @@ NetbufAllocStruct (
 
 FreeNbuf:
 
-  FreePool (Nbuf);
+  NetbufFreeHead (Nbuf);
   return NULL;
 }
 
@@ -104,23 +414,24 @@ NetbufAlloc (
 
   ASSERT (Len > 0);
 
-  Nbuf = NetbufAllocStruct (1, 1);
+  //
+  // The block data is allocated together with the vector, so a
+  // single block NET_BUF costs at most two allocations.
+  //
+  Nbuf = NetbufAllocStruct (0, 1);
 
   if (Nbuf == NULL) {
     return NULL;
   }
 
-  Bulk = AllocatePool (Len);
+  Vector = NetbufAllocEmbedVector (Len);
 
-  if (Bulk == NULL) {
+  if (Vector == NULL) {
     goto FreeNBuf;
   }
 
-  Vector = Nbuf->Vector;
-  Vector->Len                 = Len;
-
-  Vector->Block[0].Bulk       = Bulk;
-  Vector->Block[0].Len        = Len;
+  Nbuf->Vector                = Vector;
+  Bulk                        = Vector->Block[0].Bulk;
 
   Nbuf->BlockOp[0].BlockHead  = Bulk;
   Nbuf->BlockOp[0].BlockTail  = Bulk + Len;
@@ -132,7 +443,7 @@ NetbufAlloc (
   return Nbuf;
 
 FreeNBuf:
-  FreePool (Nbuf);
+  NetbufFreeHead (Nbuf);
   return NULL;
 }
 
@@ -175,6 +486,13 @@ NetbufFreeVector (
 
     Vector->Free (Vector->Arg);
 
+  } else if ((Vector->Flag & NET_VECTOR_EMBED_BULK) != 0) {
+    //
+    // The only block lives in the same memory as the Vector
+    //
+    NetbufFreeEmbedVector (Vector);
+    return;
+
   } else {
     //
     // Free each memory block associated with the Vector
@@ -218,7 +536,7 @@ NetbufFree (
     // all the sharing of Nbuf increse Vector's RefCnt by one
     //
     NetbufFreeVector (Nbuf->Vector);
-    FreePool (Nbuf);
+    NetbufFreeHead (Nbuf);
   }
 }
 
@@ -245,7 +563,7 @@ NetbufClone (
 
   NET_CHECK_SIGNATURE (Nbuf, NET_BUF_SIGNATURE);
 
-  Clone = AllocatePool (NET_BUF_SIZE (Nbuf->BlockOpNum));
+  Clone = NetbufAllocHead (Nbuf->BlockOpNum);
 
   if (Clone == NULL) {
     return NULL;
@@ -618,6 +936,7 @@ NetbufGetFragment (
       return NULL;
     }
 
+    mNetbufStatistics.PoolAllocated++;
     FirstBulk = AllocatePool (HeadSpace);
 
     if (FirstBulk == NULL) {
@@ -685,7 +1004,8 @@ NetbufGetFragment (
 
 FreeChild:
 
-  FreePool (Child);
+  FreePool (Child->Vector);
+  NetbufFreeHead (Child);
   return NULL;
 }
 
@@ -767,6 +1087,7 @@ NetbufFromExt (
   //
   if ((HeadSpace != 0) || (HeadLen != 0)) {
     FirstBlockLen = HeadLen + HeadSpace;
+    mNetbufStatistics.PoolAllocated++;
     FirstBlock    = AllocatePool (FirstBlockLen);
 
     if (FirstBlock == NULL) {
@@ -1885,8 +2206,13 @@ NetIpSecNetbufFree (
     if ((Nbuf->Vector->Flag & NET_VECTOR_OWN_FIRST) != 0) {
       FreePool (Nbuf->Vector->Block[0].Bulk);
     }
-    FreePool (Nbuf->Vector);
-    FreePool (Nbuf); 
+
+    if ((Nbuf->Vector->Flag & NET_VECTOR_EMBED_BULK) != 0) {
+      NetbufFreeEmbedVector (Nbuf->Vector);
+    } else {
+      FreePool (Nbuf->Vector);
+    }
+    NetbufFreeHead (Nbuf); 
   } 
 }
 
@@ -54,6 +54,369 @@ DISK_IO_PRIVATE_DATA        gDiskIoPrivateDataTemplate = {
   }
 };
 
+//
+// Statistics of the device reads of all the Disk IO devices, reported at ready to boot.
+//
+UINT64                      mDiskIoDeviceReads;
+UINT64                      mDiskIoCacheHits;
+UINT64                      mDiskIoCoalescedReads;
+
+/**
+  Allocate the block cache of the Disk IO device.
+
+  The cache is left disabled when PcdDiskIoCacheBlockNum is 0, for removable
+  media whose change may only be noticed by the Block IO driver on the next
+  access, or when there isn't enough memory.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheInit (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  EFI_BLOCK_IO_MEDIA          *Media;
+  UINTN                       BlockNum;
+  UINTN                       Index;
+
+  Media    = Instance->BlockIo->Media;
+  BlockNum = PcdGet32 (PcdDiskIoCacheBlockNum);
+
+  EfiInitializeLock (&Instance->CacheLock, TPL_NOTIFY);
+  Instance->CacheBlockNum      = 0;
+  Instance->CacheGeneration    = 0;
+  Instance->CacheWritesPending = 0;
+  if ((BlockNum == 0) || Media->RemovableMedia) {
+    return;
+  }
+
+  Instance->CacheBlocks = AllocateZeroPool (BlockNum * sizeof (DISK_IO_CACHE_BLOCK));
+  Instance->CacheBuffer = AllocatePool (BlockNum * Media->BlockSize);
+  if ((Instance->CacheBlocks == NULL) || (Instance->CacheBuffer == NULL)) {
+    DEBUG ((EFI_D_WARN, "DiskIo: No enough memory for the block cache\n"));
+    return;
+  }
+
+  for (Index = 0; Index < BlockNum; Index++) {
+    Instance->CacheBlocks[Index].Data = Instance->CacheBuffer + Index * Media->BlockSize;
+  }
+  Instance->CacheMediaId  = Media->MediaId;
+  Instance->CacheBlockNum = BlockNum;
+}
+
+/**
+  Free the block cache of the Disk IO device.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheFree (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  if (Instance->CacheBlocks != NULL) {
+    FreePool (Instance->CacheBlocks);
+  }
+  if (Instance->CacheBuffer != NULL) {
+    FreePool (Instance->CacheBuffer);
+  }
+  Instance->CacheBlocks   = NULL;
+  Instance->CacheBuffer   = NULL;
+  Instance->CacheBlockNum = 0;
+}
+
+/**
+  Find the cached block of the LBA. The caller holds the cache lock.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The logical block address.
+
+  @return The cached block, or NULL if the block isn't cached.
+**/
+DISK_IO_CACHE_BLOCK *
+DiskIoCacheLookup (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Lba
+  )
+{
+  UINTN                       Index;
+
+  for (Index = 0; Index < Instance->CacheBlockNum; Index++) {
+    if ((Instance->CacheBlocks[Index].LastUsed != 0) && (Instance->CacheBlocks[Index].Lba == Lba)) {
+      return &Instance->CacheBlocks[Index];
+    }
+  }
+  return NULL;
+}
+
+/**
+  Drop the cached blocks within the range. The caller holds the cache lock.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The first logical block address of the range.
+  @param BlockCount   The number of blocks in the range.
+**/
+VOID
+DiskIoCacheDrop (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Lba,
+  IN UINT64                   BlockCount
+  )
+{
+  UINTN                       Index;
+
+  for (Index = 0; Index < Instance->CacheBlockNum; Index++) {
+    if ((Instance->CacheBlocks[Index].Lba >= Lba) && (Instance->CacheBlocks[Index].Lba - Lba < BlockCount)) {
+      Instance->CacheBlocks[Index].LastUsed = 0;
+    }
+  }
+  Instance->CacheGeneration++;
+}
+
+/**
+  Drop the cached blocks within the range.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The first logical block address of the range.
+  @param BlockCount   The number of blocks in the range.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Lba,
+  IN UINT64                   BlockCount
+  )
+{
+  if (Instance->CacheBlockNum == 0) {
+    return;
+  }
+
+  EfiAcquireLock (&Instance->CacheLock);
+  DiskIoCacheDrop (Instance, Lba, BlockCount);
+  EfiReleaseLock (&Instance->CacheLock);
+}
+
+/**
+  Drop the cached blocks a write is about to change. No block is put into
+  the cache until the write completes.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The first logical block address written.
+  @param BlockCount   The number of blocks written.
+**/
+VOID
+DiskIoCacheWriteStart (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Lba,
+  IN UINT64                   BlockCount
+  )
+{
+  if (Instance->CacheBlockNum == 0) {
+    return;
+  }
+
+  EfiAcquireLock (&Instance->CacheLock);
+  DiskIoCacheDrop (Instance, Lba, BlockCount);
+  Instance->CacheWritesPending++;
+  EfiReleaseLock (&Instance->CacheLock);
+}
+
+/**
+  Drop the cached blocks again once a write completed or failed to start,
+  because a read of the range during the write may have cached old data.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba          The first logical block address written.
+  @param BlockCount   The number of blocks written.
+**/
+VOID
+DiskIoCacheWriteEnd (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT64                   Lba,
+  IN UINT64                   BlockCount
+  )
+{
+  if (Instance->CacheBlockNum == 0) {
+    return;
+  }
+
+  EfiAcquireLock (&Instance->CacheLock);
+  DiskIoCacheDrop (Instance, Lba, BlockCount);
+  ASSERT (Instance->CacheWritesPending != 0);
+  Instance->CacheWritesPending--;
+  EfiReleaseLock (&Instance->CacheLock);
+}
+
+/**
+  Read the blocks from the block cache.
+
+  The whole cache is dropped when the media changed since the blocks were cached.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium to read.
+  @param Lba          The first logical block address to read.
+  @param BlockCount   The number of blocks to read.
+  @param Buffer       The buffer to hold the data.
+  @param Generation   Returns the cache generation to pass to DiskIoCacheInsert()
+                      when the blocks need to be read from the device.
+
+  @retval TRUE        All the blocks are read from the cache.
+  @retval FALSE       The blocks need to be read from the device.
+**/
+BOOLEAN
+DiskIoCacheRead (
+  IN  DISK_IO_PRIVATE_DATA    *Instance,
+  IN  UINT32                  MediaId,
+  IN  UINT64                  Lba,
+  IN  UINTN                   BlockCount,
+  OUT UINT8                   *Buffer,
+  OUT UINT64                  *Generation
+  )
+{
+  EFI_BLOCK_IO_MEDIA          *Media;
+  DISK_IO_CACHE_BLOCK         *CacheBlocks[DISK_IO_CACHE_READ_MAX_BLOCKS];
+  UINTN                       Index;
+  BOOLEAN                     Hit;
+
+  *Generation = 0;
+  if ((Instance->CacheBlockNum == 0) || (BlockCount == 0) || (BlockCount > DISK_IO_CACHE_READ_MAX_BLOCKS)) {
+    return FALSE;
+  }
+
+  Media = Instance->BlockIo->Media;
+  Hit   = FALSE;
+
+  EfiAcquireLock (&Instance->CacheLock);
+  if (!Media->MediaPresent || (Media->MediaId != Instance->CacheMediaId)) {
+    DiskIoCacheDrop (Instance, 0, MAX_UINT64);
+    Instance->CacheMediaId = Media->MediaId;
+  }
+
+  //
+  // Leave requests for a different media to the Block IO to fail.
+  //
+  if (Media->MediaPresent && (MediaId == Instance->CacheMediaId)) {
+    for (Index = 0; Index < BlockCount; Index++) {
+      CacheBlocks[Index] = DiskIoCacheLookup (Instance, Lba + Index);
+      if (CacheBlocks[Index] == NULL) {
+        break;
+      }
+    }
+
+    if (Index == BlockCount) {
+      for (Index = 0; Index < BlockCount; Index++) {
+        CopyMem (Buffer + Index * Media->BlockSize, CacheBlocks[Index]->Data, Media->BlockSize);
+        CacheBlocks[Index]->LastUsed = ++Instance->CacheClock;
+      }
+      mDiskIoCacheHits++;
+      Hit = TRUE;
+    }
+  }
+  *Generation = Instance->CacheGeneration;
+  EfiReleaseLock (&Instance->CacheLock);
+
+  return Hit;
+}
+
+/**
+  Put the blocks read from the device into the block cache, replacing the
+  least recently used blocks.
+
+  Nothing is cached while a write is pending or when any blocks were dropped
+  since DiskIoCacheRead() returned Generation, because the device may have
+  returned the data from before the write.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium the blocks are read from.
+  @param Lba          The first logical block address read.
+  @param BlockCount   The number of blocks read.
+  @param Buffer       The buffer holding the data.
+  @param Generation   The cache generation returned by DiskIoCacheRead().
+**/
+VOID
+DiskIoCacheInsert (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN UINT32                   MediaId,
+  IN UINT64                   Lba,
+  IN UINTN                    BlockCount,
+  IN UINT8                    *Buffer,
+  IN UINT64                   Generation
+  )
+{
+  DISK_IO_CACHE_BLOCK         *CacheBlock;
+  UINTN                       Block;
+  UINTN                       Index;
+  UINT32                      BlockSize;
+
+  if ((Instance->CacheBlockNum == 0) || (BlockCount == 0) || (BlockCount > DISK_IO_CACHE_READ_MAX_BLOCKS)) {
+    return;
+  }
+
+  BlockSize = Instance->BlockIo->Media->BlockSize;
+
+  EfiAcquireLock (&Instance->CacheLock);
+  if ((MediaId == Instance->CacheMediaId) && (Generation == Instance->CacheGeneration) &&
+      (Instance->CacheWritesPending == 0)) {
+    for (Block = 0; Block < BlockCount; Block++) {
+      CacheBlock = DiskIoCacheLookup (Instance, Lba + Block);
+      if (CacheBlock == NULL) {
+        CacheBlock = &Instance->CacheBlocks[0];
+        for (Index = 1; Index < Instance->CacheBlockNum; Index++) {
+          if (Instance->CacheBlocks[Index].LastUsed < CacheBlock->LastUsed) {
+            CacheBlock = &Instance->CacheBlocks[Index];
+          }
+        }
+      }
+
+      CopyMem (CacheBlock->Data, Buffer + Block * BlockSize, BlockSize);
+      CacheBlock->Lba      = Lba + Block;
+      CacheBlock->LastUsed = ++Instance->CacheClock;
+    }
+  }
+  EfiReleaseLock (&Instance->CacheLock);
+}
+
+/**
+  Get the number of bytes the subtask transfers from or to the device.
+
+  @param Subtask      Subtask.
+  @param BlockSize    The block size of the device.
+
+  @return The size of the transfer, a multiple of the block size.
+**/
+UINTN
+DiskIoSubtaskTransferSize (
+  IN DISK_IO_SUBTASK          *Subtask,
+  IN UINT32                   BlockSize
+  )
+{
+  if (Subtask->Length == 0) {
+    return 0;
+  }
+  return ((Subtask->Offset + Subtask->Length + BlockSize - 1) / BlockSize) * BlockSize;
+}
+
+/**
+  Report the device reads of all the Disk IO devices and the reads saved
+  by the block cache and by coalescing.
+
+  @param  Event                 Event whose notification function is being invoked.
+  @param  Context               The pointer to the notification function's context.
+**/
+VOID
+EFIAPI
+DiskIoOnReadyToBoot (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  DEBUG ((
+    EFI_D_INFO,
+    "DiskIo: %ld device reads, %ld reads saved by the block cache, %ld by coalescing\n",
+    mDiskIoDeviceReads, mDiskIoCacheHits, mDiskIoCoalescedReads
+    ));
+}
+
 /**
   Test to see if this driver supports ControllerHandle. 
 
@@ -191,6 +554,8 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  DiskIoCacheInit (Instance);
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -219,6 +584,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoCacheFree (Instance);
       FreePool (Instance);
     }
 
@@ -326,6 +692,7 @@ DiskIoDriverBindingStop (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
       );
+    DiskIoCacheFree (Instance);
 
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -378,10 +745,8 @@ DiskIoDestroySubtask (
   if (!Subtask->Blocking) {
     if (Subtask->WorkingBuffer != NULL) {
       FreeAlignedPages (
-        Subtask->WorkingBuffer, 
-        Subtask->Length < Instance->BlockIo->Media->BlockSize
-        ? EFI_SIZE_TO_PAGES (Instance->BlockIo->Media->BlockSize)
-        : EFI_SIZE_TO_PAGES (Subtask->Length)
+        Subtask->WorkingBuffer,
+        EFI_SIZE_TO_PAGES (DiskIoSubtaskTransferSize (Subtask, Instance->BlockIo->Media->BlockSize))
         );
     }
     if (Subtask->BlockIo2Token.Event != NULL) {
@@ -426,6 +791,14 @@ DiskIo2OnReadWriteComplete (
     CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
   }
 
+  if (Subtask->Write) {
+    DiskIoCacheWriteEnd (
+      Instance,
+      Subtask->Lba,
+      DiskIoSubtaskTransferSize (Subtask, Instance->BlockIo->Media->BlockSize) / Instance->BlockIo->Media->BlockSize
+      );
+  }
+
   DiskIoDestroySubtask (Instance, Subtask);
 
   if (EFI_ERROR (TransactionStatus) || IsListEmpty (&Task->Subtasks)) {
@@ -542,6 +915,7 @@ DiskIoCreateSubtaskList (
   UINT8                 *BufferPtr;
   UINTN                 Length;
   UINTN                 DataBufferSize;
+  UINTN                 Requests;
   DISK_IO_SUBTASK       *Subtask;
   VOID                  *WorkingBuffer;
   LIST_ENTRY            *Link;
@@ -569,6 +943,44 @@ DiskIoCreateSubtaskList (
     return TRUE;
   }
 
+  //
+  // A read which starts or ends in the middle of a block would be split into
+  // a request for each partial block and one for the blocks in between. Read
+  // the whole range in one request instead when it fits the data buffer.
+  //
+  if (!Write && ((UnderRun != 0) || (BufferSize % BlockSize != 0)) &&
+      (BufferSize <= PcdGet32 (PcdDiskIoDataBufferBlockNum) * BlockSize - UnderRun)) {
+    DataBufferSize = ((UnderRun + BufferSize + BlockSize - 1) / BlockSize) * BlockSize;
+    if (DataBufferSize > BlockSize) {
+      if (Blocking) {
+        WorkingBuffer = SharedWorkingBuffer;
+      } else {
+        WorkingBuffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (DataBufferSize), IoAlign);
+      }
+
+      if (WorkingBuffer != NULL) {
+        Subtask = DiskIoCreateSubtask (FALSE, Lba, UnderRun, BufferSize, WorkingBuffer, BufferPtr, Blocking);
+        if (Subtask == NULL) {
+          if (!Blocking) {
+            FreeAlignedPages (WorkingBuffer, EFI_SIZE_TO_PAGES (DataBufferSize));
+          }
+          goto Done;
+        }
+        InsertTailList (Subtasks, &Subtask->Link);
+
+        //
+        // Partial first block, partial last block and the blocks in between.
+        //
+        Requests = ((UnderRun != 0) ? 1 : 0) + (((UnderRun + BufferSize) % BlockSize != 0) ? 1 : 0);
+        if (DataBufferSize > Requests * BlockSize) {
+          Requests++;
+        }
+        mDiskIoCoalescedReads += Requests - 1;
+        return TRUE;
+      }
+    }
+  }
+
   if (UnderRun != 0) {
     Length = MIN (BlockSize - UnderRun, BufferSize);
     if (Blocking) {
@@ -825,6 +1237,9 @@ DiskIo2ReadWriteDisk (
   BOOLEAN                Blocking;
   BOOLEAN                SubtaskBlocking;
   LIST_ENTRY             *SubtasksPtr;
+  UINTN                  TransferSize;
+  UINT8                  *TransferBuffer;
+  UINT64                 CacheGeneration;
 
   Task      = NULL;
   BlockIo   = Instance->BlockIo;
@@ -877,7 +1292,12 @@ DiskIo2ReadWriteDisk (
     Subtask->Task   = Task;
     SubtaskBlocking = Subtask->Blocking;
 
-    ASSERT ((Subtask->Length % Media->BlockSize == 0) || (Subtask->Length < Media->BlockSize));
+    //
+    // Only a working buffer holds partial blocks.
+    //
+    ASSERT ((Subtask->WorkingBuffer != NULL) || (Subtask->Length % Media->BlockSize == 0));
+    TransferSize   = DiskIoSubtaskTransferSize (Subtask, Media->BlockSize);
+    TransferBuffer = (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer;
 
     if (Subtask->Write) {
       //
@@ -890,23 +1310,32 @@ DiskIo2ReadWriteDisk (
         CopyMem (Subtask->WorkingBuffer + Subtask->Offset, Subtask->Buffer, Subtask->Length);
       }
 
+      DiskIoCacheWriteStart (Instance, Subtask->Lba, TransferSize / Media->BlockSize);
+
       if (SubtaskBlocking) {
         Status = BlockIo->WriteBlocks (
                             BlockIo,
                             MediaId,
                             Subtask->Lba,
-                            (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
-                            (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                            TransferSize,
+                            TransferBuffer
                             );
+        DiskIoCacheWriteEnd (Instance, Subtask->Lba, TransferSize / Media->BlockSize);
       } else {
         Status = BlockIo2->WriteBlocksEx (
                              BlockIo2,
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
-                             (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                             TransferSize,
+                             TransferBuffer
                              );
+        if (EFI_ERROR (Status)) {
+          //
+          // The callback won't be called for a write that failed to start.
+          //
+          DiskIoCacheWriteEnd (Instance, Subtask->Lba, TransferSize / Media->BlockSize);
+        }
       }
 
     } else {
@@ -914,24 +1343,38 @@ DiskIo2ReadWriteDisk (
       // Read
       //
       if (SubtaskBlocking) {
-        Status = BlockIo->ReadBlocks (
-                            BlockIo,
-                            MediaId,
-                            Subtask->Lba,
-                            (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
-                            (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
-                            );
+        if (DiskIoCacheRead (Instance, MediaId, Subtask->Lba, TransferSize / Media->BlockSize, TransferBuffer, &CacheGeneration)) {
+          Status = EFI_SUCCESS;
+        } else {
+          mDiskIoDeviceReads++;
+          Status = BlockIo->ReadBlocks (
+                              BlockIo,
+                              MediaId,
+                              Subtask->Lba,
+                              TransferSize,
+                              TransferBuffer
+                              );
+          if (EFI_ERROR (Status)) {
+            //
+            // The media may have been changed or removed.
+            //
+            DiskIoCacheInvalidate (Instance, 0, MAX_UINT64);
+          } else {
+            DiskIoCacheInsert (Instance, MediaId, Subtask->Lba, TransferSize / Media->BlockSize, TransferBuffer, CacheGeneration);
+          }
+        }
         if (!EFI_ERROR (Status) && (Subtask->WorkingBuffer != NULL)) {
           CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
         }
       } else {
+        mDiskIoDeviceReads++;
         Status = BlockIo2->ReadBlocksEx (
                              BlockIo2,
                              MediaId,
                              Subtask->Lba,
                              &Subtask->BlockIo2Token,
-                             (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
-                             (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                             TransferSize,
+                             TransferBuffer
                              );
       }
     }
@@ -1250,6 +1693,7 @@ InitializeDiskIo (
   )
 {
   EFI_STATUS              Status;
+  EFI_EVENT               ReadyToBootEvent;
 
   //
   // Install driver model protocol(s).
@@ -1264,5 +1708,9 @@ InitializeDiskIo (
              );
   ASSERT_EFI_ERROR (Status);
 
+  DEBUG_CODE_BEGIN ();
+    EfiCreateEventReadyToBootEx (TPL_CALLBACK, DiskIoOnReadyToBoot, NULL, &ReadyToBootEvent);
+  DEBUG_CODE_END ();
+
   return Status;
 }
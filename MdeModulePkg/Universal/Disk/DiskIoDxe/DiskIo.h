@@ -30,6 +30,18 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+//
+// Blocking reads of at most this many blocks go through the block cache,
+// larger ones would only evict the metadata blocks worth keeping.
+//
+#define DISK_IO_CACHE_READ_MAX_BLOCKS   4
+
+typedef struct {
+  UINT64                          Lba;
+  UINT64                          LastUsed; /// < 0 indicates a free entry
+  UINT8                           *Data;
+} DISK_IO_CACHE_BLOCK;
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                          Signature;
@@ -43,6 +55,20 @@ typedef struct {
 
   EFI_LOCK                        TaskQueueLock;
   LIST_ENTRY                      TaskQueue;
+
+  //
+  // LRU cache of the blocks read by small blocking reads, dropped on
+  // writes to the blocks and when the media changes. CacheGeneration counts
+  // the drops, so a read that raced with a write doesn't insert stale data.
+  //
+  EFI_LOCK                        CacheLock;
+  UINTN                           CacheBlockNum;    /// < 0 indicates the cache is disabled
+  DISK_IO_CACHE_BLOCK             *CacheBlocks;
+  UINT8                           *CacheBuffer;
+  UINT32                          CacheMediaId;
+  UINT64                          CacheClock;
+  UINT64                          CacheGeneration;
+  UINTN                           CacheWritesPending;
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a) CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
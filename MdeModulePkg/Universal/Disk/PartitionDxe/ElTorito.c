@@ -92,7 +92,7 @@ PartitionInstallElToritoChildHandles (
   for (VolDescriptorOffset = SIZE_32KB;
        VolDescriptorOffset <= MultU64x32 (Media->LastBlock, Media->BlockSize);
        VolDescriptorOffset += SIZE_2KB) {
-    Status = DiskIo->ReadDisk (
+    Status = PartitionReadDisk (
                        DiskIo,
                        Media->MediaId,
                        VolDescriptorOffset,
@@ -245,7 +245,7 @@ PartitionInstallGptChildHandles (
   //
   // Read the Protective MBR from LBA #0
   //
-  Status = DiskIo->ReadDisk (
+  Status = PartitionReadDisk (
                      DiskIo,
                      MediaId,
                      0,
@@ -329,7 +329,7 @@ PartitionInstallGptChildHandles (
     goto Done;
   }
 
-  Status = DiskIo->ReadDisk (
+  Status = PartitionReadDisk (
                      DiskIo,
                      MediaId,
                      MultU64x32(PrimaryHeader->PartitionEntryLBA, BlockSize),
@@ -476,7 +476,7 @@ PartitionValidGptTable (
   //
   // Read the EFI Partition Table Header
   //
-  Status = DiskIo->ReadDisk (
+  Status = PartitionReadDisk (
                      DiskIo,
                      MediaId,
                      MultU64x32 (Lba, BlockSize),
@@ -550,7 +550,7 @@ PartitionCheckGptEntryArrayCRC (
     return FALSE;
   }
 
-  Status = DiskIo->ReadDisk (
+  Status = PartitionReadDisk (
                     DiskIo,
                     BlockIo->Media->MediaId,
                     MultU64x32(PartHeader->PartitionEntryLBA, BlockIo->Media->BlockSize),
@@ -153,7 +153,7 @@ PartitionInstallMbrChildHandles (
     return Found;
   }
 
-  Status = DiskIo->ReadDisk (
+  Status = PartitionReadDisk (
                      DiskIo,
                      MediaId,
                      0,
@@ -48,6 +48,477 @@ PARTITION_DETECT_ROUTINE mPartitionDetectRoutineTable[] = {
   NULL
 };
 
+//
+// Media head read aheads of the Block IO2 devices that this driver isn't
+// started on yet, one for each device. Only accessed at TPL_CALLBACK.
+//
+LIST_ENTRY               mPartitionProbeList = INITIALIZE_LIST_HEAD_VARIABLE (mPartitionProbeList);
+
+//
+// Read ahead of the device being probed.
+//
+PARTITION_PROBE          *mPartitionProbe    = NULL;
+
+//
+// Registration of the Block IO2 install notification, and the event which
+// drops the unconsumed read aheads at ready to boot.
+//
+VOID                     *mPartitionProbeRegistration;
+EFI_EVENT                mPartitionProbeEvent      = NULL;
+EFI_EVENT                mPartitionReadyToBootEvent = NULL;
+
+/**
+  Get the time between two performance counter values in microseconds.
+
+  @param[in]  Begin       The performance counter value at the beginning.
+  @param[in]  End         The performance counter value at the end.
+
+  @return The elapsed time in microseconds.
+
+**/
+UINT64
+PartitionElapsedMicroSeconds (
+  IN UINT64               Begin,
+  IN UINT64               End
+  )
+{
+  UINT64                  CounterStart;
+  UINT64                  CounterEnd;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  return DivU64x32 (GetTimeInNanoSecond ((CounterStart > CounterEnd) ? (Begin - End) : (End - Begin)), 1000);
+}
+
+/**
+  Release the buffer, the event and the read ahead itself.
+
+  @param[in]  Probe       The read ahead.
+
+**/
+VOID
+PartitionProbeRelease (
+  IN PARTITION_PROBE      *Probe
+  )
+{
+  if (Probe->Token.Event != NULL) {
+    gBS->CloseEvent (Probe->Token.Event);
+  }
+  if (Probe->Buffer != NULL) {
+    FreeAlignedPages (Probe->Buffer, EFI_SIZE_TO_PAGES (Probe->BufferSize));
+  }
+  FreePool (Probe);
+}
+
+/**
+  The callback for the BlockIo2 ReadBlocksEx of the read ahead.
+
+  @param[in]  Event       Event whose notification function is being invoked.
+  @param[in]  Context     The pointer to the notification function's context,
+                          which points to the PARTITION_PROBE instance.
+
+**/
+VOID
+EFIAPI
+PartitionOnProbeComplete (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  PARTITION_PROBE         *Probe;
+
+  Probe = (PARTITION_PROBE *) Context;
+  ASSERT (Probe->Signature == PARTITION_PROBE_SIGNATURE);
+
+  Probe->CompleteTime = GetPerformanceCounter ();
+  Probe->Completed    = TRUE;
+
+  if (Probe->Abandoned) {
+    PartitionProbeRelease (Probe);
+  }
+}
+
+/**
+  Free the read ahead after it is removed from the list. The Block IO2
+  opened for it is closed. If the read is still in flight the read ahead is
+  freed once the read completes.
+
+  @param[in]  Probe             The read ahead.
+
+**/
+VOID
+PartitionProbeFree (
+  IN PARTITION_PROBE               *Probe
+  )
+{
+  EFI_TPL                          OldTpl;
+
+  gBS->CloseProtocol (
+         Probe->Handle,
+         &gEfiBlockIo2ProtocolGuid,
+         gPartitionDriverBinding.DriverBindingHandle,
+         NULL
+         );
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Probe->Completed) {
+    PartitionProbeRelease (Probe);
+  } else {
+    Probe->Abandoned = TRUE;
+  }
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Remove the read ahead of the device from the list and free it. The caller
+  is at TPL_CALLBACK.
+
+  @param[in]  Handle      Handle of the device.
+  @param[in]  BlockIo2    The Block IO2 instance opened on the device, or NULL
+                          to match any instance.
+
+  @return The read ahead removed from the list, which the caller owns, or
+          NULL if there is none.
+
+**/
+PARTITION_PROBE *
+PartitionProbeRemove (
+  IN EFI_HANDLE               Handle,
+  IN EFI_BLOCK_IO2_PROTOCOL   *BlockIo2 OPTIONAL
+  )
+{
+  LIST_ENTRY              *Link;
+  PARTITION_PROBE         *Probe;
+
+  for (Link = GetFirstNode (&mPartitionProbeList); !IsNull (&mPartitionProbeList, Link); Link = GetNextNode (&mPartitionProbeList, Link)) {
+    Probe = CR (Link, PARTITION_PROBE, Link, PARTITION_PROBE_SIGNATURE);
+    if ((Probe->Handle == Handle) && ((BlockIo2 == NULL) || (Probe->BlockIo2 == BlockIo2))) {
+      RemoveEntryList (&Probe->Link);
+      return Probe;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Read ahead the media head of a Block IO2 device which this driver isn't
+  started on, so that the reads of the devices are in flight together as
+  they are installed, rather than issued one after another as each device
+  is started. The Block IO2 is opened by this driver until the read ahead
+  is freed.
+
+  @param[in]  Handle      Handle of the device.
+
+**/
+VOID
+PartitionProbeReadAhead (
+  IN EFI_HANDLE           Handle
+  )
+{
+  EFI_STATUS              Status;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  EFI_BLOCK_IO_MEDIA      *Media;
+  PARTITION_PROBE         *Probe;
+  UINT64                  Blocks;
+
+  //
+  // A reinstalled Block IO2 gets a new read ahead.
+  //
+  Probe = PartitionProbeRemove (Handle, NULL);
+  if (Probe != NULL) {
+    PartitionProbeFree (Probe);
+  }
+
+  if (!EFI_ERROR (EfiTestManagedDevice (Handle, gPartitionDriverBinding.DriverBindingHandle, &gEfiDiskIoProtocolGuid))) {
+    return;
+  }
+
+  Status = gBS->OpenProtocol (
+                  Handle,
+                  &gEfiBlockIo2ProtocolGuid,
+                  (VOID **) &BlockIo2,
+                  gPartitionDriverBinding.DriverBindingHandle,
+                  NULL,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // Partitions rarely hold partition tables themselves, so only the whole
+  // devices are read ahead.
+  //
+  Media = BlockIo2->Media;
+  if (!Media->MediaPresent || Media->LogicalPartition || (Media->BlockSize == 0)) {
+    goto Error;
+  }
+
+  Probe = AllocateZeroPool (sizeof (PARTITION_PROBE));
+  if (Probe == NULL) {
+    goto Error;
+  }
+
+  Blocks            = MIN ((PARTITION_PROBE_READ_SIZE + Media->BlockSize - 1) / Media->BlockSize, Media->LastBlock + 1);
+  Probe->Signature  = PARTITION_PROBE_SIGNATURE;
+  Probe->Handle     = Handle;
+  Probe->BlockIo2   = BlockIo2;
+  Probe->MediaId    = Media->MediaId;
+  Probe->BufferSize = (UINTN) MultU64x32 (Blocks, Media->BlockSize);
+  Probe->Buffer     = AllocateAlignedPages (EFI_SIZE_TO_PAGES (Probe->BufferSize), Media->IoAlign);
+  if (Probe->Buffer == NULL) {
+    FreePool (Probe);
+    goto Error;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  PartitionOnProbeComplete,
+                  Probe,
+                  &Probe->Token.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    FreeAlignedPages (Probe->Buffer, EFI_SIZE_TO_PAGES (Probe->BufferSize));
+    FreePool (Probe);
+    goto Error;
+  }
+
+  Probe->IssueTime = GetPerformanceCounter ();
+  Status = BlockIo2->ReadBlocksEx (
+                       BlockIo2,
+                       Probe->MediaId,
+                       0,
+                       &Probe->Token,
+                       Probe->BufferSize,
+                       Probe->Buffer
+                       );
+  if (EFI_ERROR (Status)) {
+    PartitionProbeRelease (Probe);
+    goto Error;
+  }
+
+  InsertTailList (&mPartitionProbeList, &Probe->Link);
+  return;
+
+Error:
+  gBS->CloseProtocol (
+         Handle,
+         &gEfiBlockIo2ProtocolGuid,
+         gPartitionDriverBinding.DriverBindingHandle,
+         NULL
+         );
+}
+
+/**
+  The notification of the Block IO2 installation, which reads ahead the
+  media heads of the newly installed devices.
+
+  @param[in]  Event       Event whose notification function is being invoked.
+  @param[in]  Context     The pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+PartitionOnBlockIo2Installed (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  EFI_STATUS              Status;
+  EFI_HANDLE              Handle;
+  UINTN                   BufferSize;
+
+  while (TRUE) {
+    BufferSize = sizeof (EFI_HANDLE);
+    Status = gBS->LocateHandle (
+                    ByRegisterNotify,
+                    NULL,
+                    mPartitionProbeRegistration,
+                    &BufferSize,
+                    &Handle
+                    );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    PartitionProbeReadAhead (Handle);
+  }
+}
+
+/**
+  Drop the read aheads not consumed by the time to boot, and stop reading
+  ahead the devices installed afterwards.
+
+  @param[in]  Event       Event whose notification function is being invoked.
+  @param[in]  Context     The pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+PartitionOnReadyToBoot (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  PARTITION_PROBE         *Probe;
+
+  if (mPartitionProbeEvent != NULL) {
+    gBS->CloseEvent (mPartitionProbeEvent);
+    mPartitionProbeEvent = NULL;
+  }
+
+  while (!IsListEmpty (&mPartitionProbeList)) {
+    Probe = CR (GetFirstNode (&mPartitionProbeList), PARTITION_PROBE, Link, PARTITION_PROBE_SIGNATURE);
+    RemoveEntryList (&Probe->Link);
+    PartitionProbeFree (Probe);
+  }
+
+  gBS->CloseEvent (Event);
+  mPartitionReadyToBootEvent = NULL;
+}
+
+/**
+  Start reading ahead the media heads of the Block IO2 devices as they are
+  installed, if PcdPartitionReadAhead is enabled.
+
+**/
+VOID
+PartitionProbeInit (
+  VOID
+  )
+{
+  EFI_STATUS              Status;
+
+  if (!FeaturePcdGet (PcdPartitionReadAhead)) {
+    return;
+  }
+
+  mPartitionProbeEvent = EfiCreateProtocolNotifyEvent (
+                           &gEfiBlockIo2ProtocolGuid,
+                           TPL_CALLBACK,
+                           PartitionOnBlockIo2Installed,
+                           NULL,
+                           &mPartitionProbeRegistration
+                           );
+  if (mPartitionProbeEvent == NULL) {
+    return;
+  }
+
+  Status = EfiCreateEventReadyToBootEx (
+             TPL_CALLBACK,
+             PartitionOnReadyToBoot,
+             NULL,
+             &mPartitionReadyToBootEvent
+             );
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (mPartitionProbeEvent);
+    mPartitionProbeEvent = NULL;
+  }
+}
+
+/**
+  Take the read ahead of the device for probing it. It waits for the read
+  to complete when the TPL of the caller lets the completion be signaled.
+  A read ahead is only taken once, a device probed again later reads the
+  media through the Disk IO.
+
+  @param[in]  Handle            Handle of the device.
+  @param[in]  BlockIo2          The Block IO2 instance the caller opened on
+                                the device.
+
+  @return The read ahead of the device, which the caller frees with
+          PartitionProbeFree(), or NULL if there is none.
+
+**/
+PARTITION_PROBE *
+PartitionProbeTake (
+  IN EFI_HANDLE                    Handle,
+  IN EFI_BLOCK_IO2_PROTOCOL        *BlockIo2
+  )
+{
+  PARTITION_PROBE                  *Probe;
+  EFI_TPL                          OldTpl;
+  UINTN                            Timeout;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Probe  = PartitionProbeRemove (Handle, BlockIo2);
+  gBS->RestoreTPL (OldTpl);
+  if (Probe == NULL) {
+    return NULL;
+  }
+
+  //
+  // The completion of the lower drivers may be signaled at TPL_CALLBACK,
+  // don't wait for it when it can't be signaled.
+  //
+  if (OldTpl < TPL_CALLBACK) {
+    for (Timeout = 0; !Probe->Completed && (Timeout < PARTITION_PROBE_TIMEOUT); Timeout += PARTITION_PROBE_POLL_INTERVAL) {
+      gBS->Stall (PARTITION_PROBE_POLL_INTERVAL);
+    }
+  }
+
+  return Probe;
+}
+
+/**
+  Drop the read ahead of the device, if there is one left.
+
+  @param[in]  Handle            Handle of the device.
+
+**/
+VOID
+PartitionProbeDrop (
+  IN EFI_HANDLE                    Handle
+  )
+{
+  PARTITION_PROBE                  *Probe;
+  EFI_TPL                          OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Probe  = PartitionProbeRemove (Handle, NULL);
+  gBS->RestoreTPL (OldTpl);
+  if (Probe != NULL) {
+    PartitionProbeFree (Probe);
+  }
+}
+
+/**
+  Read the media for probing the partition table. The read is served from
+  the read ahead of the device being probed when it covers the range, and
+  from the Disk IO otherwise.
+
+  @param[in]  DiskIo            Parent DiskIo interface.
+  @param[in]  MediaId           Id of the media.
+  @param[in]  Offset            The starting byte offset to read from.
+  @param[in]  BufferSize        Size of Buffer.
+  @param[out] Buffer            Buffer to hold the data read.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval other                 The Disk IO failed to read the data.
+
+**/
+EFI_STATUS
+PartitionReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL         *DiskIo,
+  IN  UINT32                       MediaId,
+  IN  UINT64                       Offset,
+  IN  UINTN                        BufferSize,
+  OUT VOID                         *Buffer
+  )
+{
+  PARTITION_PROBE                  *Probe;
+
+  Probe = mPartitionProbe;
+  if ((Probe != NULL) && (Probe->DiskIo == DiskIo) && Probe->Completed &&
+      !EFI_ERROR (Probe->Token.TransactionStatus) && (Probe->MediaId == MediaId) &&
+      (Offset <= Probe->BufferSize) && (BufferSize <= Probe->BufferSize - Offset)) {
+    CopyMem (Buffer, Probe->Buffer + Offset, BufferSize);
+    return EFI_SUCCESS;
+  }
+
+  return DiskIo->ReadDisk (DiskIo, MediaId, Offset, BufferSize, Buffer);
+}
+
 /**
   Test to see if this driver supports ControllerHandle. Any ControllerHandle
   than contains a BlockIo and DiskIo protocol or a BlockIo2 protocol can be
@@ -202,6 +673,26 @@ PartitionDriverBindingStart (
   PARTITION_DETECT_ROUTINE  *Routine;
   BOOLEAN                   MediaPresent;
   EFI_TPL                   OldTpl;
+  PARTITION_PROBE           *Probe;
+  PARTITION_PROBE           *PreviousProbe;
+  UINT64                    StartTime;
+
+  //
+  // Wait for the media head read ahead of this device before raising the TPL.
+  //
+  StartTime = GetPerformanceCounter ();
+  Probe     = NULL;
+  Status    = gBS->OpenProtocol (
+                     ControllerHandle,
+                     &gEfiBlockIo2ProtocolGuid,
+                     (VOID **) &BlockIo2,
+                     This->DriverBindingHandle,
+                     ControllerHandle,
+                     EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                     );
+  if (!EFI_ERROR (Status)) {
+    Probe = PartitionProbeTake (ControllerHandle, BlockIo2);
+  }
 
   BlockIo2 = NULL;
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK); 
@@ -309,6 +800,12 @@ PartitionDriverBindingStart (
     // media supports a given partition type install child handles to represent
     // the partitions described by the media.
     //
+    PreviousProbe   = mPartitionProbe;
+    mPartitionProbe = Probe;
+    if (Probe != NULL) {
+      Probe->DiskIo = DiskIo;
+    }
+
     Routine = &mPartitionDetectRoutineTable[0];
     while (*Routine != NULL) {
       Status = (*Routine) (
@@ -325,6 +822,29 @@ PartitionDriverBindingStart (
       }
       Routine++;
     }
+
+    mPartitionProbe = PreviousProbe;
+
+    DEBUG_CODE_BEGIN ();
+      if ((Probe != NULL) && Probe->Completed) {
+        DEBUG ((
+          EFI_D_INFO,
+          "Partition: Probed %p in %ld us (%r), media head read ahead in %ld us\n",
+          ControllerHandle,
+          PartitionElapsedMicroSeconds (StartTime, GetPerformanceCounter ()),
+          Status,
+          PartitionElapsedMicroSeconds (Probe->IssueTime, Probe->CompleteTime)
+          ));
+      } else {
+        DEBUG ((
+          EFI_D_INFO,
+          "Partition: Probed %p in %ld us (%r) without read ahead\n",
+          ControllerHandle,
+          PartitionElapsedMicroSeconds (StartTime, GetPerformanceCounter ()),
+          Status
+          ));
+      }
+    DEBUG_CODE_END ();
   }
   //
   // In the case that the driver is already started (OpenStatus == EFI_ALREADY_STARTED),
@@ -367,6 +887,9 @@ PartitionDriverBindingStart (
   }
 
 Exit:
+  if (Probe != NULL) {
+    PartitionProbeFree (Probe);
+  }
   gBS->RestoreTPL (OldTpl);
   return Status;
 }
@@ -417,6 +940,8 @@ PartitionDriverBindingStop (
       return EFI_DEVICE_ERROR;
     }
 
+    PartitionProbeDrop (ControllerHandle);
+
     //
     // Close the bus driver
     //
@@ -1295,6 +1820,8 @@ InitializePartition (
              );
   ASSERT_EFI_ERROR (Status);
 
+  PartitionProbeInit ();
+
 
   return Status;
 }
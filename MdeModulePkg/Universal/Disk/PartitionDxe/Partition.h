@@ -35,6 +35,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/TimerLib.h>
+#include <Library/PcdLib.h>
 
 #include <IndustryStandard/Mbr.h>
 #include <IndustryStandard/ElTorito.h>
@@ -75,6 +77,38 @@ typedef struct {
 #define PARTITION_DEVICE_FROM_BLOCK_IO_THIS(a)  CR (a, PARTITION_PRIVATE_DATA, BlockIo, PARTITION_PRIVATE_DATA_SIGNATURE)
 #define PARTITION_DEVICE_FROM_BLOCK_IO2_THIS(a) CR (a, PARTITION_PRIVATE_DATA, BlockIo2, PARTITION_PRIVATE_DATA_SIGNATURE)
 
+//
+// Size of the media head read ahead for probing the partition table. It
+// holds the protective MBR, the GPT header and the GPT partition entries
+// following it on 512 bytes block media, and the first El Torito volume
+// descriptor at 32KB.
+//
+#define PARTITION_PROBE_READ_SIZE     (SIZE_32KB + SIZE_2KB)
+
+//
+// Time to wait for the read ahead of a device before probing it with the
+// blocking Disk IO, in microseconds.
+//
+#define PARTITION_PROBE_TIMEOUT       (5 * 1000 * 1000)
+#define PARTITION_PROBE_POLL_INTERVAL 100
+
+#define PARTITION_PROBE_SIGNATURE     SIGNATURE_32 ('P', 'r', 'b', 'e')
+typedef struct {
+  UINT32                    Signature;
+  LIST_ENTRY                Link;
+  EFI_HANDLE                Handle;
+  EFI_BLOCK_IO2_PROTOCOL    *BlockIo2;
+  EFI_DISK_IO_PROTOCOL      *DiskIo;    ///< Disk IO the probe reads are served for
+  UINT32                    MediaId;
+  UINTN                     BufferSize;
+  UINT8                     *Buffer;
+  EFI_BLOCK_IO2_TOKEN       Token;
+  volatile BOOLEAN          Completed;
+  BOOLEAN                   Abandoned;  ///< TRUE: freed by the completion
+  UINT64                    IssueTime;
+  UINT64                    CompleteTime;
+} PARTITION_PROBE;
+
 //
 // Global Variables
 //
@@ -346,6 +380,84 @@ PartitionInstallChildHandle (
   IN  BOOLEAN                      InstallEspGuid
   );
 
+/**
+  Start reading ahead the media heads of the Block IO2 devices as they are
+  installed, if PcdPartitionReadAhead is enabled.
+
+**/
+VOID
+PartitionProbeInit (
+  VOID
+  );
+
+/**
+  Take the read ahead of the device for probing it. It waits for the read
+  to complete when the TPL of the caller lets the completion be signaled.
+  A read ahead is only taken once, a device probed again later reads the
+  media through the Disk IO.
+
+  @param[in]  Handle            Handle of the device.
+  @param[in]  BlockIo2          The Block IO2 instance the caller opened on
+                                the device.
+
+  @return The read ahead of the device, which the caller frees with
+          PartitionProbeFree(), or NULL if there is none.
+
+**/
+PARTITION_PROBE *
+PartitionProbeTake (
+  IN EFI_HANDLE                    Handle,
+  IN EFI_BLOCK_IO2_PROTOCOL        *BlockIo2
+  );
+
+/**
+  Free the read ahead after it is removed from the list. The Block IO2
+  opened for it is closed. If the read is still in flight the read ahead is
+  freed once the read completes.
+
+  @param[in]  Probe             The read ahead.
+
+**/
+VOID
+PartitionProbeFree (
+  IN PARTITION_PROBE               *Probe
+  );
+
+/**
+  Drop the read ahead of the device, if there is one left.
+
+  @param[in]  Handle            Handle of the device.
+
+**/
+VOID
+PartitionProbeDrop (
+  IN EFI_HANDLE                    Handle
+  );
+
+/**
+  Read the media for probing the partition table. The read is served from
+  the read ahead of the device being probed when it covers the range, and
+  from the Disk IO otherwise.
+
+  @param[in]  DiskIo            Parent DiskIo interface.
+  @param[in]  MediaId           Id of the media.
+  @param[in]  Offset            The starting byte offset to read from.
+  @param[in]  BufferSize        Size of Buffer.
+  @param[out] Buffer            Buffer to hold the data read.
+
+  @retval EFI_SUCCESS           The data was read.
+  @retval other                 The Disk IO failed to read the data.
+
+**/
+EFI_STATUS
+PartitionReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL         *DiskIo,
+  IN  UINT32                       MediaId,
+  IN  UINT64                       Offset,
+  IN  UINTN                        BufferSize,
+  OUT VOID                         *Buffer
+  );
+
 /**
   Test to see if there is any child on ControllerHandle.
 
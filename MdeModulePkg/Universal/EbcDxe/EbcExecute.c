@@ -42,6 +42,40 @@ UINT64
   IN UINT64     Op2
   );
 
+//
+// Instructions which have been decoded once are kept in a direct mapped cache
+// indexed by their address, so that executing them again doesn't need to
+// decode the opcode, operands and immediate data from the code stream.
+//
+#define EBC_DECODE_CACHE_SIZE   512   // Must be a power of 2
+#define EBC_DECODE_MAX_LENGTH   10
+
+typedef struct _EBC_DECODED_INSTRUCTION EBC_DECODED_INSTRUCTION;
+
+typedef
+VOID
+(*EBC_DECODED_EXECUTE_FUNCTION) (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  );
+
+struct _EBC_DECODED_INSTRUCTION {
+  UINT8                         *Ip;
+  EBC_DECODED_EXECUTE_FUNCTION  ExecuteFunction;
+  //
+  // The raw instruction, checked against the code stream on every hit so
+  // that self-modifying or reloaded code is decoded again.
+  //
+  UINT16                        Code[EBC_DECODE_MAX_LENGTH / sizeof (UINT16)];
+  UINT8                         Length;
+  UINT8                         Opcode;
+  UINT8                         Operand1;     // Register number of operand 1
+  UINT8                         Operand2;     // Register number of operand 2
+  BOOLEAN                       IsSignedOp;
+  INT64                         Immediate;    // Immediate data, index or jump offset
+  UINT64                        Mask;         // Mask of the result written to the register
+};
+
 /**
   Decode a 16-bit index to determine the offset. Given an index value:
 
@@ -1344,6 +1378,396 @@ CONST VM_TABLE_ENTRY           mVmOpcodeTable[] = {
 //
 CONST UINT8                    mJMPLen[] = { 2, 2, 6, 10 };
 
+EBC_DECODED_INSTRUCTION        mEbcDecodeCache[EBC_DECODE_CACHE_SIZE];
+
+//
+// TRUE while the decode cache is in use. The VM can be reentered from an
+// event notification interrupting it, and the reentered VM then leaves the
+// cache to the code it interrupted.
+//
+volatile BOOLEAN               mEbcDecodeCacheBusy;
+
+/**
+  Check that a decoded instruction still matches the code stream.
+
+  @param  Instruction       The decoded instruction.
+
+  @retval TRUE              The code at the address of the instruction is unchanged.
+  @retval FALSE             The code has been changed since it was decoded.
+
+**/
+STATIC
+BOOLEAN
+EbcCodeMatches (
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  CONST UINT16  *Code;
+  UINTN         Index;
+
+  //
+  // Only 16-bit aligned instructions are decoded.
+  //
+  Code = (CONST UINT16 *) Instruction->Ip;
+  for (Index = 0; Index < Instruction->Length / sizeof (UINT16); Index++) {
+    if (Code[Index] != Instruction->Code[Index]) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Execute a decoded JMP8 instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The decoded instruction.
+
+**/
+VOID
+ExecuteDecodedJMP8 (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8 CompareSet;
+
+  if ((Instruction->Opcode & CONDITION_M_CONDITIONAL) != 0) {
+    CompareSet = (UINT8) (((Instruction->Opcode & JMP_M_CS) != 0) ? 1 : 0);
+    if (CompareSet != (UINT8) VMFLAG_ISSET (VmPtr, VMFLAGS_CC)) {
+      VmPtr->Ip += Instruction->Length;
+      return;
+    }
+  }
+
+  VmPtr->Ip += Instruction->Immediate;
+}
+
+/**
+  Execute a decoded MOVI instruction with a register destination.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The decoded instruction.
+
+**/
+VOID
+ExecuteDecodedMOVI (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  VmPtr->Gpr[Instruction->Operand1] = Instruction->Immediate & Instruction->Mask;
+  VmPtr->Ip += Instruction->Length;
+}
+
+/**
+  Execute a decoded MOVxx instruction with register source and destination.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The decoded instruction.
+
+**/
+VOID
+ExecuteDecodedMOVxx (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  VmPtr->Gpr[Instruction->Operand1] = ((UINT64) VmPtr->Gpr[Instruction->Operand2] + Instruction->Immediate) & Instruction->Mask;
+  VmPtr->Ip += Instruction->Length;
+}
+
+/**
+  Execute a decoded data manipulation instruction with register operands.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The decoded instruction.
+
+**/
+VOID
+ExecuteDecodedDataManip (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT64  Op1;
+  UINT64  Op2;
+
+  Op2 = (UINT64) VmPtr->Gpr[Instruction->Operand2] + Instruction->Immediate;
+  Op1 = (UINT64) VmPtr->Gpr[Instruction->Operand1];
+  if ((Instruction->Opcode & DATAMANIP_M_64) == 0) {
+    if (Instruction->IsSignedOp) {
+      Op2 = (UINT64) (INT64) ((INT32) Op2);
+      Op1 = (UINT64) (INT64) ((INT32) Op1);
+    } else {
+      Op2 = (UINT64) ((UINT32) Op2);
+      Op1 = (UINT64) ((UINT32) Op1);
+    }
+  }
+
+  Op2 = mDataManipDispatchTable[(Instruction->Opcode & OPCODE_M_OPCODE) - OPCODE_NOT](VmPtr, Op1, Op2);
+
+  VmPtr->Gpr[Instruction->Operand1] = Op2 & Instruction->Mask;
+  VmPtr->Ip += Instruction->Length;
+}
+
+/**
+  Execute a decoded CMP instruction with a register operand 2.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The decoded instruction.
+
+**/
+VOID
+ExecuteDecodedCMP (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  INT64   Op1;
+  INT64   Op2;
+  BOOLEAN Flag;
+
+  Op1 = VmPtr->Gpr[Instruction->Operand1];
+  Op2 = VmPtr->Gpr[Instruction->Operand2] + Instruction->Immediate;
+
+  if ((Instruction->Opcode & OPCODE_M_64BIT) == 0) {
+    //
+    // 32-bit compares only look at the lower 32 bits, extended by the signedness.
+    //
+    if (Instruction->IsSignedOp) {
+      Op1 = (INT32) Op1;
+      Op2 = (INT32) Op2;
+    } else {
+      Op1 = (UINT32) Op1;
+      Op2 = (UINT32) Op2;
+    }
+  }
+
+  switch (Instruction->Opcode & OPCODE_M_OPCODE) {
+  case OPCODE_CMPEQ:
+    Flag = (BOOLEAN) (Op1 == Op2);
+    break;
+
+  case OPCODE_CMPLTE:
+    Flag = (BOOLEAN) (Op1 <= Op2);
+    break;
+
+  case OPCODE_CMPGTE:
+    Flag = (BOOLEAN) (Op1 >= Op2);
+    break;
+
+  case OPCODE_CMPULTE:
+    Flag = (BOOLEAN) ((UINT64) Op1 <= (UINT64) Op2);
+    break;
+
+  default:
+    Flag = (BOOLEAN) ((UINT64) Op1 >= (UINT64) Op2);
+    break;
+  }
+
+  if (Flag) {
+    VMFLAG_SET (VmPtr, VMFLAGS_CC);
+  } else {
+    VMFLAG_CLEAR (VmPtr, (UINT64)VMFLAGS_CC);
+  }
+
+  VmPtr->Ip += Instruction->Length;
+}
+
+/**
+  Decode the instruction at the IP of the VM into the decoded form.
+
+  Only the most frequent instruction forms which operate on registers are
+  decoded, every other instruction (memory operands, calls, returns, invalid
+  encodings, ...) is left to the interpreter, which also reports any exception.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       Returns the decoded instruction.
+
+  @retval TRUE              The instruction is decoded.
+  @retval FALSE             The instruction must be executed by the interpreter.
+
+**/
+BOOLEAN
+EbcDecodeInstruction (
+  IN  VM_CONTEXT               *VmPtr,
+  OUT EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Opcode;
+  UINT8   OpcMasked;
+  UINT8   Operands;
+
+  Opcode    = GETOPCODE (VmPtr);
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+  Operands  = GETOPERANDS (VmPtr);
+
+  ZeroMem (Instruction, sizeof (EBC_DECODED_INSTRUCTION));
+  Instruction->Ip        = VmPtr->Ip;
+  Instruction->Opcode    = Opcode;
+  Instruction->Operand1  = (UINT8) OPERAND1_REGNUM (Operands);
+  Instruction->Operand2  = (UINT8) OPERAND2_REGNUM (Operands);
+  Instruction->Length    = 2;
+  Instruction->Mask      = (UINT64)~0;
+
+  if (OpcMasked == OPCODE_JMP8) {
+    //
+    // The offset is relative to the following instruction, and divided by 2.
+    //
+    Instruction->Immediate       = (INT64) VmReadImmed8 (VmPtr, 1) * 2 + 2;
+    Instruction->ExecuteFunction = ExecuteDecodedJMP8;
+  } else if (OpcMasked == OPCODE_MOVI) {
+    if (OPERAND1_INDIRECT (Operands) || ((Operands & MOVI_M_IMMDATA) != 0)) {
+      return FALSE;
+    }
+
+    if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH16) {
+      Instruction->Immediate = (INT64) (INT16) VmReadImmed16 (VmPtr, 2);
+      Instruction->Length    = 4;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH32) {
+      Instruction->Immediate = (INT64) (INT32) VmReadImmed32 (VmPtr, 2);
+      Instruction->Length    = 6;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH64) {
+      Instruction->Immediate = (INT64) VmReadImmed64 (VmPtr, 2);
+      Instruction->Length    = 10;
+    } else {
+      return FALSE;
+    }
+
+    if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH8) {
+      Instruction->Mask = 0x000000FF;
+    } else if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH16) {
+      Instruction->Mask = 0x0000FFFF;
+    } else if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH32) {
+      Instruction->Mask = 0x00000000FFFFFFFF;
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedMOVI;
+  } else if (((OpcMasked >= OPCODE_MOVBW) && (OpcMasked <= OPCODE_MOVQD)) ||
+             (OpcMasked == OPCODE_MOVQQ) || (OpcMasked == OPCODE_MOVNW) || (OpcMasked == OPCODE_MOVND)) {
+    if (OPERAND1_INDIRECT (Operands) || OPERAND2_INDIRECT (Operands) ||
+        ((Opcode & OPCODE_M_IMMED_OP1) != 0)) {
+      return FALSE;
+    }
+
+    if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+      if ((OpcMasked <= OPCODE_MOVQW) || (OpcMasked == OPCODE_MOVNW)) {
+        Instruction->Immediate = (INT64) VmReadIndex16 (VmPtr, 2);
+        Instruction->Length    = 4;
+      } else if ((OpcMasked <= OPCODE_MOVQD) || (OpcMasked == OPCODE_MOVND)) {
+        Instruction->Immediate = (INT64) VmReadIndex32 (VmPtr, 2);
+        Instruction->Length    = 6;
+      } else {
+        Instruction->Immediate = VmReadIndex64 (VmPtr, 2);
+        Instruction->Length    = 10;
+      }
+    }
+
+    if ((OpcMasked == OPCODE_MOVBW) || (OpcMasked == OPCODE_MOVBD)) {
+      Instruction->Mask = 0xFF;
+    } else if ((OpcMasked == OPCODE_MOVWW) || (OpcMasked == OPCODE_MOVWD)) {
+      Instruction->Mask = 0xFFFF;
+    } else if ((OpcMasked == OPCODE_MOVDW) || (OpcMasked == OPCODE_MOVDD)) {
+      Instruction->Mask = 0xFFFFFFFF;
+    } else if ((OpcMasked == OPCODE_MOVNW) || (OpcMasked == OPCODE_MOVND)) {
+      Instruction->Mask = (UINT64)~0 >> (64 - 8 * sizeof (UINTN));
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedMOVxx;
+  } else if ((OpcMasked >= OPCODE_NOT) && (OpcMasked <= OPCODE_EXTNDD)) {
+    if (OPERAND1_INDIRECT (Operands) || OPERAND2_INDIRECT (Operands)) {
+      return FALSE;
+    }
+
+    if ((Opcode & DATAMANIP_M_IMMDATA) != 0) {
+      Instruction->Immediate = (INT64) VmReadImmed16 (VmPtr, 2);
+      Instruction->Length    = 4;
+    }
+
+    if ((Opcode & DATAMANIP_M_64) == 0) {
+      Instruction->Mask = 0xFFFFFFFF;
+    }
+
+    Instruction->IsSignedOp      = (BOOLEAN) (mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteSignedDataManip);
+    Instruction->ExecuteFunction = ExecuteDecodedDataManip;
+  } else if ((OpcMasked >= OPCODE_CMPEQ) && (OpcMasked <= OPCODE_CMPUGTE)) {
+    if (OPERAND1_INDIRECT (Operands) || OPERAND2_INDIRECT (Operands)) {
+      return FALSE;
+    }
+
+    if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+      Instruction->Immediate = (INT64) VmReadImmed16 (VmPtr, 2);
+      Instruction->Length    = 4;
+    }
+
+    Instruction->IsSignedOp      = (BOOLEAN) ((OpcMasked == OPCODE_CMPEQ) || (OpcMasked == OPCODE_CMPLTE) ||
+                                              (OpcMasked == OPCODE_CMPGTE));
+    Instruction->ExecuteFunction = ExecuteDecodedCMP;
+  } else {
+    return FALSE;
+  }
+
+  CopyMem (Instruction->Code, VmPtr->Ip, Instruction->Length);
+  return TRUE;
+}
+
+/**
+  Execute the instruction at the IP of the VM from the decode cache.
+
+  The instruction is looked up in the decode cache by its address and
+  its raw bytes, and decoded into the cache on a miss. The caller owns the
+  cache through mEbcDecodeCacheBusy while this runs.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval TRUE              The instruction is executed.
+  @retval FALSE             The instruction isn't executed and must be run by
+                            the interpreter.
+
+**/
+STATIC
+BOOLEAN
+EbcExecuteDecoded (
+  IN VM_CONTEXT *VmPtr
+  )
+{
+  EBC_DECODED_INSTRUCTION  *Instruction;
+  EBC_DECODED_INSTRUCTION  Decoded;
+
+  //
+  // Leave misaligned code to the interpreter so that it keeps reporting
+  // the alignment check on every execution.
+  //
+  if (!IS_ALIGNED ((UINTN) VmPtr->Ip, sizeof (UINT16))) {
+    return FALSE;
+  }
+
+  Instruction = &mEbcDecodeCache[((UINTN) VmPtr->Ip >> 1) & (EBC_DECODE_CACHE_SIZE - 1)];
+  if ((Instruction->Ip != VmPtr->Ip) || !EbcCodeMatches (Instruction)) {
+    if (!EbcDecodeInstruction (VmPtr, &Decoded)) {
+      //
+      // Whether an instruction is decoded only depends on its first two
+      // bytes, so an entry without execute function is enough to leave it
+      // to the interpreter straight away the next time.
+      //
+      Decoded.ExecuteFunction = NULL;
+      Decoded.Length          = sizeof (UINT16);
+      Decoded.Code[0]         = *(UINT16 *) VmPtr->Ip;
+    }
+
+    CopyMem (Instruction, &Decoded, sizeof (Decoded));
+  }
+
+  if (Instruction->ExecuteFunction == NULL) {
+    return FALSE;
+  }
+
+  Instruction->ExecuteFunction (VmPtr, Instruction);
+  return TRUE;
+}
+
 /**
   Given a pointer to a new VM context, execute one or more instructions. This
   function is only used for test purposes via the EBC VM test protocol.
@@ -1427,6 +1851,8 @@ EbcExecute (
   UINT8                             StackCorrupted;
   EFI_STATUS                        Status;
   EFI_EBC_SIMPLE_DEBUGGER_PROTOCOL  *EbcSimpleDebugger;
+  BOOLEAN                           Decoded;
+  BOOLEAN                           UseDecodeCache;
 
   mVmPtr            = VmPtr;
   EbcSimpleDebugger = NULL;
@@ -1488,16 +1914,44 @@ EbcExecute (
       Status = EFI_UNSUPPORTED;
       goto Done;
     }
+    //
+    // Run the instruction from the decode cache if it is enabled, unless a
+    // debugger is attached or single stepping, which need the interpreter,
+    // or this VM interrupted another one using the cache.
+    //
+    UseDecodeCache = (BOOLEAN) (FeaturePcdGet (PcdEbcDecodeCache) && !mEbcDecodeCacheBusy &&
+                                (EbcSimpleDebugger == NULL) && !VMFLAG_ISSET (VmPtr, VMFLAGS_STEP));
+    if (UseDecodeCache) {
+      mEbcDecodeCacheBusy = TRUE;
+    }
+
     //
     // The EBC VM is a strongly ordered processor, so perform a fence operation before
     // and after each instruction is executed.
     //
     MemoryFence ();
 
-    mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+    Decoded = FALSE;
+    if (UseDecodeCache) {
+      Decoded = EbcExecuteDecoded (VmPtr);
+      if (!Decoded) {
+        //
+        // Release the cache before the interpreter, which can call out of the VM.
+        //
+        mEbcDecodeCacheBusy = FALSE;
+      }
+    }
+
+    if (!Decoded) {
+      mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+    }
 
     MemoryFence ();
 
+    if (Decoded) {
+      mEbcDecodeCacheBusy = FALSE;
+    }
+
     //
     // If the step flag is set, signal an exception and continue. We don't
     // clear it here. Assuming the debugger is responsible for clearing it.
@@ -16,6 +16,11 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "HiiDatabase.h"
 extern HII_DATABASE_PRIVATE_DATA mPrivate;
 
+//
+// Lower case hex digits used to encode <Number> values in configuration strings.
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST CHAR16 mHexDigit[] = L"0123456789abcdef";
+
 /**
   Calculate the number of Unicode characters of the incoming Configuration string,
   not including NULL terminator.
@@ -423,6 +428,117 @@ AppendToMultiString (
 }
 
 
+/**
+  Make sure a string which is built in place has room for Count more
+  characters and the null terminator. The buffer grows geometrically, so
+  building a long string only costs linear time.
+
+  This is a internal function.
+
+  @param  String                 The string being built. It may be reallocated.
+  @param  MaxLength              On input, the number of characters String can
+                                 hold, including the null terminator. On output,
+                                 the updated number.
+  @param  Length                 The number of characters already in String, not
+                                 including the null terminator.
+  @param  Count                  The number of characters to be appended.
+
+  @retval EFI_OUT_OF_RESOURCES   String can not be enlarged. It is left unchanged.
+  @retval EFI_SUCCESS            String has enough room.
+
+**/
+EFI_STATUS
+ReserveConfigString (
+  IN OUT EFI_STRING                *String,
+  IN OUT UINTN                     *MaxLength,
+  IN     UINTN                     Length,
+  IN     UINTN                     Count
+  )
+{
+  UINTN       NewMaxLength;
+  EFI_STRING  NewString;
+
+  if (Length + Count + 1 <= *MaxLength) {
+    return EFI_SUCCESS;
+  }
+
+  NewMaxLength = *MaxLength * 2;
+  if (NewMaxLength < Length + Count + 1) {
+    NewMaxLength = Length + Count + 1;
+  }
+  NewString = (EFI_STRING) ReallocatePool (
+                             *MaxLength * sizeof (CHAR16),
+                             NewMaxLength * sizeof (CHAR16),
+                             *String
+                             );
+  if (NewString == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *String    = NewString;
+  *MaxLength = NewMaxLength;
+  return EFI_SUCCESS;
+}
+
+/**
+  Convert a hex digit character to its value.
+
+  This is a internal function.
+
+  @param  Char                   The character to convert.
+
+  @return The value of the hex digit, or 0 if Char is not a hex digit.
+
+**/
+UINT8
+HexCharToNibble (
+  IN CHAR16                        Char
+  )
+{
+  if (Char >= L'0' && Char <= L'9') {
+    return (UINT8) (Char - L'0');
+  }
+  if (Char >= L'a' && Char <= L'f') {
+    return (UINT8) (Char - L'a' + 10);
+  }
+  if (Char >= L'A' && Char <= L'F') {
+    return (UINT8) (Char - L'A' + 10);
+  }
+  return 0;
+}
+
+/**
+  Check whether a string starts with a keyword such as L"&OFFSET=".
+
+  Unlike StrnCmp(), only the first characters of String are read. StrnCmp()
+  asserts StrSize() of both strings, so in DEBUG builds comparing at every
+  element of a long <ConfigResp> would rescan the rest of it each time.
+
+  This is a internal function.
+
+  @param  String                 Pointer to a Null-terminated Unicode string.
+  @param  Keyword                Pointer to the Null-terminated keyword.
+
+  @retval TRUE                   String starts with Keyword.
+  @retval FALSE                  String doesn't start with Keyword.
+
+**/
+BOOLEAN
+IsConfigKeyword (
+  IN CONST CHAR16                  *String,
+  IN CONST CHAR16                  *Keyword
+  )
+{
+  while (*Keyword != 0) {
+    if (*String != *Keyword) {
+      return FALSE;
+    }
+    String++;
+    Keyword++;
+  }
+  return TRUE;
+}
+
 /**
   Get the value of <Number> in <BlockConfig> format, i.e. the value of OFFSET
   or WIDTH or VALUE.
@@ -451,19 +567,14 @@ GetValueOfNumber (
 {
   EFI_STRING               TmpPtr;
   UINTN                    Length;
-  EFI_STRING               Str;
   UINT8                    *Buf;
-  EFI_STATUS               Status;
   UINT8                    DigitUint8;
   UINTN                    Index;
-  CHAR16                   TemStr[2];
 
   if (StringPtr == NULL || *StringPtr == L'\0' || Number == NULL || Len == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Buf = NULL;
-
   TmpPtr = StringPtr;
   while (*StringPtr != L'\0' && *StringPtr != L'&') {
     StringPtr++;
@@ -471,26 +582,20 @@ GetValueOfNumber (
   *Len   = StringPtr - TmpPtr;
   Length = *Len + 1;
 
-  Str = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-  if (Str == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
-  }
-  CopyMem (Str, TmpPtr, *Len * sizeof (CHAR16));
-  *(Str + *Len) = L'\0';
-
   Length = (Length + 1) / 2;
   Buf = (UINT8 *) AllocateZeroPool (Length);
   if (Buf == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
+    return EFI_OUT_OF_RESOURCES;
   }
-  
+
+  //
+  // <Number> is a little endian value written from its most significant digit,
+  // so decode the digits from the end of the string. A character which is not a
+  // hex digit is taken as 0.
+  //
   Length = *Len;
-  ZeroMem (TemStr, sizeof (TemStr));
   for (Index = 0; Index < Length; Index ++) {
-    TemStr[0] = Str[Length - Index - 1];
-    DigitUint8 = (UINT8) StrHexToUint64 (TemStr);
+    DigitUint8 = HexCharToNibble (TmpPtr[Length - Index - 1]);
     if ((Index & 1) == 0) {
       Buf [Index/2] = DigitUint8;
     } else {
@@ -499,14 +604,8 @@ GetValueOfNumber (
   }
 
   *Number = Buf;
-  Status  = EFI_SUCCESS;
-
-Exit:
-  if (Str != NULL) {
-    FreePool (Str);
-  }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -1512,6 +1611,237 @@ BlockArrayCheck (
   return FALSE;
 }
 
+/**
+  Free a cached request entry which is not linked in any list.
+
+  @param  CacheEntry             The cached request entry.
+
+**/
+VOID
+FreeConfigRequestCache (
+  IN HII_CONFIG_REQUEST_CACHE   *CacheEntry
+  )
+{
+  if (CacheEntry->Request != NULL) {
+    FreePool (CacheEntry->Request);
+  }
+  if (CacheEntry->DevicePath != NULL) {
+    FreePool (CacheEntry->DevicePath);
+  }
+  if (CacheEntry->ConfigRequest != NULL) {
+    FreePool (CacheEntry->ConfigRequest);
+  }
+  if (CacheEntry->AltCfgResp != NULL) {
+    FreePool (CacheEntry->AltCfgResp);
+  }
+  FreePool (CacheEntry);
+}
+
+/**
+  Check whether the default value string of the varstore holds the default
+  of a string question. Such a default is read from the string packages in
+  the current language, so the string can't be cached.
+
+  @param  VarStorageData         The varstore data parsed from the IFR.
+
+  @retval TRUE                   A string question of the varstore has a default.
+  @retval FALSE                  No string question of the varstore has a default.
+
+**/
+BOOLEAN
+HasStringDefault (
+  IN IFR_VARSTORAGE_DATA                 *VarStorageData
+  )
+{
+  LIST_ENTRY                   *Link;
+  IFR_BLOCK_DATA               *BlockData;
+
+  for (Link = VarStorageData->BlockEntry.ForwardLink; Link != &VarStorageData->BlockEntry; Link = Link->ForwardLink) {
+    BlockData = BASE_CR (Link, IFR_BLOCK_DATA, Entry);
+    if (BlockData->OpCode == EFI_IFR_STRING_OP && !IsListEmpty (&BlockData->DefaultValueEntry)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Find the strings which were built from the IFR of a package list for a
+  request without request elements.
+
+  @param  PackageList            The package list instance.
+  @param  Request                The <ConfigHdr> of the request, or NULL.
+  @param  DevicePath             The device path of the driver which owns the
+                                 package list.
+
+  @return The cached entry, or NULL if the request has not been cached.
+
+**/
+HII_CONFIG_REQUEST_CACHE *
+FindConfigRequestCache (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList,
+  IN EFI_STRING                          Request,
+  IN EFI_DEVICE_PATH_PROTOCOL            *DevicePath
+  )
+{
+  LIST_ENTRY                   *Link;
+  HII_CONFIG_REQUEST_CACHE     *CacheEntry;
+  UINTN                        DevicePathSize;
+
+  DevicePathSize = GetDevicePathSize (DevicePath);
+  for (Link = PackageList->ConfigRequestCache.ForwardLink; Link != &PackageList->ConfigRequestCache; Link = Link->ForwardLink) {
+    CacheEntry = CR (Link, HII_CONFIG_REQUEST_CACHE, Entry, HII_CONFIG_REQUEST_CACHE_SIGNATURE);
+    if ((Request == NULL) != (CacheEntry->Request == NULL)) {
+      continue;
+    }
+    if (Request != NULL && StrCmp (Request, CacheEntry->Request) != 0) {
+      continue;
+    }
+    if (GetDevicePathSize (CacheEntry->DevicePath) == DevicePathSize &&
+        CompareMem (CacheEntry->DevicePath, DevicePath, DevicePathSize) == 0) {
+      return CacheEntry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Create a request cache entry for a request without request elements. The
+  entry is linked into the package list once its strings are known.
+
+  @param  Request                The <ConfigHdr> of the request, or NULL.
+  @param  DevicePath             The device path of the driver which owns the
+                                 package list.
+
+  @return The new entry, or NULL if it can not be allocated.
+
+**/
+HII_CONFIG_REQUEST_CACHE *
+CreateConfigRequestCache (
+  IN EFI_STRING                          Request,
+  IN EFI_DEVICE_PATH_PROTOCOL            *DevicePath
+  )
+{
+  HII_CONFIG_REQUEST_CACHE     *CacheEntry;
+
+  CacheEntry = AllocateZeroPool (sizeof (HII_CONFIG_REQUEST_CACHE));
+  if (CacheEntry == NULL) {
+    return NULL;
+  }
+  CacheEntry->Signature  = HII_CONFIG_REQUEST_CACHE_SIGNATURE;
+  CacheEntry->DevicePath = DuplicateDevicePath (DevicePath);
+  if (Request != NULL) {
+    CacheEntry->Request = AllocateCopyPool (StrSize (Request), Request);
+  }
+  if (CacheEntry->DevicePath == NULL || (Request != NULL && CacheEntry->Request == NULL)) {
+    FreeConfigRequestCache (CacheEntry);
+    return NULL;
+  }
+
+  return CacheEntry;
+}
+
+/**
+  Record the strings built for a request cache entry and link the entry into
+  the package list. The entry is freed if the strings can not be copied.
+
+  @param  PackageList            The package list instance.
+  @param  CacheEntry             The entry created by CreateConfigRequestCache().
+  @param  ConfigRequest          The full request string, or NULL if the IFR has
+                                 no question for the request.
+  @param  AltCfgResp             The default value string, or NULL.
+
+**/
+VOID
+InsertConfigRequestCache (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList,
+  IN HII_CONFIG_REQUEST_CACHE            *CacheEntry,
+  IN EFI_STRING                          ConfigRequest, OPTIONAL
+  IN EFI_STRING                          AltCfgResp     OPTIONAL
+  )
+{
+  if (ConfigRequest != NULL) {
+    CacheEntry->ConfigRequest = AllocateCopyPool (StrSize (ConfigRequest), ConfigRequest);
+    if (CacheEntry->ConfigRequest == NULL) {
+      FreeConfigRequestCache (CacheEntry);
+      return;
+    }
+  }
+  if (AltCfgResp != NULL) {
+    CacheEntry->AltCfgResp = AllocateCopyPool (StrSize (AltCfgResp), AltCfgResp);
+    if (CacheEntry->AltCfgResp == NULL) {
+      FreeConfigRequestCache (CacheEntry);
+      return;
+    }
+  }
+
+  InsertTailList (&PackageList->ConfigRequestCache, &CacheEntry->Entry);
+}
+
+/**
+  Return the strings of a cached request the same way GetFullStringFromHiiFormPackages()
+  returns the strings it builds from the IFR data.
+
+  @param  CacheEntry             The cached request entry.
+  @param  Request                The request string to be replaced by the full
+                                 request string.
+  @param  AltCfgResp             The default value string to be set or merged.
+
+  @retval EFI_SUCCESS            The strings are returned.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory for the return strings.
+
+**/
+EFI_STATUS
+ApplyConfigRequestCache (
+  IN     HII_CONFIG_REQUEST_CACHE   *CacheEntry,
+  IN OUT EFI_STRING                 *Request,
+  IN OUT EFI_STRING                 *AltCfgResp
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_STRING                   FullRequest;
+  EFI_STRING                   DefaultAltCfgResp;
+
+  //
+  // No question of the requested varstore is found in IFR data.
+  //
+  if (CacheEntry->ConfigRequest == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  FullRequest       = AllocateCopyPool (StrSize (CacheEntry->ConfigRequest), CacheEntry->ConfigRequest);
+  DefaultAltCfgResp = NULL;
+  if (CacheEntry->AltCfgResp != NULL) {
+    DefaultAltCfgResp = AllocateCopyPool (StrSize (CacheEntry->AltCfgResp), CacheEntry->AltCfgResp);
+  }
+  if (FullRequest == NULL || (CacheEntry->AltCfgResp != NULL && DefaultAltCfgResp == NULL)) {
+    if (FullRequest != NULL) {
+      FreePool (FullRequest);
+    }
+    if (DefaultAltCfgResp != NULL) {
+      FreePool (DefaultAltCfgResp);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (*Request != NULL) {
+    FreePool (*Request);
+  }
+  *Request = FullRequest;
+
+  Status = EFI_SUCCESS;
+  if (*AltCfgResp != NULL && DefaultAltCfgResp != NULL) {
+    Status = MergeDefaultString (AltCfgResp, DefaultAltCfgResp);
+    FreePool (DefaultAltCfgResp);
+  } else if (*AltCfgResp == NULL) {
+    *AltCfgResp = DefaultAltCfgResp;
+  }
+
+  return Status;
+}
+
 /**
   Get form package data from data base.
 
@@ -1535,6 +1865,22 @@ GetFormPackageData (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The form packages only change through the package notify path, which
+  // drops the cached copy.
+  //
+  if (DataBaseRecord->PackageList->FormPkgCache != NULL) {
+    *HiiFormPackage = AllocateCopyPool (
+                        DataBaseRecord->PackageList->FormPkgCacheSize,
+                        DataBaseRecord->PackageList->FormPkgCache
+                        );
+    if (*HiiFormPackage == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    *PackageSize = DataBaseRecord->PackageList->FormPkgCacheSize;
+    return EFI_SUCCESS;
+  }
+
   Size       = 0;
   ResultSize = 0;
   //
@@ -1575,6 +1921,11 @@ GetFormPackageData (
            );
   if (EFI_ERROR (Status)) {
     FreePool (*HiiFormPackage);
+  } else {
+    DataBaseRecord->PackageList->FormPkgCache = AllocateCopyPool (Size, *HiiFormPackage);
+    if (DataBaseRecord->PackageList->FormPkgCache != NULL) {
+      DataBaseRecord->PackageList->FormPkgCacheSize = Size;
+    }
   }
   
   *PackageSize = Size;
@@ -1582,6 +1933,33 @@ GetFormPackageData (
   return Status;
 }
 
+/**
+  Free the form package image and the request strings which ConfigRouting
+  has cached for a package list.
+
+  @param  PackageList             The package list instance.
+
+**/
+VOID
+HiiFlushIfrCache (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList
+  )
+{
+  HII_CONFIG_REQUEST_CACHE     *CacheEntry;
+
+  if (PackageList->FormPkgCache != NULL) {
+    FreePool (PackageList->FormPkgCache);
+    PackageList->FormPkgCache     = NULL;
+    PackageList->FormPkgCacheSize = 0;
+  }
+
+  while (!IsListEmpty (&PackageList->ConfigRequestCache)) {
+    CacheEntry = CR (PackageList->ConfigRequestCache.ForwardLink, HII_CONFIG_REQUEST_CACHE, Entry, HII_CONFIG_REQUEST_CACHE_SIGNATURE);
+    RemoveEntryList (&CacheEntry->Entry);
+    FreeConfigRequestCache (CacheEntry);
+  }
+}
+
 
 /**
   This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
@@ -3784,6 +4162,7 @@ GetFullStringFromHiiFormPackages (
   EFI_STRING                   ConfigHdr;
   EFI_STRING                   StringPtr;
   EFI_STRING                   Progress;
+  HII_CONFIG_REQUEST_CACHE     *CacheEntry;
 
   if (DataBaseRecord == NULL || DevicePath == NULL || Request == NULL || AltCfgResp == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -3800,11 +4179,7 @@ GetFullStringFromHiiFormPackages (
   HiiFormPackage    = NULL;
   PackageSize       = 0;
   Progress          = *Request;
-
-  Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
+  CacheEntry        = NULL;
 
   //
   // 1. Get the request block array by Request String when Request string contains the block array.
@@ -3862,6 +4237,23 @@ GetFullStringFromHiiFormPackages (
       Status = EFI_INVALID_PARAMETER;
       goto Done;
     }
+  } else {
+    //
+    // A request without request elements only depends on the IFR data, so
+    // the strings built for it last time can be returned directly.
+    //
+    CacheEntry = FindConfigRequestCache (DataBaseRecord->PackageList, *Request, DevicePath);
+    if (CacheEntry != NULL) {
+      Status     = ApplyConfigRequestCache (CacheEntry, Request, AltCfgResp);
+      CacheEntry = NULL;
+      goto Done;
+    }
+    CacheEntry = CreateConfigRequestCache (*Request, DevicePath);
+  }
+
+  Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
+  if (EFI_ERROR (Status)) {
+    goto Done;
   }
 
   //
@@ -3907,10 +4299,25 @@ GetFullStringFromHiiFormPackages (
   // No requested varstore in IFR data and directly return
   //
   if (VarStorageData->Type == 0 && VarStorageData->Name == NULL) {
+    if (CacheEntry != NULL) {
+      InsertConfigRequestCache (DataBaseRecord->PackageList, CacheEntry, NULL, NULL);
+      CacheEntry = NULL;
+    }
     Status = EFI_SUCCESS;
     goto Done;
   }
 
+  //
+  // Names of name/value varstores and defaults of string questions come
+  // from the string packages, whose strings depend on the current language
+  // and can be changed by HiiSetString(). Don't cache them.
+  //
+  if (CacheEntry != NULL &&
+      (VarStorageData->Type == EFI_HII_VARSTORE_NAME_VALUE || HasStringDefault (VarStorageData))) {
+    FreeConfigRequestCache (CacheEntry);
+    CacheEntry = NULL;
+  }
+
   //
   // 3. Construct Request Element (Block Name) for 2.1 and 2.2 case.
   //
@@ -3921,6 +4328,10 @@ GetFullStringFromHiiFormPackages (
 
   if (RequestBlockArray == NULL) {
     if (!GenerateConfigRequest(ConfigHdr, VarStorageData, &Status, Request)) {
+      if (CacheEntry != NULL && !EFI_ERROR (Status)) {
+        InsertConfigRequestCache (DataBaseRecord->PackageList, CacheEntry, NULL, NULL);
+        CacheEntry = NULL;
+      }
       goto Done;
     }
   }
@@ -3935,6 +4346,11 @@ GetFullStringFromHiiFormPackages (
     goto Done;
   }
 
+  if (CacheEntry != NULL) {
+    InsertConfigRequestCache (DataBaseRecord->PackageList, CacheEntry, *Request, DefaultAltCfgResp);
+    CacheEntry = NULL;
+  }
+
   //
   // 5. Merge string into the input AltCfgResp if the input *AltCfgResp is not NULL.
   //
@@ -4015,6 +4431,10 @@ Done:
     FreePool (HiiFormPackage);
   }
 
+  if (CacheEntry != NULL) {
+    FreeConfigRequestCache (CacheEntry);
+  }
+
   if (PointerProgress != NULL) {
     if (*Request == NULL) {
       *PointerProgress = NULL;
@@ -5224,13 +5644,12 @@ HiiBlockToConfig (
   UINT8                               *TmpBuffer;
   UINTN                               Offset;
   UINTN                               Width;
-  UINT8                               *Value;
-  EFI_STRING                          ValueStr;
-  EFI_STRING                          ConfigElement;
   UINTN                               Index;
-  UINT8                               *TemBuffer;
+  CONST UINT8                         *TemBuffer;
   CHAR16                              *TemString;
-  CHAR16                              TemChar;
+  UINTN                               ConfigLength;
+  UINTN                               ConfigMaxLength;
+  UINTN                               ElementLength;
 
   TmpBuffer = NULL;
 
@@ -5248,15 +5667,15 @@ HiiBlockToConfig (
   ASSERT (Private != NULL);
 
   StringPtr     = ConfigRequest;
-  ValueStr      = NULL;
-  Value         = NULL;
-  ConfigElement = NULL;
 
   //
-  // Allocate a fix length of memory to store Results. Reallocate memory for
-  // Results if this fix length is insufficient.
+  // <ConfigResp> is built in place. Its buffer starts with the size of the
+  // request plus a fix length, and ReserveConfigString() enlarges it when
+  // the values don't fit.
   //
-  *Config = (EFI_STRING) AllocateZeroPool (MAX_STRING_LENGTH);
+  ConfigLength    = 0;
+  ConfigMaxLength = StrLen (ConfigRequest) + MAX_STRING_LENGTH / sizeof (CHAR16);
+  *Config = (EFI_STRING) AllocateZeroPool (ConfigMaxLength * sizeof (CHAR16));
   if (*Config == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -5269,7 +5688,7 @@ HiiBlockToConfig (
     Status = EFI_INVALID_PARAMETER;
     goto Exit;
   }
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"PATH=", StrLen (L"PATH=")) != 0) {
+  while (*StringPtr != 0 && !IsConfigKeyword (StringPtr, L"PATH=")) {
     StringPtr++;
   }
   if (*StringPtr == 0) {
@@ -5284,7 +5703,7 @@ HiiBlockToConfig (
   if (*StringPtr == 0) {
     *Progress = StringPtr;
 
-    AppendToMultiString(Config, ConfigRequest);
+    StrCpyS (*Config, ConfigMaxLength, ConfigRequest);
     HiiToLower (*Config);
 
     return EFI_SUCCESS;
@@ -5297,17 +5716,15 @@ HiiBlockToConfig (
   //
   // Copy <ConfigHdr> and an additional '&' to <ConfigResp>
   //
-  TemChar = *StringPtr;
-  *StringPtr = '\0';
-  AppendToMultiString(Config, ConfigRequest);
-  *StringPtr = TemChar;
+  ConfigLength = StringPtr - ConfigRequest;
+  CopyMem (*Config, ConfigRequest, ConfigLength * sizeof (CHAR16));
 
   //
   // Parse each <RequestElement> if exists
   // Only <BlockName> format is supported by this help function.
   // <BlockName> ::= 'OFFSET='<Number>&'WIDTH='<Number>
   //
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"OFFSET=", StrLen (L"OFFSET=")) == 0) {
+  while (IsConfigKeyword (StringPtr, L"OFFSET=")) {
     //
     // Back up the header of one <BlockName>
     //
@@ -5331,7 +5748,7 @@ HiiBlockToConfig (
     FreePool (TmpBuffer);
 
     StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
+    if (!IsConfigKeyword (StringPtr, L"&WIDTH=")) {
       *Progress = TmpPtr - 1;
       Status = EFI_INVALID_PARAMETER;
       goto Exit;
@@ -5370,63 +5787,45 @@ HiiBlockToConfig (
       goto Exit;
     }
 
-    Value = (UINT8 *) AllocateZeroPool (Width);
-    if (Value == NULL) {
+    //
+    // Append the <BlockName>, then '&VALUE=' and the value, most significant
+    // byte first. The trailing '&' is only added when another element follows.
+    //
+    ElementLength = StringPtr - TmpPtr;
+    Status = ReserveConfigString (
+               Config,
+               &ConfigMaxLength,
+               ConfigLength,
+               ElementLength + StrLen (L"&VALUE=") + Width * 2 + 1
+               );
+    if (EFI_ERROR (Status)) {
       *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
       goto Exit;
     }
 
-    CopyMem (Value, (UINT8 *) Block + Offset, Width);
+    TemString = *Config + ConfigLength;
+    CopyMem (TemString, TmpPtr, ElementLength * sizeof (CHAR16));
+    TemString += ElementLength;
+    CopyMem (TemString, L"&VALUE=", StrLen (L"&VALUE=") * sizeof (CHAR16));
+    TemString += StrLen (L"&VALUE=");
 
-    Length = Width * 2 + 1;
-    ValueStr = (EFI_STRING) AllocateZeroPool (Length  * sizeof (CHAR16));
-    if (ValueStr == NULL) {
-      *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-    
-    TemString = ValueStr;
-    TemBuffer = Value + Width - 1;
+    TemBuffer = Block + Offset + Width - 1;
     for (Index = 0; Index < Width; Index ++, TemBuffer --) {
-      TemString += UnicodeValueToString (TemString, PREFIX_ZERO | RADIX_HEX, *TemBuffer, 2);
-    }
-
-    FreePool (Value);
-    Value = NULL;
-
-    //
-    // Build a ConfigElement
-    //
-    Length += StringPtr - TmpPtr + 1 + StrLen (L"VALUE=");
-    ConfigElement = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-    if (ConfigElement == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-    CopyMem (ConfigElement, TmpPtr, (StringPtr - TmpPtr + 1) * sizeof (CHAR16));
-    if (*StringPtr == 0) {
-      *(ConfigElement + (StringPtr - TmpPtr)) = L'&';
+      *(TemString++) = mHexDigit[*TemBuffer >> 4];
+      *(TemString++) = mHexDigit[*TemBuffer & 0xF];
     }
-    *(ConfigElement + (StringPtr - TmpPtr) + 1) = 0;
-    StrCatS (ConfigElement, Length, L"VALUE=");
-    StrCatS (ConfigElement, Length, ValueStr);
-
-    AppendToMultiString (Config, ConfigElement);
-
-    FreePool (ConfigElement);
-    FreePool (ValueStr);
-    ConfigElement = NULL;
-    ValueStr = NULL;
 
     //
     // If '\0', parsing is finished. Otherwise skip '&' to continue
     //
     if (*StringPtr == 0) {
+      *TemString   = 0;
+      ConfigLength = TemString - *Config;
       break;
     }
-    AppendToMultiString (Config, L"&");
+    *(TemString++) = L'&';
+    *TemString     = 0;
+    ConfigLength   = TemString - *Config;
     StringPtr++;
 
   }
@@ -5446,15 +5845,6 @@ Exit:
   FreePool (*Config);
   *Config = NULL;
   }
-  if (ValueStr != NULL) {
-    FreePool (ValueStr);
-  }
-  if (Value != NULL) {
-    FreePool (Value);
-  }
-  if (ConfigElement != NULL) {
-    FreePool (ConfigElement);
-  }
 
   return Status;
 
@@ -5557,7 +5947,7 @@ HiiConfigToBlock (
     Status = EFI_INVALID_PARAMETER;
     goto Exit;
   }
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"PATH=", StrLen (L"PATH=")) != 0) {
+  while (*StringPtr != 0 && !IsConfigKeyword (StringPtr, L"PATH=")) {
     StringPtr++;
   }
   if (*StringPtr == 0) {
@@ -5580,7 +5970,7 @@ HiiConfigToBlock (
   // Only '&'<BlockConfig> format is supported by this help function.
   // <BlockConfig> ::= 'OFFSET='<Number>&'WIDTH='<Number>&'VALUE='<Number>
   //
-  while (*StringPtr != 0 && StrnCmp (StringPtr, L"&OFFSET=", StrLen (L"&OFFSET=")) == 0) {
+  while (IsConfigKeyword (StringPtr, L"&OFFSET=")) {
     TmpPtr     = StringPtr;
     StringPtr += StrLen (L"&OFFSET=");
     //
@@ -5600,7 +5990,7 @@ HiiConfigToBlock (
     FreePool (TmpBuffer);
 
     StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&WIDTH=", StrLen (L"&WIDTH=")) != 0) {
+    if (!IsConfigKeyword (StringPtr, L"&WIDTH=")) {
       *Progress = TmpPtr;
       Status = EFI_INVALID_PARAMETER;
       goto Exit;
@@ -5624,7 +6014,7 @@ HiiConfigToBlock (
     FreePool (TmpBuffer);
 
     StringPtr += Length;
-    if (StrnCmp (StringPtr, L"&VALUE=", StrLen (L"&VALUE=")) != 0) {
+    if (!IsConfigKeyword (StringPtr, L"&VALUE=")) {
       *Progress = TmpPtr;
       Status = EFI_INVALID_PARAMETER;
       goto Exit;
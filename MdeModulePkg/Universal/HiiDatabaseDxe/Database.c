@@ -69,8 +69,10 @@ GenerateHiiDatabaseRecord (
   InitializeListHead (&PackageList->StringPkgHdr);
   InitializeListHead (&PackageList->FontPkgHdr);
   InitializeListHead (&PackageList->SimpleFontPkgHdr);
+  InitializeListHead (&PackageList->ConfigRequestCache);
   PackageList->ImagePkg      = NULL;
   PackageList->DevicePathPkg = NULL;
+  PackageList->FormPkgCache  = NULL;
 
   //
   // Create a new hii handle
@@ -164,6 +166,7 @@ InvokeRegisteredFunction (
   )
 {
   HII_DATABASE_NOTIFY             *Notify;
+  HII_DATABASE_RECORD             *DatabaseRecord;
   LIST_ENTRY                      *Link;
   EFI_HII_PACKAGE_HEADER          *Package;
   UINT8                           *Buffer;
@@ -182,6 +185,19 @@ InvokeRegisteredFunction (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // Any change of the package list makes the IFR data cached by ConfigRouting stale.
+  //
+  if (NotifyType != EFI_HII_DATABASE_NOTIFY_EXPORT_PACK) {
+    for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+      DatabaseRecord = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+      if (DatabaseRecord->Handle == Handle) {
+        HiiFlushIfrCache (DatabaseRecord->PackageList);
+        break;
+      }
+    }
+  }
+
   Buffer  = NULL;
   Package = NULL;
 
@@ -964,6 +980,7 @@ AdjustStringPackage (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      HiiFreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
@@ -1105,6 +1122,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    HiiFreeStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -1414,6 +1432,7 @@ RemoveFontPackages (
 
     RemoveEntryList (&Package->FontEntry);
     PackageList->PackageListHdr.PackageLength -= Package->FontPkgHdr->Header.Length;
+    HiiFlushGlyphCache ();
 
     if (Package->GlyphBlock != NULL) {
       FreePool (Package->GlyphBlock);
@@ -1927,6 +1946,7 @@ RemoveSimpleFontPackages (
 
     RemoveEntryList (&Package->SimpleFontEntry);
     PackageList->PackageListHdr.PackageLength -= Package->SimpleFontPkgHdr->Header.Length;
+    HiiFlushGlyphCache ();
     FreePool (Package->SimpleFontPkgHdr);
     FreePool (Package);
   }
@@ -2557,6 +2577,7 @@ AddPackages (
       if (EFI_ERROR (Status)) {
         return Status;
       }
+      HiiFlushGlyphCache ();
       Status = InvokeRegisteredFunction (
                  Private,
                  NotifyType,
@@ -2593,6 +2614,7 @@ AddPackages (
       if (EFI_ERROR (Status)) {
         return Status;
       }
+      HiiFlushGlyphCache ();
       Status = InvokeRegisteredFunction (
                  Private,
                  NotifyType,
@@ -3138,6 +3160,7 @@ HiiRemovePackageList (
 
       HiiHandle->Signature = 0;
       FreePool (HiiHandle);
+      HiiFlushIfrCache (Node->PackageList);
       FreePool (Node->PackageList);
       FreePool (Node);
 
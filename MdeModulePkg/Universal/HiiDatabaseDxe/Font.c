@@ -136,34 +136,71 @@ GetCell (
 }
 
 
+HII_GLYPH_CACHE_ENTRY                mHiiGlyphCache[HII_GLYPH_CACHE_SIZE];
+UINTN                                mHiiGlyphCacheHits   = 0;
+UINTN                                mHiiGlyphCacheMisses = 0;
+
 /**
-  Convert the glyph for a single character into a bitmap.
+  Invalidate all glyphs in the glyph cache.
+  This is called whenever a font package or a simple font package is
+  added to or removed from the HII database.
+
+**/
+VOID
+HiiFlushGlyphCache (
+  VOID
+  )
+{
+  UINTN                              Index;
+
+  if (mHiiGlyphCacheHits + mHiiGlyphCacheMisses != 0) {
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "HiiDatabase: glyph cache flushed, %Lu hits, %Lu misses\n",
+      (UINT64) mHiiGlyphCacheHits,
+      (UINT64) mHiiGlyphCacheMisses
+      ));
+  }
+
+  for (Index = 0; Index < HII_GLYPH_CACHE_SIZE; Index++) {
+    if (mHiiGlyphCache[Index].GlyphBuffer != NULL) {
+      FreePool (mHiiGlyphCache[Index].GlyphBuffer);
+    }
+  }
+  ZeroMem (mHiiGlyphCache, sizeof (mHiiGlyphCache));
+  mHiiGlyphCacheHits   = 0;
+  mHiiGlyphCacheMisses = 0;
+}
+
+/**
+  Find the glyph for a single character in the font package specified by
+  FontPackage, or in the simplified font packages if FontPackage is NULL.
 
   This is a internal function.
 
-  @param  Private                 HII database driver private data.
+  @param  Private                 HII database private data.
   @param  Char                    Character to retrieve.
-  @param  StringInfo              Points to the string font and color information
-                                  or NULL  if the string should use the default
-                                  system font and color.
+  @param  FontPackage             The font package to search, or NULL to search
+                                  the simplified font packages.
   @param  GlyphBuffer             Buffer to store the retrieved bitmap data.
   @param  Cell                    Points to EFI_HII_GLYPH_INFO structure.
-  @param  Attributes              If not NULL, output the glyph attributes if any.
+  @param  Attributes              Output the glyph attributes.
+  @param  GlyphBufferLen          Output the length of GlyphBuffer.
 
   @retval EFI_SUCCESS             Glyph bitmap outputted.
   @retval EFI_OUT_OF_RESOURCES    Unable to allocate the output buffer GlyphBuffer.
   @retval EFI_NOT_FOUND           The glyph was unknown can not be found.
-  @retval EFI_INVALID_PARAMETER   Any input parameter is invalid.
 
 **/
 EFI_STATUS
-GetGlyphBuffer (
+LookupGlyph (
   IN  HII_DATABASE_PRIVATE_DATA      *Private,
   IN  CHAR16                         Char,
-  IN  EFI_FONT_INFO                  *StringInfo,
+  IN  HII_FONT_PACKAGE_INSTANCE      *FontPackage,
   OUT UINT8                          **GlyphBuffer,
   OUT EFI_HII_GLYPH_INFO             *Cell,
-  OUT UINT8                          *Attributes OPTIONAL
+  OUT UINT8                          *Attributes,
+  OUT UINTN                          *GlyphBufferLen
   )
 {
   HII_DATABASE_RECORD                *Node;
@@ -173,11 +210,115 @@ GetGlyphBuffer (
   UINT16                             Index;
   EFI_NARROW_GLYPH                   Narrow;
   EFI_WIDE_GLYPH                     Wide;
-  HII_GLOBAL_FONT_INFO               *GlobalFont;
   UINTN                              HeaderSize;
   EFI_NARROW_GLYPH                   *NarrowPtr;
   EFI_WIDE_GLYPH                     *WidePtr;
 
+  *GlyphBufferLen = 0;
+
+  if (FontPackage != NULL) {
+    *Attributes = PROPORTIONAL_GLYPH;
+    return FindGlyphBlock (FontPackage, Char, GlyphBuffer, Cell, GlyphBufferLen);
+  }
+
+  HeaderSize = sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR);
+
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    for (Link1 = Node->PackageList->SimpleFontPkgHdr.ForwardLink;
+         Link1 != &Node->PackageList->SimpleFontPkgHdr;
+         Link1 = Link1->ForwardLink
+        ) {
+      SimpleFont = CR (Link1, HII_SIMPLE_FONT_PACKAGE_INSTANCE, SimpleFontEntry, HII_S_FONT_PACKAGE_SIGNATURE);
+      //
+      // Search the narrow glyph array
+      //
+      NarrowPtr = (EFI_NARROW_GLYPH *) ((UINT8 *) (SimpleFont->SimpleFontPkgHdr) + HeaderSize);
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs; Index++) {
+        CopyMem (&Narrow, NarrowPtr + Index,sizeof (EFI_NARROW_GLYPH));
+        if (Narrow.UnicodeWeight == Char) {
+          *GlyphBuffer = (UINT8 *) AllocateZeroPool (EFI_GLYPH_HEIGHT);
+          if (*GlyphBuffer == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+          }
+          *GlyphBufferLen = EFI_GLYPH_HEIGHT;
+          Cell->Width     = EFI_GLYPH_WIDTH;
+          Cell->Height    = EFI_GLYPH_HEIGHT;
+          Cell->AdvanceX  = Cell->Width;
+          CopyMem (*GlyphBuffer, Narrow.GlyphCol1, Cell->Height);
+          *Attributes = (UINT8) (Narrow.Attributes | NARROW_GLYPH);
+          return EFI_SUCCESS;
+        }
+      }
+      //
+      // Search the wide glyph array
+      //
+      WidePtr = (EFI_WIDE_GLYPH *) (NarrowPtr + SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs);
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfWideGlyphs; Index++) {
+        CopyMem (&Wide, WidePtr + Index, sizeof (EFI_WIDE_GLYPH));
+        if (Wide.UnicodeWeight == Char) {
+          *GlyphBuffer    = (UINT8 *) AllocateZeroPool (EFI_GLYPH_HEIGHT * 2);
+          if (*GlyphBuffer == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+          }
+          *GlyphBufferLen = EFI_GLYPH_HEIGHT * 2;
+          Cell->Width     = EFI_GLYPH_WIDTH * 2;
+          Cell->Height    = EFI_GLYPH_HEIGHT;
+          Cell->AdvanceX  = Cell->Width;
+          CopyMem (*GlyphBuffer, Wide.GlyphCol1, EFI_GLYPH_HEIGHT);
+          CopyMem (*GlyphBuffer + EFI_GLYPH_HEIGHT, Wide.GlyphCol2, EFI_GLYPH_HEIGHT);
+          *Attributes = (UINT8) (Wide.Attributes | EFI_GLYPH_WIDE);
+          return EFI_SUCCESS;
+        }
+      }
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Convert the glyph for a single character into a bitmap.
+
+  The glyph is first looked up in the glyph cache. On a cache miss, it is
+  retrieved from the font packages and the result, including a failure to
+  find the glyph, is saved in the glyph cache.
+
+  This is a internal function.
+
+  @param  Private                 HII database private data.
+  @param  Char                    Character to retrieve.
+  @param  StringInfo              Points to the string font and color information
+                                  or NULL  if the string should use the default
+                                  system font and color.
+  @param  GlyphBuffer             Buffer to store the retrieved bitmap data.
+  @param  Cell                    Points to EFI_HII_GLYPH_INFO structure.
+  @param  Attributes              If not NULL, output the glyph attributes if any.
+
+  @retval EFI_SUCCESS             Glyph bitmap outputted.
+  @retval EFI_OUT_OF_RESOURCES    Unable to allocate the output buffer GlyphBuffer.
+  @retval EFI_NOT_FOUND           The glyph was unknown can not be found.
+  @retval EFI_INVALID_PARAMETER   Any input parameter is invalid.
+
+**/
+EFI_STATUS
+GetGlyphBuffer (
+  IN  HII_DATABASE_PRIVATE_DATA      *Private,
+  IN  CHAR16                         Char,
+  IN  EFI_FONT_INFO                  *StringInfo,
+  OUT UINT8                          **GlyphBuffer,
+  OUT EFI_HII_GLYPH_INFO             *Cell,
+  OUT UINT8                          *Attributes OPTIONAL
+  )
+{
+  EFI_STATUS                         Status;
+  HII_GLOBAL_FONT_INFO               *GlobalFont;
+  HII_FONT_PACKAGE_INSTANCE          *FontPackage;
+  HII_GLYPH_CACHE_ENTRY              *Entry;
+  UINT8                              *Buffer;
+  UINTN                              BufferLen;
+  UINT8                              GlyphAttributes;
+
   if (GlyphBuffer == NULL || Cell == NULL) {
     return EFI_INVALID_PARAMETER;
   }
@@ -193,72 +334,59 @@ GetGlyphBuffer (
   // If NULL, try to find the character in simplified font packages since
   // default system font is the fixed font (narrow or wide glyph).
   //
+  FontPackage = NULL;
   if (StringInfo != NULL) {
     if(!IsFontInfoExisted (Private, StringInfo, NULL, NULL, &GlobalFont)) {
       return EFI_INVALID_PARAMETER;
     }
-    if (Attributes != NULL) {
-      *Attributes = PROPORTIONAL_GLYPH;
+    FontPackage = GlobalFont->FontPackage;
+  }
+
+  Entry = &mHiiGlyphCache[(Char ^ ((UINTN) FontPackage >> 4)) % HII_GLYPH_CACHE_SIZE];
+  if (!Entry->Valid || Entry->FontPackage != FontPackage || Entry->CharValue != Char) {
+    //
+    // Cache miss, look up the glyph in the font packages and save it in the cache.
+    //
+    mHiiGlyphCacheMisses++;
+    Buffer          = NULL;
+    GlyphAttributes = 0;
+    Status = LookupGlyph (Private, Char, FontPackage, &Buffer, Cell, &GlyphAttributes, &BufferLen);
+    if (Status != EFI_SUCCESS && Status != EFI_NOT_FOUND) {
+      return Status;
+    }
+
+    if (Entry->GlyphBuffer != NULL) {
+      FreePool (Entry->GlyphBuffer);
     }
-    return FindGlyphBlock (GlobalFont->FontPackage, Char, GlyphBuffer, Cell, NULL);
+    Entry->Valid          = TRUE;
+    Entry->FontPackage    = FontPackage;
+    Entry->CharValue      = Char;
+    Entry->Status         = Status;
+    Entry->Attributes     = GlyphAttributes;
+    Entry->GlyphBufferLen = BufferLen;
+    Entry->GlyphBuffer    = Buffer;
+    CopyMem (&Entry->Cell, Cell, sizeof (EFI_HII_GLYPH_INFO));
   } else {
-    HeaderSize = sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR);
-
-    for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
-      Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
-      for (Link1 = Node->PackageList->SimpleFontPkgHdr.ForwardLink;
-           Link1 != &Node->PackageList->SimpleFontPkgHdr;
-           Link1 = Link1->ForwardLink
-          ) {
-        SimpleFont = CR (Link1, HII_SIMPLE_FONT_PACKAGE_INSTANCE, SimpleFontEntry, HII_S_FONT_PACKAGE_SIGNATURE);
-        //
-        // Search the narrow glyph array
-        //
-        NarrowPtr = (EFI_NARROW_GLYPH *) ((UINT8 *) (SimpleFont->SimpleFontPkgHdr) + HeaderSize);
-        for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs; Index++) {
-          CopyMem (&Narrow, NarrowPtr + Index,sizeof (EFI_NARROW_GLYPH));
-          if (Narrow.UnicodeWeight == Char) {
-            *GlyphBuffer = (UINT8 *) AllocateZeroPool (EFI_GLYPH_HEIGHT);
-            if (*GlyphBuffer == NULL) {
-              return EFI_OUT_OF_RESOURCES;
-            }
-            Cell->Width    = EFI_GLYPH_WIDTH;
-            Cell->Height   = EFI_GLYPH_HEIGHT;
-            Cell->AdvanceX = Cell->Width;
-            CopyMem (*GlyphBuffer, Narrow.GlyphCol1, Cell->Height);
-            if (Attributes != NULL) {
-              *Attributes = (UINT8) (Narrow.Attributes | NARROW_GLYPH);
-            }
-            return EFI_SUCCESS;
-          }
-        }
-        //
-        // Search the wide glyph array
-        //
-        WidePtr = (EFI_WIDE_GLYPH *) (NarrowPtr + SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs);
-        for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfWideGlyphs; Index++) {
-          CopyMem (&Wide, WidePtr + Index, sizeof (EFI_WIDE_GLYPH));
-          if (Wide.UnicodeWeight == Char) {
-            *GlyphBuffer    = (UINT8 *) AllocateZeroPool (EFI_GLYPH_HEIGHT * 2);
-            if (*GlyphBuffer == NULL) {
-              return EFI_OUT_OF_RESOURCES;
-            }
-            Cell->Width    = EFI_GLYPH_WIDTH * 2;
-            Cell->Height   = EFI_GLYPH_HEIGHT;
-            Cell->AdvanceX = Cell->Width;
-            CopyMem (*GlyphBuffer, Wide.GlyphCol1, EFI_GLYPH_HEIGHT);
-            CopyMem (*GlyphBuffer + EFI_GLYPH_HEIGHT, Wide.GlyphCol2, EFI_GLYPH_HEIGHT);
-            if (Attributes != NULL) {
-              *Attributes = (UINT8) (Wide.Attributes | EFI_GLYPH_WIDE);
-            }
-            return EFI_SUCCESS;
-          }
-        }
-      }
+    mHiiGlyphCacheHits++;
+  }
+
+  if (EFI_ERROR (Entry->Status)) {
+    ZeroMem (Cell, sizeof (EFI_HII_GLYPH_INFO));
+    return Entry->Status;
+  }
+
+  CopyMem (Cell, &Entry->Cell, sizeof (EFI_HII_GLYPH_INFO));
+  if (Entry->GlyphBufferLen > 0) {
+    *GlyphBuffer = AllocateCopyPool (Entry->GlyphBufferLen, Entry->GlyphBuffer);
+    if (*GlyphBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
     }
   }
+  if (Attributes != NULL) {
+    *Attributes = Entry->Attributes;
+  }
 
-  return EFI_NOT_FOUND;
+  return EFI_SUCCESS;
 }
 
 /**
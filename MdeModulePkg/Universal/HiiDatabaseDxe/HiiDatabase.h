@@ -145,6 +145,20 @@ typedef struct {
 // String Package definitions
 //
 #define HII_STRING_PACKAGE_SIGNATURE    SIGNATURE_32 ('h','i','s','p')
+
+//
+// StringId index entry. BlockOffset is relative to StringBlock and TextOffset
+// is relative to the string block itself. A duplicate entry keeps the id of the
+// referenced string in TextOffset until the index is fully built.
+//
+#define HII_STRING_INDEX_NOT_FOUND      0xFFFFFFFF
+#define HII_STRING_INDEX_DUPLICATE      0xFFFFFFFE
+
+typedef struct {
+  UINT32                                BlockOffset;
+  UINT32                                TextOffset;
+} HII_STRING_INDEX_ENTRY;
+
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                                 Signature;
   EFI_HII_STRING_PACKAGE_HDR            *StringPkgHdr;
@@ -153,6 +167,8 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                            FontInfoList;  // local font info list
   UINT8                                 FontId;
   EFI_STRING_ID                         MaxStringId;   // record StringId
+  HII_STRING_INDEX_ENTRY                *StringIndex;  // built on demand, NULL when stale
+  UINTN                                 StringIndexCount;
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -198,6 +214,23 @@ typedef struct _HII_GLYPH_INFO {
   EFI_HII_GLYPH_INFO                    Cell;
 } HII_GLYPH_INFO;
 
+//
+// Glyph cache definitions. The cache is direct-mapped and indexed by a hash
+// of the font package and the character value.
+//
+#define HII_GLYPH_CACHE_SIZE            512
+
+typedef struct _HII_GLYPH_CACHE_ENTRY {
+  BOOLEAN                               Valid;
+  HII_FONT_PACKAGE_INSTANCE             *FontPackage;  // NULL for the system default font
+  CHAR16                                CharValue;
+  EFI_STATUS                            Status;        // EFI_SUCCESS or EFI_NOT_FOUND
+  UINT8                                 Attributes;
+  EFI_HII_GLYPH_INFO                    Cell;
+  UINTN                                 GlyphBufferLen;
+  UINT8                                 *GlyphBuffer;
+} HII_GLYPH_CACHE_ENTRY;
+
 #define HII_FONT_INFO_SIGNATURE         SIGNATURE_32 ('h','l','f','i')
 typedef struct _HII_FONT_INFO {
   UINTN                                 Signature;
@@ -263,8 +296,26 @@ typedef struct _HII_DATABASE_PACKAGE_LIST_INSTANCE {
   HII_IMAGE_PACKAGE_INSTANCE            *ImagePkg;
   LIST_ENTRY                            SimpleFontPkgHdr;
   UINT8                                 *DevicePathPkg;
+  UINT8                                 *FormPkgCache;        // exported form packages, NULL if not cached
+  UINTN                                 FormPkgCacheSize;
+  LIST_ENTRY                            ConfigRequestCache;  // HII_CONFIG_REQUEST_CACHE list
 } HII_DATABASE_PACKAGE_LIST_INSTANCE;
 
+//
+// Full request and default strings which ConfigRouting built from the IFR of
+// a package list for a <ConfigHdr> without request elements. They are dropped
+// whenever a package of the package list is added, updated or removed.
+//
+#define HII_CONFIG_REQUEST_CACHE_SIGNATURE  SIGNATURE_32 ('h','c','r','c')
+typedef struct {
+  UINTN                                 Signature;
+  LIST_ENTRY                            Entry;
+  EFI_STRING                            Request;       // <ConfigHdr>, NULL for the first varstore
+  EFI_DEVICE_PATH_PROTOCOL              *DevicePath;
+  EFI_STRING                            ConfigRequest; // NULL if the IFR has no such question
+  EFI_STRING                            AltCfgResp;
+} HII_CONFIG_REQUEST_CACHE;
+
 #define HII_HANDLE_SIGNATURE            SIGNATURE_32 ('h','i','h','l')
 
 typedef struct {
@@ -400,6 +451,18 @@ GenerateSubStr (
   OUT EFI_STRING                   *SubStr
   );
 
+/**
+  Free the form package image and the request strings which ConfigRouting
+  has cached for a package list.
+
+  @param  PackageList             The package list instance.
+
+**/
+VOID
+HiiFlushIfrCache (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList
+  );
+
 /**
   This function checks whether a handle is a valid EFI_HII_HANDLE.
 
@@ -533,6 +596,19 @@ FindStringBlock (
   );
 
 
+/**
+  Free the StringId index of a string package. It must be called whenever the
+  string blocks of the package are changed; the index is rebuilt on next use.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+HiiFreeStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  );
+
+
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
   If CharValue = (CHAR16) (-1), collect all default character cell information
@@ -563,6 +639,17 @@ FindGlyphBlock (
   OUT UINTN                          *GlyphBufferLen OPTIONAL
   );
 
+/**
+  Invalidate all glyphs in the glyph cache.
+  This is called whenever a font package or a simple font package is
+  added to or removed from the HII database.
+
+**/
+VOID
+HiiFlushGlyphCache (
+  VOID
+  );
+
 /**
   This function exports Form packages to a buffer.
   This is a internal function.
@@ -233,6 +233,217 @@ GetStringFontInfo (
 }
 
 
+/**
+  Free the StringId index of a string package. It must be called whenever the
+  string blocks of the package are changed; the index is rebuilt on next use.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+HiiFreeStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex = NULL;
+  }
+  StringPackage->StringIndexCount = 0;
+}
+
+
+/**
+  Parse all string blocks once and record, for every StringId up to
+  MaxStringId, where its string block and string text are located.
+  Ids of skip blocks and ids which are not covered by any block are
+  recorded as not found; duplicate blocks are resolved to the block of
+  the referenced string.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+
+  @retval EFI_SUCCESS             The index is built.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+BuildStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  HII_STRING_INDEX_ENTRY               *StringIndex;
+  UINTN                                Count;
+  UINT8                                *BlockHdr;
+  UINT8                                *StringTextPtr;
+  UINTN                                CurrentStringId;
+  UINTN                                Index;
+  UINTN                                Depth;
+  UINTN                                Offset;
+  UINTN                                StringSize;
+  UINT16                               StringCount;
+  UINT16                               SkipCount;
+  UINT8                                Length8;
+  UINT32                               Length32;
+  EFI_HII_SIBT_EXT2_BLOCK              Ext2;
+  EFI_STRING_ID                        DuplicateId;
+
+  Count       = (UINTN) StringPackage->MaxStringId + 1;
+  StringIndex = (HII_STRING_INDEX_ENTRY *) AllocatePool (Count * sizeof (HII_STRING_INDEX_ENTRY));
+  if (StringIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  SetMem (StringIndex, Count * sizeof (HII_STRING_INDEX_ENTRY), 0xFF);
+
+  CurrentStringId = 1;
+  StringSize      = 0;
+  BlockHdr        = StringPackage->StringBlock;
+  while (*BlockHdr != EFI_HII_SIBT_END) {
+    StringCount   = 0;
+    StringTextPtr = NULL;
+    switch (*BlockHdr) {
+    case EFI_HII_SIBT_STRING_SCSU:
+    case EFI_HII_SIBT_STRING_SCSU_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRING_SCSU) {
+        Offset = sizeof (EFI_HII_STRING_BLOCK);
+      } else {
+        Offset = sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      }
+      StringTextPtr = BlockHdr + Offset;
+      StringCount   = 1;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2:
+    case EFI_HII_SIBT_STRING_UCS2_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRING_UCS2) {
+        Offset = sizeof (EFI_HII_STRING_BLOCK);
+      } else {
+        Offset = sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      }
+      StringTextPtr = BlockHdr + Offset;
+      StringCount   = 1;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_DUPLICATE:
+      CopyMem (&DuplicateId, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (EFI_STRING_ID));
+      if (CurrentStringId < Count) {
+        StringIndex[CurrentStringId].BlockOffset = HII_STRING_INDEX_DUPLICATE;
+        StringIndex[CurrentStringId].TextOffset  = DuplicateId;
+      }
+      CurrentStringId++;
+      BlockHdr += sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_SKIP1:
+      SkipCount        = (UINT16) (*(BlockHdr + sizeof (EFI_HII_STRING_BLOCK)));
+      CurrentStringId += SkipCount;
+      BlockHdr        += sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_SKIP2:
+      CopyMem (&SkipCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      CurrentStringId += SkipCount;
+      BlockHdr        += sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+      continue;
+
+    case EFI_HII_SIBT_EXT1:
+      CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+      BlockHdr += Length8;
+      continue;
+
+    case EFI_HII_SIBT_EXT2:
+      CopyMem (&Ext2, BlockHdr, sizeof (EFI_HII_SIBT_EXT2_BLOCK));
+      BlockHdr += Ext2.Length;
+      continue;
+
+    case EFI_HII_SIBT_EXT4:
+      CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+      BlockHdr += Length32;
+      continue;
+
+    default:
+      //
+      // FindStringBlock() does not step over unknown blocks either, so there
+      // is nothing sensible to index. Fall back to the block walk.
+      //
+      FreePool (StringIndex);
+      return EFI_UNSUPPORTED;
+    }
+
+    //
+    // Record every string of a string block, then step over the block.
+    //
+    for (Index = 0; Index < StringCount; Index++) {
+      if (CurrentStringId < Count) {
+        StringIndex[CurrentStringId].BlockOffset = (UINT32) (BlockHdr - StringPackage->StringBlock);
+        StringIndex[CurrentStringId].TextOffset  = (UINT32) (StringTextPtr - BlockHdr);
+      }
+      if (*BlockHdr == EFI_HII_SIBT_STRING_SCSU ||
+          *BlockHdr == EFI_HII_SIBT_STRING_SCSU_FONT ||
+          *BlockHdr == EFI_HII_SIBT_STRINGS_SCSU ||
+          *BlockHdr == EFI_HII_SIBT_STRINGS_SCSU_FONT) {
+        StringTextPtr += AsciiStrSize ((CHAR8 *) StringTextPtr);
+      } else {
+        GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+        StringTextPtr += StringSize;
+      }
+      CurrentStringId++;
+    }
+    BlockHdr = StringTextPtr;
+  }
+
+  //
+  // Resolve duplicate blocks to the block of the string they refer to. A chain
+  // longer than the number of ids can only be a loop, which is not found.
+  //
+  for (Index = 1; Index < Count; Index++) {
+    DuplicateId = (EFI_STRING_ID) Index;
+    for (Depth = 0; Depth < Count; Depth++) {
+      if (StringIndex[DuplicateId].BlockOffset != HII_STRING_INDEX_DUPLICATE) {
+        break;
+      }
+      DuplicateId = (EFI_STRING_ID) StringIndex[DuplicateId].TextOffset;
+      if (DuplicateId == 0 || DuplicateId >= Count) {
+        break;
+      }
+    }
+    if (DuplicateId == 0 || DuplicateId >= Count || Depth == Count) {
+      StringIndex[Index].BlockOffset = HII_STRING_INDEX_NOT_FOUND;
+    } else if (DuplicateId != Index) {
+      StringIndex[Index] = StringIndex[DuplicateId];
+    }
+  }
+
+  HiiFreeStringIndex (StringPackage);
+  StringPackage->StringIndex      = StringIndex;
+  StringPackage->StringIndexCount = Count;
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
@@ -311,6 +522,26 @@ FindStringBlock (
     }
   }
 
+  //
+  // A plain lookup is served from the StringId index, which is built on the
+  // first such lookup after the string blocks have changed. Callers asking for
+  // StartStringId need the enclosing skip block and walk the blocks instead.
+  //
+  if (StringId != (EFI_STRING_ID) (-1) && StringId != 0 && StartStringId == NULL) {
+    if (StringPackage->StringIndex == NULL) {
+      BuildStringIndex (StringPackage);
+    }
+    if (StringPackage->StringIndex != NULL && StringId < StringPackage->StringIndexCount) {
+      if (StringPackage->StringIndex[StringId].BlockOffset == HII_STRING_INDEX_NOT_FOUND) {
+        return EFI_NOT_FOUND;
+      }
+      *StringBlockAddr  = StringPackage->StringBlock + StringPackage->StringIndex[StringId].BlockOffset;
+      *BlockType        = **StringBlockAddr;
+      *StringTextOffset = StringPackage->StringIndex[StringId].TextOffset;
+      return EFI_SUCCESS;
+    }
+  }
+
   ZeroMem (&Zero, sizeof (CHAR16));
 
   //
@@ -845,6 +1076,7 @@ InsertLackStringBlock (
   } else {
     *BlockType = EFI_HII_SIBT_STRING_UCS2;
   }
+  HiiFreeStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = StringBlock;
   StringPackage->StringPkgHdr->Header.Length += NewBlockSize - OldBlockSize;
@@ -1012,6 +1244,7 @@ SetStringWorker (
       TmpSize
       );
 
+    HiiFreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1045,6 +1278,7 @@ SetStringWorker (
       OldBlockSize - (StringTextPtr - StringPackage->StringBlock) - StringSize
       );
 
+    HiiFreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1096,6 +1330,7 @@ SetStringWorker (
 
   CopyMem (BlockPtr, StringPackage->StringBlock, OldBlockSize);
 
+  HiiFreeStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = Block;
   StringPackage->StringPkgHdr->Header.Length += Ext2.Length;
@@ -1279,6 +1514,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      HiiFreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1410,6 +1646,7 @@ HiiNewString (
     // Append a EFI_HII_SIBT_END block to the end.
     //
     *BlockPtr = EFI_HII_SIBT_END;
+    HiiFreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = StringBlock;
     StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1452,6 +1689,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      HiiFreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2FontBlockSize;
@@ -1513,6 +1751,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      HiiFreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += FontBlockSize + Ucs2FontBlockSize;
@@ -1549,6 +1788,7 @@ Done:
       Link = Link->ForwardLink
       ) {
         StringPackage = CR (Link, HII_STRING_PACKAGE_INSTANCE, StringEntry, HII_STRING_PACKAGE_SIGNATURE);
+        HiiFreeStringIndex (StringPackage);
         StringPackage->MaxStringId = *StringId;
     }
   } else if (NewStringPackageCreated) {
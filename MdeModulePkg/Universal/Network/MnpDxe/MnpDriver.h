@@ -76,6 +76,12 @@ typedef struct {
 
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  //
+  // Current period of PollTimer and the number of consecutive polls that
+  // received nothing, used to adapt the period to the receive load.
+  //
+  UINT64                        PollInterval;
+  UINT32                        PollIdleCount;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
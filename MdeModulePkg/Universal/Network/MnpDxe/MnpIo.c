@@ -1108,10 +1108,53 @@ MnpCheckMediaStatus (
   }
 }
 
+/**
+  Adapt the period of the system poll timer to the receive load.
+
+  The timer runs at MNP_SYS_POLL_INTERVAL_MIN while packets keep arriving and
+  falls back to MNP_SYS_POLL_INTERVAL after MNP_SYS_POLL_IDLE_COUNT consecutive
+  polls without any packet.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[in]       Received             Number of packets received by this poll.
+
+**/
+VOID
+MnpAdjustPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINTN             Received
+  )
+{
+  UINT64  Interval;
+
+  if (!MnpDeviceData->EnableSystemPoll) {
+    return;
+  }
+
+  Interval = MnpDeviceData->PollInterval;
+  if (Received != 0) {
+    MnpDeviceData->PollIdleCount = 0;
+    Interval = MNP_SYS_POLL_INTERVAL_MIN;
+  } else if (MnpDeviceData->PollIdleCount < MNP_SYS_POLL_IDLE_COUNT) {
+    MnpDeviceData->PollIdleCount++;
+  } else {
+    Interval = MNP_SYS_POLL_INTERVAL;
+  }
+
+  if (Interval != MnpDeviceData->PollInterval) {
+    if (!EFI_ERROR (gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval))) {
+      MnpDeviceData->PollInterval = Interval;
+    }
+  }
+}
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  Up to MNP_RX_BATCH_SIZE packets are drained from Snp per call, so that a busy
+  link is not limited to one packet per timer tick.
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
@@ -1124,17 +1167,24 @@ MnpSystemPoll (
   )
 {
   MNP_DEVICE_DATA  *MnpDeviceData;
+  UINTN            Received;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
   //
-  // Try to receive packets from Snp.
+  // Try to receive packets from Snp until it has no more or the batch is full.
   //
-  MnpReceivePacket (MnpDeviceData);
+  for (Received = 0; Received < MNP_RX_BATCH_SIZE; Received++) {
+    if (EFI_ERROR (MnpReceivePacket (MnpDeviceData))) {
+      break;
+    }
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
   //
   DispatchDpc ();
+
+  MnpAdjustPollInterval (MnpDeviceData, Received);
 }
@@ -8,6 +8,7 @@
   RFC2347 - TFTP Option Extension
   RFC2348 - TFTP Blocksize Option
   RFC2349 - TFTP Timeout Interval and Transfer Size Options
+  RFC7440 - TFTP Windowsize Option
   
 Copyright (c) 2006 - 2012, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
@@ -56,6 +57,7 @@ typedef struct _MTFTP4_PROTOCOL MTFTP4_PROTOCOL;
 #define MTFTP4_DEFAULT_TIMEOUT      3
 #define MTFTP4_DEFAULT_RETRY        5
 #define MTFTP4_DEFAULT_BLKSIZE      512
+#define MTFTP4_DEFAULT_WINDOWSIZE   1
 #define MTFTP4_TIME_TO_GETMAP       5
 
 #define MTFTP4_STATE_UNCONFIGED     0
@@ -120,6 +122,15 @@ struct _MTFTP4_PROTOCOL {
   UINT16                        LastBlock;
   LIST_ENTRY                    Blocks;
 
+  //
+  // Number of data blocks the server sends before waiting for an
+  // ACK, the blocks received since the last ACK was sent, and whether
+  // a gap in the current window has been ACKed already.
+  //
+  UINT16                        WindowSize;
+  UINT16                        WindowBlock;
+  BOOLEAN                       GapAcked;
+
   //
   // The server's communication end point: IP and two ports. one for
   // initial request, one for its selected port.
@@ -207,6 +218,25 @@ Mtftp4RrqStart (
   IN UINT16                 Operation
   );
 
+/**
+  Retransmit on a time out of a download with a window negotiated.
+
+  The last packet sent is the ACK of an earlier window boundary, which would
+  make the server resend a window of blocks mostly received already. ACK the
+  last in-order block instead, so that the server starts a new window at the
+  first missing block. The retry count of the time out is kept.
+
+  @param  Instance              The Mtftp session
+
+  @retval EFI_SUCCESS           The ACK has been sent
+  @retval Others                Failed to send the ACK.
+
+**/
+EFI_STATUS
+Mtftp4RrqRetransmit (
+  IN MTFTP4_PROTOCOL        *Instance
+  );
+
 #define MTFTP4_SERVICE_FROM_THIS(a)   \
   CR (a, MTFTP4_SERVICE, ServiceBinding, MTFTP4_SERVICE_SIGNATURE)
 
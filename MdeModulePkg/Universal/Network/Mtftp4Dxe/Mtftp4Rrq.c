@@ -115,10 +115,52 @@ Mtftp4RrqSendAck (
   Ack->Ack.OpCode   = HTONS (EFI_MTFTP4_OPCODE_ACK);
   Ack->Ack.Block[0] = HTONS (BlkNo);
 
+  //
+  // Every ACK opens a new window at the server.
+  //
+  Instance->WindowBlock = 0;
+
   return Mtftp4SendPacket (Instance, Packet);
 }
 
 
+/**
+  Retransmit on a time out of a download with a window negotiated.
+
+  The last packet sent is the ACK of an earlier window boundary, which would
+  make the server resend a window of blocks mostly received already. ACK the
+  last in-order block instead, so that the server starts a new window at the
+  first missing block. The retry count of the time out is kept.
+
+  @param  Instance              The Mtftp session
+
+  @retval EFI_SUCCESS           The ACK has been sent
+  @retval Others                Failed to send the ACK.
+
+**/
+EFI_STATUS
+Mtftp4RrqRetransmit (
+  IN MTFTP4_PROTOCOL        *Instance
+  )
+{
+  EFI_STATUS                Status;
+  INTN                      Expected;
+  UINT32                    Retry;
+
+  Expected = Mtftp4GetNextBlockNum (&Instance->Blocks);
+  if (Expected < 0) {
+    return Mtftp4Retransmit (Instance);
+  }
+
+  Retry              = Instance->CurRetry;
+  Instance->GapAcked = FALSE;
+  Status             = Mtftp4RrqSendAck (Instance, (UINT16) (Expected - 1));
+  Instance->CurRetry = Retry;
+
+  return Status;
+}
+
+
 /**
   Deliver the received data block to the user, which can be saved
   in the user provide buffer or through the CheckPacket callback.
@@ -268,6 +310,23 @@ Mtftp4RrqHandleData (
   // the block.
   //
   if (Instance->Master && (Expected != BlockNum)) {
+    if (Instance->WindowSize > 1) {
+      //
+      // When a window is negotiated, an old block is a duplicate from
+      // a window already ACKed, drop it silently. A gap means some block
+      // in the window is lost: ACK the last in-order block once so that
+      // the server restarts the window from there, and ignore the rest
+      // of the broken window. Neither is counted into the new window. If
+      // the ACK is lost, the time out ACKs the last in-order block again.
+      //
+      if ((BlockNum < Expected) || Instance->GapAcked) {
+        return EFI_SUCCESS;
+      }
+
+      Instance->GapAcked = TRUE;
+      return Mtftp4RrqSendAck (Instance, (UINT16) (Expected - 1));
+    }
+
     Mtftp4Retransmit (Instance);
     return EFI_SUCCESS;
   }
@@ -293,6 +352,8 @@ Mtftp4RrqHandleData (
   // to tell the server that we are done.
   //
   Expected = Mtftp4GetNextBlockNum (&Instance->Blocks);
+  Instance->WindowBlock++;
+  Instance->GapAcked = FALSE;
 
   if (Instance->Master || (Expected < 0)) {
     if (Expected < 0) {
@@ -307,6 +368,14 @@ Mtftp4RrqHandleData (
 
     } else {
       BlockNum = (UINT16) (Expected - 1);
+
+      //
+      // Only ACK at the window boundary, the server keeps sending
+      // the rest of the window without waiting for us.
+      //
+      if (Instance->WindowBlock < Instance->WindowSize) {
+        return EFI_SUCCESS;
+      }
     }
 
     Mtftp4RrqSendAck (Instance, BlockNum);
@@ -323,7 +392,8 @@ Mtftp4RrqHandleData (
   1. The server doesn't include options not requested by us
   2. The server can only use smaller blksize than that is requested
   3. The server can only use the same timeout as requested
-  4. The server doesn't change its multicast channel.
+  4. The server can only use smaller windowsize than that is requested
+  5. The server doesn't change its multicast channel.
 
   @param  This                  The downloading Mtftp session
   @param  Reply                 The options in the OACK packet
@@ -357,6 +427,11 @@ Mtftp4RrqOackValid (
     return FALSE;
   }
 
+  if (((Reply->Exist & MTFTP4_WINDOWSIZE_EXIST) != 0) &&
+      (Reply->WindowSize > Request->WindowSize)) {
+    return FALSE;
+  }
+
   //
   // The server can send ",,master" to client to change its master
   // setting. But if it use the specific multicast channel, it can't
@@ -614,6 +689,14 @@ Mtftp4RrqHandleOack (
     if (Reply.Timeout != 0) {
       Instance->Timeout = Reply.Timeout;
     }
+
+    //
+    // Servers that don't know the windowsize option leave it out of
+    // the OACK, then the transfer stays in lockstep.
+    //
+    if (Reply.WindowSize != 0) {
+      Instance->WindowSize = Reply.WindowSize;
+    }
   }
   
   //
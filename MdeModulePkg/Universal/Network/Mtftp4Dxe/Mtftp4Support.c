@@ -532,6 +532,11 @@ Mtftp4Retransmit (
 
   ASSERT (Instance->LastPacket != NULL);
 
+  //
+  // The retransmitted ACK opens a new window at the server.
+  //
+  Instance->WindowBlock = 0;
+
   ZeroMem (&UdpPoint, sizeof (UdpPoint));
   UdpPoint.RemoteAddr.Addr[0] = Instance->ServerIp;
 
@@ -624,7 +629,12 @@ Mtftp4OnTimerTick (
     // otherwise exit the transfer.
     //
     if (++Instance->CurRetry < Instance->MaxRetry) {
-      Mtftp4Retransmit (Instance);
+      if ((Instance->WindowSize > 1) && Instance->Master &&
+          ((Instance->Operation == EFI_MTFTP4_OPCODE_RRQ) || (Instance->Operation == EFI_MTFTP4_OPCODE_DIR))) {
+        Mtftp4RrqRetransmit (Instance);
+      } else {
+        Mtftp4Retransmit (Instance);
+      }
       Mtftp4SetTimeout (Instance);
     } else {
       Mtftp4CleanOperation (Instance, EFI_TIMEOUT);
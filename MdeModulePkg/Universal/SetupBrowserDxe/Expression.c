@@ -2502,6 +2502,236 @@ Done:
   return GetTheVal;
 }
 
+/**
+  Collect the questions an expression reads. An expression which uses an
+  opcode whose result does not only depend on question values, such as
+  EFI_IFR_GET or EFI_IFR_RULE_REF, is marked volatile.
+
+  @param  FormSet                FormSet associated with this expression.
+  @param  Form                   Form associated with this expression.
+  @param  Expression             The expression.
+
+**/
+VOID
+BuildExpressionDependency (
+  IN FORM_BROWSER_FORMSET  *FormSet,
+  IN FORM_BROWSER_FORM     *Form,
+  IN OUT FORM_EXPRESSION   *Expression
+  )
+{
+  LIST_ENTRY              *Link;
+  EXPRESSION_OPCODE       *OpCode;
+  UINTN                   Count;
+  UINTN                   Index;
+
+  Expression->DependencyState = EXPRESSION_DEPENDENCY_VOLATILE;
+
+  //
+  // First count the question references and check that every opcode is one
+  // whose result is determined by its operands.
+  //
+  Count = 0;
+  for (Link = GetFirstNode (&Expression->OpCodeListHead);
+       !IsNull (&Expression->OpCodeListHead, Link);
+       Link = GetNextNode (&Expression->OpCodeListHead, Link)) {
+    OpCode = EXPRESSION_OPCODE_FROM_LINK (Link);
+    switch (OpCode->Operand) {
+    case EFI_IFR_EQ_ID_ID_OP:
+      Count += 2;
+      break;
+
+    case EFI_IFR_EQ_ID_VAL_OP:
+    case EFI_IFR_EQ_ID_VAL_LIST_OP:
+    case EFI_IFR_QUESTION_REF1_OP:
+    case EFI_IFR_THIS_OP:
+      Count++;
+      break;
+
+    case EFI_IFR_DUP_OP:
+    case EFI_IFR_TRUE_OP:
+    case EFI_IFR_FALSE_OP:
+    case EFI_IFR_ONE_OP:
+    case EFI_IFR_ONES_OP:
+    case EFI_IFR_UINT8_OP:
+    case EFI_IFR_UINT16_OP:
+    case EFI_IFR_UINT32_OP:
+    case EFI_IFR_UINT64_OP:
+    case EFI_IFR_UNDEFINED_OP:
+    case EFI_IFR_VERSION_OP:
+    case EFI_IFR_ZERO_OP:
+    case EFI_IFR_LENGTH_OP:
+    case EFI_IFR_NOT_OP:
+    case EFI_IFR_TO_BOOLEAN_OP:
+    case EFI_IFR_TO_STRING_OP:
+    case EFI_IFR_TO_UINT_OP:
+    case EFI_IFR_TO_LOWER_OP:
+    case EFI_IFR_TO_UPPER_OP:
+    case EFI_IFR_BITWISE_NOT_OP:
+    case EFI_IFR_ADD_OP:
+    case EFI_IFR_SUBTRACT_OP:
+    case EFI_IFR_MULTIPLY_OP:
+    case EFI_IFR_DIVIDE_OP:
+    case EFI_IFR_MODULO_OP:
+    case EFI_IFR_BITWISE_AND_OP:
+    case EFI_IFR_BITWISE_OR_OP:
+    case EFI_IFR_SHIFT_LEFT_OP:
+    case EFI_IFR_SHIFT_RIGHT_OP:
+    case EFI_IFR_AND_OP:
+    case EFI_IFR_OR_OP:
+    case EFI_IFR_EQUAL_OP:
+    case EFI_IFR_NOT_EQUAL_OP:
+    case EFI_IFR_GREATER_EQUAL_OP:
+    case EFI_IFR_GREATER_THAN_OP:
+    case EFI_IFR_LESS_EQUAL_OP:
+    case EFI_IFR_LESS_THAN_OP:
+    case EFI_IFR_MATCH_OP:
+    case EFI_IFR_MATCH2_OP:
+    case EFI_IFR_CATENATE_OP:
+    case EFI_IFR_CONDITIONAL_OP:
+    case EFI_IFR_FIND_OP:
+    case EFI_IFR_MID_OP:
+    case EFI_IFR_TOKEN_OP:
+    case EFI_IFR_SPAN_OP:
+      break;
+
+    default:
+      return;
+    }
+  }
+
+  if (Count != 0) {
+    Expression->Dependency = AllocateZeroPool (Count * sizeof (EXPRESSION_DEPENDENCY));
+    if (Expression->Dependency == NULL) {
+      return;
+    }
+  }
+
+  Index = 0;
+  for (Link = GetFirstNode (&Expression->OpCodeListHead);
+       !IsNull (&Expression->OpCodeListHead, Link);
+       Link = GetNextNode (&Expression->OpCodeListHead, Link)) {
+    OpCode = EXPRESSION_OPCODE_FROM_LINK (Link);
+    switch (OpCode->Operand) {
+    case EFI_IFR_EQ_ID_ID_OP:
+      Expression->Dependency[Index++].Question = IdToQuestion2 (Form, OpCode->QuestionId);
+      Expression->Dependency[Index++].Question = IdToQuestion2 (Form, OpCode->QuestionId2);
+      break;
+
+    case EFI_IFR_EQ_ID_VAL_OP:
+    case EFI_IFR_EQ_ID_VAL_LIST_OP:
+    case EFI_IFR_QUESTION_REF1_OP:
+    case EFI_IFR_THIS_OP:
+      Expression->Dependency[Index++].Question = IdToQuestion2 (Form, OpCode->QuestionId);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  //
+  // Only track the questions of this form. IdToQuestion() reloads a question
+  // of another form in EFI variable storage on every evaluation, because
+  // Callback() may change it asynchronously, and a question in EFI variable
+  // storage of this form may change the same way. Keep such an expression,
+  // or one referring to a question which can't be found, volatile.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    if (Expression->Dependency[Index].Question == NULL ||
+        (Expression->Dependency[Index].Question->Storage != NULL &&
+         Expression->Dependency[Index].Question->Storage->Type == EFI_HII_VARSTORE_EFI_VARIABLE)) {
+      FreePool (Expression->Dependency);
+      Expression->Dependency = NULL;
+      return;
+    }
+  }
+
+  Expression->DependencyCount = Count;
+  Expression->DependencyState = EXPRESSION_DEPENDENCY_TRACKED;
+}
+
+/**
+  Record the values of the questions an expression read while it was
+  evaluated, so that IsExpressionResultCurrent() can tell whether the
+  result is still current.
+
+  @param  FormSet                FormSet associated with this expression.
+  @param  Form                   Form associated with this expression.
+  @param  Expression             The expression which has just been evaluated.
+
+**/
+VOID
+SaveExpressionDependency (
+  IN FORM_BROWSER_FORMSET  *FormSet,
+  IN FORM_BROWSER_FORM     *Form,
+  IN OUT FORM_EXPRESSION   *Expression
+  )
+{
+  UINTN                   Index;
+  EFI_HII_VALUE           *QuestionValue;
+
+  Expression->DependencyValid = FALSE;
+
+  if (Expression->DependencyState == EXPRESSION_DEPENDENCY_UNKNOWN) {
+    BuildExpressionDependency (FormSet, Form, Expression);
+  }
+  if (Expression->DependencyState != EXPRESSION_DEPENDENCY_TRACKED) {
+    return;
+  }
+
+  //
+  // The content of string and buffer values lives outside of EFI_HII_VALUE,
+  // so a change of them can't be detected from the value itself.
+  //
+  if (Expression->Result.Type == EFI_IFR_TYPE_STRING || Expression->Result.Type == EFI_IFR_TYPE_BUFFER) {
+    return;
+  }
+  for (Index = 0; Index < Expression->DependencyCount; Index++) {
+    QuestionValue = &Expression->Dependency[Index].Question->HiiValue;
+    if (QuestionValue->Type == EFI_IFR_TYPE_STRING || QuestionValue->Type == EFI_IFR_TYPE_BUFFER ||
+        QuestionValue->Buffer != NULL) {
+      return;
+    }
+    CopyMem (&Expression->Dependency[Index].Value, QuestionValue, sizeof (EFI_HII_VALUE));
+  }
+
+  Expression->DependencyValid = TRUE;
+}
+
+/**
+  Check whether the result of an expression is still current, i.e. none of
+  the questions it reads has changed since it was last evaluated.
+
+  @param  Expression             The expression to check.
+
+  @retval TRUE                   Expression->Result is current.
+  @retval FALSE                  The expression needs to be evaluated.
+
+**/
+BOOLEAN
+IsExpressionResultCurrent (
+  IN FORM_EXPRESSION       *Expression
+  )
+{
+  UINTN                   Index;
+
+  if (!Expression->DependencyValid) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < Expression->DependencyCount; Index++) {
+    if (CompareMem (
+          &Expression->Dependency[Index].Value,
+          &Expression->Dependency[Index].Question->HiiValue,
+          sizeof (EFI_HII_VALUE)
+          ) != 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 /**
   Evaluate the result of a HII expression.
 
@@ -3609,6 +3839,9 @@ Done:
   RestoreExpressionEvaluationStackOffset (StackOffset);
   if (!EFI_ERROR (Status)) {
     CopyMem (&Expression->Result, Value, sizeof (EFI_HII_VALUE));
+    SaveExpressionDependency (FormSet, Form, Expression);
+  } else {
+    Expression->DependencyValid = FALSE;
   }
 
   return Status;
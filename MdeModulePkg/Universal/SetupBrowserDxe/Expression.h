@@ -224,6 +224,22 @@ EvaluateExpression (
   IN FORM_BROWSER_FORM     *Form,
   IN OUT FORM_EXPRESSION   *Expression
   );
+
+/**
+  Check whether the result of an expression is still current, i.e. none of
+  the questions it reads has changed since it was last evaluated.
+
+  @param  Expression             The expression to check.
+
+  @retval TRUE                   Expression->Result is current.
+  @retval FALSE                  The expression needs to be evaluated.
+
+**/
+BOOLEAN
+IsExpressionResultCurrent (
+  IN FORM_EXPRESSION       *Expression
+  );
+
 /**
   Return the result of the expression list. Check the expression list and 
   return the highest priority express result.  
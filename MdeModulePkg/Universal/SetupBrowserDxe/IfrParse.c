@@ -853,6 +853,10 @@ DestroyExpression (
     }
   }
 
+  if (Expression->Dependency != NULL) {
+    FreePool (Expression->Dependency);
+  }
+
   //
   // Free this Expression
   //
@@ -44,6 +44,11 @@ EvaluateFormExpressions (
   EFI_STATUS       Status;
   LIST_ENTRY       *Link;
   FORM_EXPRESSION  *Expression;
+  UINTN            EvaluatedCount;
+  UINTN            SkippedCount;
+
+  EvaluatedCount = 0;
+  SkippedCount   = 0;
 
   Link = GetFirstNode (&Form->ExpressionListHead);
   while (!IsNull (&Form->ExpressionListHead, Link)) {
@@ -61,12 +66,24 @@ EvaluateFormExpressions (
       continue;
     }
 
+    //
+    // Only evaluate the expressions which read a question whose value has
+    // changed since they were evaluated last time.
+    //
+    if (IsExpressionResultCurrent (Expression)) {
+      SkippedCount++;
+      continue;
+    }
+
+    EvaluatedCount++;
     Status = EvaluateExpression (FormSet, Form, Expression);
     if (EFI_ERROR (Status)) {
       return Status;
     }
   }
 
+  DEBUG ((DEBUG_VERBOSE, "SetupBrowser: form 0x%x evaluated %Lu expressions, %Lu unchanged\n", Form->FormId, (UINT64) EvaluatedCount, (UINT64) SkippedCount));
+
   return EFI_SUCCESS;
 }
 
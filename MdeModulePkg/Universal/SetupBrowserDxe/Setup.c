@@ -51,6 +51,24 @@ LIST_ENTRY      gBrowserFormSetList = INITIALIZE_LIST_HEAD_VARIABLE (gBrowserFor
 LIST_ENTRY      gBrowserHotKeyList  = INITIALIZE_LIST_HEAD_VARIABLE (gBrowserHotKeyList);
 LIST_ENTRY      gBrowserStorageList = INITIALIZE_LIST_HEAD_VARIABLE (gBrowserStorageList);
 LIST_ENTRY      gBrowserSaveFailFormSetList = INITIALIZE_LIST_HEAD_VARIABLE (gBrowserSaveFailFormSetList);
+LIST_ENTRY      mFormPackageCacheList = INITIALIZE_LIST_HEAD_VARIABLE (mFormPackageCacheList);
+UINTN           mFormPackageCacheCount = 0;
+UINTN           mFormPackageCacheSize  = 0;
+
+//
+// Package types whose removal drops the cached package list of the handle.
+// GUID packages can't be registered without a GUID, which is fine since only
+// package lists holding a Form package are cached.
+//
+UINT8           mFormPackageCacheRemoveTypes[] = {
+  EFI_HII_PACKAGE_FORMS,
+  EFI_HII_PACKAGE_STRINGS,
+  EFI_HII_PACKAGE_FONTS,
+  EFI_HII_PACKAGE_IMAGES,
+  EFI_HII_PACKAGE_SIMPLE_FONTS,
+  EFI_HII_PACKAGE_DEVICE_PATH,
+  EFI_HII_PACKAGE_KEYBOARD_LAYOUT
+};
 
 BOOLEAN               mSystemSubmit = FALSE;
 BOOLEAN               gResetRequired;
@@ -867,6 +885,35 @@ FormDisplayCallback (
                   );
 }
 
+/**
+  Package notify function that drops the cached package list of the
+  updated HII handle.
+
+  @param PackageType  Package type of the notification.
+  @param PackageGuid  GUID of the package, if the package type is
+                      EFI_HII_PACKAGE_TYPE_GUID. Otherwise NULL.
+  @param Package      Points to the package referred to by the notification.
+  @param Handle       The HII handle of the updated package list.
+  @param NotifyType   The type of change concerning the database.
+
+  @retval EFI_SUCCESS The notification was handled.
+
+**/
+EFI_STATUS
+EFIAPI
+FormPackageCacheNotify (
+  IN UINT8                              PackageType,
+  IN CONST EFI_GUID                     *PackageGuid,
+  IN CONST EFI_HII_PACKAGE_HEADER       *Package,
+  IN EFI_HII_HANDLE                     Handle,
+  IN EFI_HII_DATABASE_NOTIFY_TYPE       NotifyType
+  )
+{
+  FlushFormPackageCache (Handle);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize Setup Browser driver.
 
@@ -886,6 +933,8 @@ InitializeSetup (
 {
   EFI_STATUS                  Status;
   VOID                        *Registration;
+  EFI_HANDLE                  NotifyHandle;
+  UINTN                       Index;
 
   //
   // Locate required Hii relative protocols
@@ -897,6 +946,32 @@ InitializeSetup (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Keep the package list cache coherent with Form package updates, and drop
+  // the package list of a handle when any of its packages is removed, so that
+  // the handle value can't be reused by another package list meanwhile.
+  //
+  Status = mHiiDatabase->RegisterPackageNotify (
+                           mHiiDatabase,
+                           EFI_HII_PACKAGE_FORMS,
+                           NULL,
+                           FormPackageCacheNotify,
+                           EFI_HII_DATABASE_NOTIFY_ADD_PACK,
+                           &NotifyHandle
+                           );
+  ASSERT_EFI_ERROR (Status);
+  for (Index = 0; Index < sizeof (mFormPackageCacheRemoveTypes) / sizeof (mFormPackageCacheRemoveTypes[0]); Index++) {
+    Status = mHiiDatabase->RegisterPackageNotify (
+                             mHiiDatabase,
+                             mFormPackageCacheRemoveTypes[Index],
+                             NULL,
+                             FormPackageCacheNotify,
+                             EFI_HII_DATABASE_NOTIFY_REMOVE_PACK,
+                             &NotifyHandle
+                             );
+    ASSERT_EFI_ERROR (Status);
+  }
+
   Status = gBS->LocateProtocol (
                   &gEfiHiiConfigRoutingProtocolGuid,
                   NULL,
@@ -5593,6 +5668,235 @@ InitializeCurrentSetting (
 }
 
 
+/**
+  Free one package list cache entry.
+
+  @param  Entry                  The cache entry to free.
+
+**/
+VOID
+FreeFormPackageCacheEntry (
+  IN FORM_PACKAGE_CACHE    *Entry
+  )
+{
+  RemoveEntryList (&Entry->Link);
+  mFormPackageCacheCount--;
+  mFormPackageCacheSize -= Entry->PackageListSize;
+
+  FreePool (Entry->PackageList);
+  FreePool (Entry);
+}
+
+/**
+  Drop the cached package list of one HII handle, or of all handles.
+
+  @param  Handle                 The HII handle whose package list is dropped.
+                                 NULL to drop all cached package lists.
+
+**/
+VOID
+FlushFormPackageCache (
+  IN EFI_HII_HANDLE    Handle
+  )
+{
+  LIST_ENTRY           *Link;
+  FORM_PACKAGE_CACHE   *Entry;
+
+  Link = GetFirstNode (&mFormPackageCacheList);
+  while (!IsNull (&mFormPackageCacheList, Link)) {
+    Entry = FORM_PACKAGE_CACHE_FROM_LINK (Link);
+    Link  = GetNextNode (&mFormPackageCacheList, Link);
+
+    if (Handle == NULL || Entry->HiiHandle == Handle) {
+      FreeFormPackageCacheEntry (Entry);
+    }
+  }
+}
+
+/**
+  Copy the Form packages of a package list into a new package list, which
+  is terminated by an End package. The other packages, such as strings,
+  fonts and images, are not read from the package list by the browser.
+
+  @param  PackageList            The exported package list.
+  @param  FormPackageList        Returns the new package list.
+  @param  FormPackageListSize    Returns the size of the new package list.
+
+  @retval EFI_SUCCESS            The Form packages are copied.
+  @retval EFI_NOT_FOUND          The package list holds no Form package.
+  @retval EFI_OUT_OF_RESOURCES   No enough memory for the new package list.
+
+**/
+EFI_STATUS
+ExtractFormPackages (
+  IN  EFI_HII_PACKAGE_LIST_HEADER     *PackageList,
+  OUT EFI_HII_PACKAGE_LIST_HEADER     **FormPackageList,
+  OUT UINTN                           *FormPackageListSize
+  )
+{
+  UINT32                       Offset;
+  UINT32                       PackageListLength;
+  UINT32                       FormPackageListLength;
+  EFI_HII_PACKAGE_HEADER       PackageHeader;
+  EFI_HII_PACKAGE_LIST_HEADER  *NewPackageList;
+  UINT8                        *Package;
+
+  //
+  // Sum up the size of the Form packages.
+  //
+  FormPackageListLength = 0;
+  CopyMem (&PackageListLength, &PackageList->PackageLength, sizeof (UINT32));
+  for (Offset = sizeof (EFI_HII_PACKAGE_LIST_HEADER); Offset < PackageListLength; Offset += PackageHeader.Length) {
+    CopyMem (&PackageHeader, (UINT8 *) PackageList + Offset, sizeof (EFI_HII_PACKAGE_HEADER));
+    if (PackageHeader.Type == EFI_HII_PACKAGE_END || PackageHeader.Length == 0) {
+      break;
+    }
+    if (PackageHeader.Type == EFI_HII_PACKAGE_FORMS) {
+      FormPackageListLength += PackageHeader.Length;
+    }
+  }
+  if (FormPackageListLength == 0) {
+    return EFI_NOT_FOUND;
+  }
+  FormPackageListLength += sizeof (EFI_HII_PACKAGE_LIST_HEADER) + sizeof (EFI_HII_PACKAGE_HEADER);
+
+  NewPackageList = AllocateZeroPool (FormPackageListLength);
+  if (NewPackageList == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (&NewPackageList->PackageListGuid, &PackageList->PackageListGuid, sizeof (EFI_GUID));
+  CopyMem (&NewPackageList->PackageLength, &FormPackageListLength, sizeof (UINT32));
+  Package = (UINT8 *) (NewPackageList + 1);
+  for (Offset = sizeof (EFI_HII_PACKAGE_LIST_HEADER); Offset < PackageListLength; Offset += PackageHeader.Length) {
+    CopyMem (&PackageHeader, (UINT8 *) PackageList + Offset, sizeof (EFI_HII_PACKAGE_HEADER));
+    if (PackageHeader.Type == EFI_HII_PACKAGE_END || PackageHeader.Length == 0) {
+      break;
+    }
+    if (PackageHeader.Type == EFI_HII_PACKAGE_FORMS) {
+      CopyMem (Package, (UINT8 *) PackageList + Offset, PackageHeader.Length);
+      Package += PackageHeader.Length;
+    }
+  }
+
+  //
+  // Terminate the package list with an End package.
+  //
+  ZeroMem (&PackageHeader, sizeof (EFI_HII_PACKAGE_HEADER));
+  PackageHeader.Type   = EFI_HII_PACKAGE_END;
+  PackageHeader.Length = sizeof (EFI_HII_PACKAGE_HEADER);
+  CopyMem (Package, &PackageHeader, sizeof (EFI_HII_PACKAGE_HEADER));
+
+  *FormPackageList     = NewPackageList;
+  *FormPackageListSize = FormPackageListLength;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the Form packages of a HII handle.
+
+  The Form packages of the exported package list are kept in a small
+  most-recently-used list, so that entering the same formset again does not
+  export the whole package list from the HII database. At most
+  FORM_PACKAGE_CACHE_MAX_ENTRIES entries are kept, and the least recently
+  used entries are dropped to keep their total size within
+  FORM_PACKAGE_CACHE_MAX_SIZE. The newest entry is kept even if it alone
+  exceeds the size, because the caller uses it. Entries are dropped when a
+  Form package of the handle is added, or when any package of the handle is
+  removed, see FormPackageCacheNotify().
+
+  Package lists without a Form package hold no formset and are not cached.
+  Removing a cached package list always removes its Form package, so the
+  entry is dropped before the handle value can be reused.
+
+  @param  Handle                 The HII handle.
+  @param  PackageList            Returns a package list holding only the Form
+                                 packages. It is owned by the cache and must
+                                 not be freed by the caller.
+
+  @retval EFI_SUCCESS            The package list is returned.
+  @retval EFI_NOT_FOUND          The package list holds no Form package.
+  @retval EFI_OUT_OF_RESOURCES   No enough memory to export the package list.
+  @retval Others                 The package list could not be exported.
+
+**/
+EFI_STATUS
+GetCachedPackageList (
+  IN  EFI_HII_HANDLE                  Handle,
+  OUT EFI_HII_PACKAGE_LIST_HEADER     **PackageList
+  )
+{
+  EFI_STATUS                   Status;
+  LIST_ENTRY                   *Link;
+  FORM_PACKAGE_CACHE           *Entry;
+  EFI_HII_PACKAGE_LIST_HEADER  *HiiPackageList;
+  EFI_HII_PACKAGE_LIST_HEADER  *FormPackageList;
+  UINTN                        BufferSize;
+  UINTN                        FormPackageListSize;
+
+  Link = GetFirstNode (&mFormPackageCacheList);
+  while (!IsNull (&mFormPackageCacheList, Link)) {
+    Entry = FORM_PACKAGE_CACHE_FROM_LINK (Link);
+    if (Entry->HiiHandle == Handle) {
+      //
+      // Move the hit to the head so the tail is the least recently used one.
+      //
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&mFormPackageCacheList, &Entry->Link);
+      *PackageList = Entry->PackageList;
+      return EFI_SUCCESS;
+    }
+    Link = GetNextNode (&mFormPackageCacheList, Link);
+  }
+
+  BufferSize = 0;
+  HiiPackageList = NULL;
+  Status = mHiiDatabase->ExportPackageLists (mHiiDatabase, Handle, &BufferSize, HiiPackageList);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    HiiPackageList = AllocatePool (BufferSize);
+    if (HiiPackageList == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = mHiiDatabase->ExportPackageLists (mHiiDatabase, Handle, &BufferSize, HiiPackageList);
+  }
+  if (EFI_ERROR (Status)) {
+    if (HiiPackageList != NULL) {
+      FreePool (HiiPackageList);
+    }
+    return Status;
+  }
+  ASSERT (HiiPackageList != NULL);
+
+  Status = ExtractFormPackages (HiiPackageList, &FormPackageList, &FormPackageListSize);
+  FreePool (HiiPackageList);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Entry = AllocateZeroPool (sizeof (FORM_PACKAGE_CACHE));
+  if (Entry == NULL) {
+    FreePool (FormPackageList);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Entry->Signature       = FORM_PACKAGE_CACHE_SIGNATURE;
+  Entry->HiiHandle       = Handle;
+  Entry->PackageList     = FormPackageList;
+  Entry->PackageListSize = FormPackageListSize;
+
+  while (!IsListEmpty (&mFormPackageCacheList) &&
+         (mFormPackageCacheCount >= FORM_PACKAGE_CACHE_MAX_ENTRIES ||
+          mFormPackageCacheSize + FormPackageListSize > FORM_PACKAGE_CACHE_MAX_SIZE)) {
+    FreeFormPackageCacheEntry (FORM_PACKAGE_CACHE_FROM_LINK (GetPreviousNode (&mFormPackageCacheList, &mFormPackageCacheList)));
+  }
+  InsertHeadList (&mFormPackageCacheList, &Entry->Link);
+  mFormPackageCacheCount++;
+  mFormPackageCacheSize += FormPackageListSize;
+
+  *PackageList = FormPackageList;
+  return EFI_SUCCESS;
+}
+
 /**
   Fetch the Ifr binary data of a FormSet.
 
@@ -5622,7 +5926,6 @@ GetIfrBinaryData (
 {
   EFI_STATUS                   Status;
   EFI_HII_PACKAGE_LIST_HEADER  *HiiPackageList;
-  UINTN                        BufferSize;
   UINT8                        *Package;
   UINT8                        *OpCodeData;
   UINT32                       Offset;
@@ -5651,19 +5954,10 @@ GetIfrBinaryData (
   //
   // Get HII PackageList
   //
-  BufferSize = 0;
-  HiiPackageList = NULL;
-  Status = mHiiDatabase->ExportPackageLists (mHiiDatabase, Handle, &BufferSize, HiiPackageList);
-  if (Status == EFI_BUFFER_TOO_SMALL) {
-    HiiPackageList = AllocatePool (BufferSize);
-    ASSERT (HiiPackageList != NULL);
-
-    Status = mHiiDatabase->ExportPackageLists (mHiiDatabase, Handle, &BufferSize, HiiPackageList);
-  }
+  Status = GetCachedPackageList (Handle, &HiiPackageList);
   if (EFI_ERROR (Status)) {
     return Status;
   }
-  ASSERT (HiiPackageList != NULL);
 
   //
   // Get Form package from this HII package List
@@ -5733,7 +6027,6 @@ GetIfrBinaryData (
     //
     // Form package not found in this Package List
     //
-    FreePool (HiiPackageList);
     return EFI_NOT_FOUND;
   }
 
@@ -5752,8 +6045,6 @@ GetIfrBinaryData (
   *BinaryLength = PackageHeader.Length - Offset2;
   *BinaryData = AllocateCopyPool (*BinaryLength, OpCodeData);
 
-  FreePool (HiiPackageList);
-
   if (*BinaryData == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
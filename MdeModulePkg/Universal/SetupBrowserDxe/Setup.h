@@ -223,6 +223,18 @@ typedef struct {
 
 #define EXPRESSION_OPCODE_FROM_LINK(a)  CR (a, EXPRESSION_OPCODE, Link, EXPRESSION_OPCODE_SIGNATURE)
 
+//
+// Whether the questions read by an expression are known.
+//
+#define EXPRESSION_DEPENDENCY_UNKNOWN   0  // Not collected yet
+#define EXPRESSION_DEPENDENCY_TRACKED   1  // The result only depends on the values of Dependency
+#define EXPRESSION_DEPENDENCY_VOLATILE  2  // The result may depend on anything, always evaluate it
+
+typedef struct {
+  struct _FORM_BROWSER_STATEMENT *Question;  // Question read by the expression
+  EFI_HII_VALUE                  Value;      // Its value when the expression was last evaluated
+} EXPRESSION_DEPENDENCY;
+
 #define FORM_EXPRESSION_SIGNATURE  SIGNATURE_32 ('F', 'E', 'X', 'P')
 
 typedef struct {
@@ -240,6 +252,11 @@ typedef struct {
   EFI_IFR_OP_HEADER *OpCode;         // Save the opcode buffer.
 
   LIST_ENTRY        OpCodeListHead;  // OpCodes consist of this expression (EXPRESSION_OPCODE)
+
+  UINT8                  DependencyState; // EXPRESSION_DEPENDENCY_xxx
+  BOOLEAN                DependencyValid; // Result matches the question values in Dependency
+  UINTN                  DependencyCount;
+  EXPRESSION_DEPENDENCY  *Dependency;
 } FORM_EXPRESSION;
 
 #define FORM_EXPRESSION_FROM_LINK(a)  CR (a, FORM_EXPRESSION, Link, FORM_EXPRESSION_SIGNATURE)
@@ -552,6 +569,26 @@ typedef struct {
 
 #define BROWSER_CONTEXT_FROM_LINK(a)  CR (a, BROWSER_CONTEXT, Link, BROWSER_CONTEXT_SIGNATURE)
 
+//
+// Maximum number of package lists kept by the browser, and the maximum
+// total size of their Form packages in bytes.
+//
+#define FORM_PACKAGE_CACHE_MAX_ENTRIES  8
+#define FORM_PACKAGE_CACHE_MAX_SIZE     SIZE_1MB
+
+#define FORM_PACKAGE_CACHE_SIGNATURE  SIGNATURE_32 ('F', 'P', 'C', 'H')
+
+typedef struct {
+  UINTN                        Signature;
+  LIST_ENTRY                   Link;
+
+  EFI_HII_HANDLE               HiiHandle;
+  EFI_HII_PACKAGE_LIST_HEADER  *PackageList;
+  UINTN                        PackageListSize;
+} FORM_PACKAGE_CACHE;
+
+#define FORM_PACKAGE_CACHE_FROM_LINK(a)  CR (a, FORM_PACKAGE_CACHE, Link, FORM_PACKAGE_CACHE_SIGNATURE)
+
 //
 // Scope for get defaut value. It may be GetDefaultForNoStorage, GetDefaultForStorage or GetDefaultForAll.
 //
@@ -1066,6 +1103,18 @@ GetIfrBinaryData (
   OUT UINT8            **BinaryData
   );
 
+/**
+  Drop the cached package list of one HII handle, or of all handles.
+
+  @param  Handle                 The HII handle whose package list is dropped.
+                                 NULL to drop all cached package lists.
+
+**/
+VOID
+FlushFormPackageCache (
+  IN EFI_HII_HANDLE    Handle
+  );
+
 /**
   Save globals used by previous call to SendForm(). SendForm() may be called from 
   HiiConfigAccess.Callback(), this will cause SendForm() be reentried.
@@ -82,6 +82,28 @@
 ///
 #define HTTP_HEADER_ACCEPT_RANGES      "Accept-Ranges"
 
+///
+/// Range Request Header
+/// The Range request-header field requests only one or more sub-ranges
+/// of the entity, instead of the entire entity.
+///
+#define HTTP_HEADER_RANGE              "Range"
+
+///
+/// If-Range Request Header
+/// The If-Range request-header field makes a Range request conditional on
+/// an entity tag or a date. If the entity is unchanged, the server sends the
+/// requested sub-range, otherwise it sends the entire new entity.
+///
+#define HTTP_HEADER_IF_RANGE           "If-Range"
+
+///
+/// Content-Range Response Header
+/// The Content-Range entity-header field is sent with a partial entity-body
+/// to specify where in the full entity-body the partial body should be applied.
+///
+#define HTTP_HEADER_CONTENT_RANGE      "Content-Range"
+
 
 /// 
 /// Accept-Encoding Request Header
@@ -228,6 +250,13 @@
 ///
 #define HTTP_HEADER_ETAG              "ETag"
 
+///
+/// Last-Modified Response Header
+/// The Last-Modified entity-header field indicates the date and time at
+/// which the origin server believes the variant was last modified.
+///
+#define HTTP_HEADER_LAST_MODIFIED     "Last-Modified"
+
 ///
 /// Custom header field checked by the iLO web server to
 /// specify a client session key.
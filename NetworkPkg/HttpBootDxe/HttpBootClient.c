@@ -708,8 +708,258 @@ HttpBootGetBootFileCallback (
   return EFI_SUCCESS;
 }
 
+/**
+  Check that the Content-Range of a 206 response covers exactly the bytes
+  from Offset to the end of an entity of ContentLength bytes.
+
+  @param[in]  HeaderCount          Number of HTTP header structures in Headers.
+  @param[in]  Headers              Array containing list of HTTP headers.
+  @param[in]  Offset               The first byte requested.
+  @param[in]  ContentLength        The length of the whole entity.
+
+  @retval TRUE                     The Content-Range matches the request.
+  @retval FALSE                    The Content-Range is missing or doesn't match.
+
+**/
+BOOLEAN
+HttpBootCheckContentRange (
+  IN  UINTN                 HeaderCount,
+  IN  EFI_HTTP_HEADER       *Headers,
+  IN  UINTN                 Offset,
+  IN  UINTN                 ContentLength
+  )
+{
+  EFI_HTTP_HEADER           *Header;
+  CHAR8                     *Char;
+
+  //
+  // Content-Range: bytes <first>-<last>/<length>
+  //
+  Header = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_CONTENT_RANGE);
+  if (Header == NULL || AsciiStrnCmp (Header->FieldValue, "bytes ", 6) != 0) {
+    return FALSE;
+  }
+
+  Char = Header->FieldValue + 6;
+  if (AsciiStrDecimalToUint64 (Char) != Offset) {
+    return FALSE;
+  }
+  Char = AsciiStrStr (Char, "-");
+  if (Char == NULL || AsciiStrDecimalToUint64 (Char + 1) != ContentLength - 1) {
+    return FALSE;
+  }
+  Char = AsciiStrStr (Char, "/");
+  if (Char == NULL) {
+    return FALSE;
+  }
+
+  return (BOOLEAN) (*(Char + 1) == '*' || AsciiStrDecimalToUint64 (Char + 1) == ContentLength);
+}
+
+/**
+  Resume an interrupted download of the boot file with a HTTP Range request.
+
+  The interrupted connection may still hold a part of the old response, so the
+  HttpIo is re-created to start over on a new connection. The remaining bytes
+  from ReceivedSize up to ContentLength are requested with an If-Range
+  validator taken from the ETag or Last-Modified of the original response, and
+  received into Buffer. If the file changed on the server, or the original
+  response has no usable validator, the whole file is downloaded again from
+  offset 0. ReceivedSize is kept up to date so that a failed resume can be
+  resumed again.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Url             The URL of the boot file.
+  @param[in]       HeaderCount     Number of HTTP headers of the original response.
+  @param[in]       Headers         The HTTP headers of the original response.
+  @param[in]       ContentLength   The length of the whole boot file.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[in, out]  ReceivedSize    On input the number of bytes already in Buffer.
+                                   On output the number of bytes in Buffer.
+
+  @retval EFI_SUCCESS              The rest of the file was received.
+  @retval EFI_UNSUPPORTED          The server answered neither with the requested
+                                   range nor with the whole file of the same length.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootResumeBootFile (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     CHAR16                   *Url,
+  IN     UINTN                    HeaderCount,
+  IN     EFI_HTTP_HEADER          *Headers,
+  IN     UINTN                    ContentLength,
+     OUT UINT8                    *Buffer,
+  IN OUT UINTN                    *ReceivedSize
+  )
+{
+  EFI_STATUS                 Status;
+  CHAR8                      *HostName;
+  CHAR8                      Range[48];
+  EFI_HTTP_REQUEST_DATA      RequestData;
+  HTTP_IO_RESPONSE_DATA      ResponseData;
+  HTTP_IO_HEADER             *HttpIoHeader;
+  EFI_HTTP_HEADER            *Validator;
+  EFI_HTTP_HEADER            *Header;
+  BOOLEAN                    RangeValid;
+
+  //
+  // A weak entity tag can't be used in If-Range, fall back to the date.
+  //
+  Validator = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_ETAG);
+  if (Validator != NULL && AsciiStrnCmp (Validator->FieldValue, "W/", 2) == 0) {
+    Validator = NULL;
+  }
+  if (Validator == NULL) {
+    Validator = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_LAST_MODIFIED);
+  }
+  if (Validator == NULL) {
+    *ReceivedSize = 0;
+  }
+
+  DEBUG ((
+    EFI_D_INFO,
+    "HttpBootResumeBootFile: resume download at %Lu of %Lu.\n",
+    (UINT64) *ReceivedSize,
+    (UINT64) ContentLength
+    ));
+
+  if (Private->HttpCreated) {
+    HttpIoDestroyIo (&Private->HttpIo);
+    Private->HttpCreated = FALSE;
+  }
+  Status = HttpBootCreateHttpIo (Private);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Build the same headers as the original request plus the Range and If-Range.
+  //
+  HttpIoHeader = HttpBootCreateHeader (5);
+  if (HttpIoHeader == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  HostName = NULL;
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+  Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_HOST, HostName);
+  FreePool (HostName);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_ACCEPT, "*/*");
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_USER_AGENT, HTTP_USER_AGENT_EFI_HTTP_BOOT);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  if (*ReceivedSize != 0) {
+    AsciiSPrint (Range, sizeof (Range), "bytes=%Lu-%Lu", (UINT64) *ReceivedSize, (UINT64) (ContentLength - 1));
+    Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_RANGE, Range);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_IF_RANGE, Validator->FieldValue);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+  }
+
+  RequestData.Method = HttpMethodGet;
+  RequestData.Url    = Url;
+  Status = HttpIoSendRequest (
+             &Private->HttpIo,
+             &RequestData,
+             HttpIoHeader->HeaderCount,
+             HttpIoHeader->Headers,
+             0,
+             NULL
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  //
+  // A 206 response carries the requested range of the unchanged file. A 200
+  // response carries the whole file, either because it has changed or because
+  // the server ignored the Range, so the download starts over from offset 0.
+  //
+  ZeroMem (&ResponseData, sizeof (HTTP_IO_RESPONSE_DATA));
+  Status = HttpIoRecvResponse (&Private->HttpIo, TRUE, &ResponseData);
+  if (!EFI_ERROR (Status) && EFI_ERROR (ResponseData.Status)) {
+    Status = ResponseData.Status;
+  }
+  RangeValid = FALSE;
+  if (!EFI_ERROR (Status)) {
+    if (ResponseData.Response.StatusCode == HTTP_STATUS_206_PARTIAL_CONTENT) {
+      RangeValid = (BOOLEAN) (*ReceivedSize != 0 &&
+                              HttpBootCheckContentRange (ResponseData.HeaderCount, ResponseData.Headers, *ReceivedSize, ContentLength));
+    } else if (ResponseData.Response.StatusCode == HTTP_STATUS_200_OK) {
+      //
+      // The caller's buffer holds the file of the original length only.
+      //
+      Header = HttpFindHeader (ResponseData.HeaderCount, ResponseData.Headers, HTTP_HEADER_CONTENT_LENGTH);
+      if (Header != NULL && AsciiStrDecimalToUintn (Header->FieldValue) == ContentLength) {
+        if (*ReceivedSize != 0) {
+          DEBUG ((EFI_D_WARN, "HttpBootResumeBootFile: the file has changed, download it again.\n"));
+        }
+        *ReceivedSize = 0;
+        RangeValid    = TRUE;
+      }
+    }
+  }
+  if (ResponseData.Headers != NULL) {
+    HttpFreeHeaderFields (ResponseData.Headers, ResponseData.HeaderCount);
+  }
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+  if (!RangeValid) {
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+
+  while (*ReceivedSize < ContentLength) {
+    ZeroMem (&ResponseData, sizeof (HTTP_IO_RESPONSE_DATA));
+    ResponseData.Body       = (CHAR8*) Buffer + *ReceivedSize;
+    ResponseData.BodyLength = ContentLength - *ReceivedSize;
+    Status = HttpIoRecvResponse (&Private->HttpIo, FALSE, &ResponseData);
+    if (!EFI_ERROR (Status) && EFI_ERROR (ResponseData.Status)) {
+      Status = ResponseData.Status;
+    }
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+    *ReceivedSize += ResponseData.BodyLength;
+  }
+
+ON_EXIT:
+  HttpBootFreeHeader (HttpIoHeader);
+  return Status;
+}
+
 /**
   This function download the boot file by using UEFI HTTP protocol.
+
+  A download in identity transfer-coding into a caller provided buffer that is
+  interrupted is resumed with HTTP Range requests up to HTTP_BOOT_RESUME_RETRY
+  times, rather than failing the whole transfer.
   
   @param[in]       Private         The pointer to the driver's private data.
   @param[in]       HeaderOnly      Only request the response header, it could save a lot of time if
@@ -758,6 +1008,7 @@ HttpBootGetBootFile (
   CHAR16                     *Url;
   BOOLEAN                    IdentityMode;
   UINTN                      ReceivedSize;
+  UINTN                      RetryCount;
   
   ASSERT (Private != NULL);
   ASSERT (Private->HttpCreated);
@@ -1011,7 +1262,30 @@ HttpBootGetBootFile (
           if (EFI_ERROR (ResponseBody.Status)) {
             Status = ResponseBody.Status;
           }
-          goto ERROR_6;
+
+          //
+          // Resume the interrupted download from where it stopped if
+          // the whole file fits in the caller's buffer.
+          //
+          RetryCount = 0;
+          while (EFI_ERROR (Status) && (Status != EFI_UNSUPPORTED) &&
+                 (Buffer != NULL) && (*BufferSize >= ContentLength) &&
+                 (RetryCount < HTTP_BOOT_RESUME_RETRY)) {
+            RetryCount++;
+            Status = HttpBootResumeBootFile (
+                       Private,
+                       Url,
+                       ResponseData->HeaderCount,
+                       ResponseData->Headers,
+                       ContentLength,
+                       Buffer,
+                       &ReceivedSize
+                       );
+          }
+          if (EFI_ERROR (Status)) {
+            goto ERROR_6;
+          }
+          break;
         }
         ReceivedSize += ResponseBody.BodyLength;
       }
@@ -901,6 +901,12 @@ HttpResponseWorker (
   ValueInItem               = NULL;
  
   if (HttpMsg->Data.Response != NULL) {
+    //
+    // A new response starts, reset the body statistics.
+    //
+    HttpInstance->BodyDirectBytes = 0;
+    HttpInstance->BodyCopiedBytes = 0;
+
     //
     // Need receive the HTTP headers, prepare buffer.
     //
@@ -917,7 +923,10 @@ HttpResponseWorker (
       // The data is stored at [NextMsg, CacheBody + CacheLen].
       //
       HdrLen = HttpInstance->CacheBody + HttpInstance->CacheLen - HttpInstance->NextMsg;
-      HttpHeaders = AllocateZeroPool (HdrLen);
+      //
+      // Keep a NULL terminator for the header search below.
+      //
+      HttpHeaders = AllocateZeroPool (HdrLen + 1);
       if (HttpHeaders == NULL) {
         Status = EFI_OUT_OF_RESOURCES;
         goto Error;
@@ -929,7 +938,7 @@ HttpResponseWorker (
       HttpInstance->NextMsg     = NULL;
       HttpInstance->CacheOffset = 0;
       SizeofHeaders = HdrLen;
-      BufferSize = HttpInstance->CacheLen;
+      BufferSize = HdrLen;
 
       //
       // Check whether we cached the whole HTTP headers.
@@ -1160,6 +1169,7 @@ HttpResponseWorker (
       if (HttpMsg->BodyLength < BodyLen) {
         CopyMem (HttpMsg->Body, HttpInstance->CacheBody + HttpInstance->CacheOffset, HttpMsg->BodyLength);
         HttpInstance->CacheOffset = HttpInstance->CacheOffset + HttpMsg->BodyLength;
+        HttpInstance->BodyCopiedBytes += HttpMsg->BodyLength;
       } else {
         //
         // Copy all cached data out.
@@ -1167,6 +1177,7 @@ HttpResponseWorker (
         CopyMem (HttpMsg->Body, HttpInstance->CacheBody + HttpInstance->CacheOffset, BodyLen);
         HttpInstance->CacheOffset = BodyLen + HttpInstance->CacheOffset;
         HttpMsg->BodyLength = BodyLen;
+        HttpInstance->BodyCopiedBytes += BodyLen;
 
         if (HttpInstance->NextMsg == NULL) {
           //
@@ -137,6 +137,7 @@ HttpTcpReceiveNotifyDpc (
   EFI_STATUS               Status;
   HTTP_PROTOCOL            *HttpInstance;
   BOOLEAN                  UsingIpv6;
+  BOOLEAN                  MsgComplete;
 
   if (Context == NULL) {
     return ;
@@ -206,7 +207,8 @@ HttpTcpReceiveNotifyDpc (
     return ;
   }
 
-  if (HttpIsMessageComplete (HttpInstance->MsgParser)) {
+  MsgComplete = HttpIsMessageComplete (HttpInstance->MsgParser);
+  if (MsgComplete) {
     //
     // Free the MsgParse since we already have a full HTTP message.
     //
@@ -234,6 +236,16 @@ HttpTcpReceiveNotifyDpc (
     }
   }
 
+  HttpInstance->BodyDirectBytes += Wrap->HttpToken->Message->BodyLength;
+  if (MsgComplete) {
+    DEBUG ((
+      EFI_D_INFO,
+      "HttpTcpReceiveNotifyDpc: body complete, %ld bytes received in place, %ld bytes copied.\n",
+      HttpInstance->BodyDirectBytes,
+      HttpInstance->BodyCopiedBytes
+      ));
+  }
+
   Item = NetMapFindKey (&Wrap->HttpInstance->RxTokens, Wrap->HttpToken);
   if (Item != NULL) {
     NetMapRemoveItem (&Wrap->HttpInstance->RxTokens, Item, NULL);
@@ -1562,6 +1574,49 @@ HttpTcpReceive (
   return HttpResponseWorker ((HTTP_TOKEN_WRAP *) Item->Value);
 }
 
+/**
+  Make sure the buffer of the HTTP headers has room for one more receive of
+  DEF_BUF_LEN bytes plus a NULL terminator. The buffer grows geometrically so
+  that the headers received so far are not copied on every receive.
+
+  @param[in, out]  HttpHeaders      The buffer of the HTTP headers.
+  @param[in]       SizeofHeaders    The number of bytes in the buffer.
+  @param[in, out]  Capacity         The size of the buffer.
+
+  @retval EFI_SUCCESS               The buffer is large enough.
+  @retval EFI_OUT_OF_RESOURCES      Failed to grow the buffer.
+
+**/
+EFI_STATUS
+HttpGrowHeaderBuffer (
+  IN OUT CHAR8              **HttpHeaders,
+  IN     UINTN              SizeofHeaders,
+  IN OUT UINTN              *Capacity
+  )
+{
+  CHAR8                     *Buffer;
+  UINTN                     NewCapacity;
+
+  if ((*HttpHeaders != NULL) && (*Capacity - SizeofHeaders > DEF_BUF_LEN)) {
+    return EFI_SUCCESS;
+  }
+
+  NewCapacity = MAX (*Capacity * 2, SizeofHeaders + DEF_BUF_LEN + 1);
+  Buffer      = AllocateZeroPool (NewCapacity);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (*HttpHeaders != NULL) {
+    CopyMem (Buffer, *HttpHeaders, SizeofHeaders);
+    FreePool (*HttpHeaders);
+  }
+
+  *HttpHeaders = Buffer;
+  *Capacity    = NewCapacity;
+  return EFI_SUCCESS;
+}
+
 /**
   Receive the HTTP header by processing the associated HTTP token.
 
@@ -1589,7 +1644,8 @@ HttpTcpReceiveHeader (
   EFI_TCP6_PROTOCOL             *Tcp6;
   CHAR8                         **EndofHeader;
   CHAR8                         **HttpHeaders;
-  CHAR8                         *Buffer;
+  UINTN                         Capacity;
+  UINTN                         SearchStart;
 
   ASSERT (HttpInstance != NULL);
 
@@ -1597,9 +1653,14 @@ HttpTcpReceiveHeader (
   HttpHeaders = HttpInstance->HttpHeaders;
   Tcp4 = HttpInstance->Tcp4;
   Tcp6 = HttpInstance->Tcp6;
-  Buffer      = NULL;
   Rx4Token    = NULL;
   Rx6Token    = NULL;
+
+  //
+  // The size of a buffer handed in by the caller is not known, the first
+  // receive always reallocates it.
+  //
+  Capacity    = *SizeofHeaders;
   
   if (HttpInstance->LocalAddressIsIPv6) {
     ASSERT (Tcp6 != NULL);
@@ -1609,23 +1670,25 @@ HttpTcpReceiveHeader (
 
   if (!HttpInstance->LocalAddressIsIPv6) {
     Rx4Token = &HttpInstance->Rx4Token;
-    Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer = AllocateZeroPool (DEF_BUF_LEN);
-    if (Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      return Status;
-    }
   
     //
     // Receive the HTTP headers only when EFI_HTTP_RESPONSE_DATA is not NULL.
+    // Every receive is done directly at the end of the headers buffer.
     //
     while (*EndofHeader == NULL) {   
+      Status = HttpGrowHeaderBuffer (HttpHeaders, *SizeofHeaders, &Capacity);
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
       HttpInstance->IsRxDone = FALSE;
       Rx4Token->Packet.RxData->DataLength = DEF_BUF_LEN;
       Rx4Token->Packet.RxData->FragmentTable[0].FragmentLength = DEF_BUF_LEN;
+      Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer = *HttpHeaders + *SizeofHeaders;
       Status = Tcp4->Receive (Tcp4, Rx4Token);
       if (EFI_ERROR (Status)) {
         DEBUG ((EFI_D_ERROR, "Tcp4 receive failed: %r\n", Status));
-        return Status;
+        goto ON_EXIT;
       }
       
       while (!HttpInstance->IsRxDone && ((Timeout == NULL) || EFI_ERROR (gBS->CheckEvent (Timeout)))) {
@@ -1643,59 +1706,46 @@ HttpTcpReceiveHeader (
   
       Status = Rx4Token->CompletionToken.Status;
       if (EFI_ERROR (Status)) {
-        return Status;
+        goto ON_EXIT;
       }
   
       //
       // Append the response string.
       //
-      *BufferSize = (*SizeofHeaders) + Rx4Token->Packet.RxData->FragmentTable[0].FragmentLength;
-      Buffer      = AllocateZeroPool (*BufferSize);
-      if (Buffer == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-        return Status;
-      }
-  
-      if (*HttpHeaders != NULL) {
-        CopyMem (Buffer, *HttpHeaders, (*SizeofHeaders));
-        FreePool (*HttpHeaders);
-      }
-  
-      CopyMem (
-        Buffer + (*SizeofHeaders),
-        Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer,
-        Rx4Token->Packet.RxData->FragmentTable[0].FragmentLength
-        );
-      *HttpHeaders    = Buffer;
-      *SizeofHeaders  = *BufferSize;
+      SearchStart     = *SizeofHeaders;
+      *SizeofHeaders += Rx4Token->Packet.RxData->FragmentTable[0].FragmentLength;
+      *BufferSize     = *SizeofHeaders;
+      (*HttpHeaders)[*SizeofHeaders] = '\0';
   
       //
-      // Check whether we received end of HTTP headers.
+      // Check whether we received end of HTTP headers. Only the new data and
+      // the tail that may hold a partial terminator need to be searched.
       //
-      *EndofHeader = AsciiStrStr (*HttpHeaders, HTTP_END_OF_HDR_STR); 
+      SearchStart  = (SearchStart > AsciiStrLen (HTTP_END_OF_HDR_STR)) ? SearchStart - AsciiStrLen (HTTP_END_OF_HDR_STR) : 0;
+      *EndofHeader = AsciiStrStr (*HttpHeaders + SearchStart, HTTP_END_OF_HDR_STR); 
     }
-    FreePool (Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer);
-    Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer = NULL;
     
   } else {
     Rx6Token = &HttpInstance->Rx6Token;
-    Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer = AllocateZeroPool (DEF_BUF_LEN);
-    if (Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      return Status;
-    }
   
     //
     // Receive the HTTP headers only when EFI_HTTP_RESPONSE_DATA is not NULL.
+    // Every receive is done directly at the end of the headers buffer.
     //
     while (*EndofHeader == NULL) {   
+      Status = HttpGrowHeaderBuffer (HttpHeaders, *SizeofHeaders, &Capacity);
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
       HttpInstance->IsRxDone = FALSE;
       Rx6Token->Packet.RxData->DataLength = DEF_BUF_LEN;
       Rx6Token->Packet.RxData->FragmentTable[0].FragmentLength = DEF_BUF_LEN;
+      Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer = *HttpHeaders + *SizeofHeaders;
       Status = Tcp6->Receive (Tcp6, Rx6Token);
       if (EFI_ERROR (Status)) {
         DEBUG ((EFI_D_ERROR, "Tcp6 receive failed: %r\n", Status));
-        return Status;
+        goto ON_EXIT;
       }
       
       while (!HttpInstance->IsRxDone && ((Timeout == NULL) || EFI_ERROR (gBS->CheckEvent (Timeout)))) {
@@ -1713,48 +1763,46 @@ HttpTcpReceiveHeader (
   
       Status = Rx6Token->CompletionToken.Status;
       if (EFI_ERROR (Status)) {
-        return Status;
+        goto ON_EXIT;
       }
   
       //
       // Append the response string.
       //
-      *BufferSize = (*SizeofHeaders) + Rx6Token->Packet.RxData->FragmentTable[0].FragmentLength;
-      Buffer      = AllocateZeroPool (*BufferSize);
-      if (Buffer == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-        return Status;
-      }
-  
-      if (*HttpHeaders != NULL) {
-        CopyMem (Buffer, *HttpHeaders, (*SizeofHeaders));
-        FreePool (*HttpHeaders);
-      }
-  
-      CopyMem (
-        Buffer + (*SizeofHeaders),
-        Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer,
-        Rx6Token->Packet.RxData->FragmentTable[0].FragmentLength
-        );
-      *HttpHeaders     = Buffer;
-      *SizeofHeaders  = *BufferSize;
+      SearchStart     = *SizeofHeaders;
+      *SizeofHeaders += Rx6Token->Packet.RxData->FragmentTable[0].FragmentLength;
+      *BufferSize     = *SizeofHeaders;
+      (*HttpHeaders)[*SizeofHeaders] = '\0';
   
       //
-      // Check whether we received end of HTTP headers.
+      // Check whether we received end of HTTP headers. Only the new data and
+      // the tail that may hold a partial terminator need to be searched.
       //
-      *EndofHeader = AsciiStrStr (*HttpHeaders, HTTP_END_OF_HDR_STR);
+      SearchStart  = (SearchStart > AsciiStrLen (HTTP_END_OF_HDR_STR)) ? SearchStart - AsciiStrLen (HTTP_END_OF_HDR_STR) : 0;
+      *EndofHeader = AsciiStrStr (*HttpHeaders + SearchStart, HTTP_END_OF_HDR_STR);
   
     }
-    FreePool (Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer);
-    Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer = NULL;    
   }     
 
   //
   // Skip the CRLF after the HTTP headers.
   //
   *EndofHeader = *EndofHeader + AsciiStrLen (HTTP_END_OF_HDR_STR);  
+  Status       = EFI_SUCCESS;
 
-  return EFI_SUCCESS;
+ON_EXIT:
+  //
+  // The fragment buffer points into the headers buffer, it must not be
+  // freed with the token.
+  //
+  if (Rx4Token != NULL) {
+    Rx4Token->Packet.RxData->FragmentTable[0].FragmentBuffer = NULL;
+  }
+  if (Rx6Token != NULL) {
+    Rx6Token->Packet.RxData->FragmentTable[0].FragmentBuffer = NULL;
+  }
+
+  return Status;
 }
 
 /**
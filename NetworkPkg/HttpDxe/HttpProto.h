@@ -137,6 +137,13 @@ typedef struct _HTTP_PROTOCOL {
   UINTN                         CacheLen;
   UINTN                         CacheOffset;
 
+  //
+  // Bytes of the current response body received by TCP directly into the
+  // caller's buffer, and bytes copied to it from CacheBody.
+  //
+  UINT64                        BodyDirectBytes;
+  UINT64                        BodyCopiedBytes;
+
   //
   // HTTP message-body parser.
   //
@@ -56,15 +56,56 @@ Mtftp6RrqSendAck (
   Ack->Ack.Block[0]  = HTONS (BlockNum);
 
   //
-  // Reset current retry count of the instance.
+  // Reset current retry count of the instance. Every ACK opens a new
+  // window at the server.
   //
-  Instance->CurRetry = 0;
+  Instance->CurRetry   = 0;
   Instance->LastPacket = Packet;
+  Instance->WindowBlk  = 0;
 
   return Mtftp6TransmitPacket (Instance, Packet);
 }
 
 
+/**
+  Retransmit on a time out of a download with a window negotiated.
+
+  The last packet sent is the ACK of an earlier window boundary, which would
+  make the server resend a window of blocks mostly received already. ACK the
+  last in-order block instead, so that the server starts a new window at the
+  first missing block. The retry count of the time out is kept.
+
+  @param[in]  Instance              The pointer to the Mtftp6 instance.
+
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for the packet.
+  @retval EFI_SUCCESS           The ACK has been sent.
+  @retval Others                Failed to send the ACK.
+
+**/
+EFI_STATUS
+Mtftp6RrqRetransmit (
+  IN MTFTP6_INSTANCE        *Instance
+  )
+{
+  EFI_STATUS                Status;
+  INTN                      Expected;
+  UINT32                    Retry;
+
+  Expected = Mtftp6GetNextBlockNum (&Instance->BlkList);
+  if (Expected < 0) {
+    Instance->WindowBlk = 0;
+    return Mtftp6TransmitPacket (Instance, Instance->LastPacket);
+  }
+
+  Retry              = Instance->CurRetry;
+  Instance->GapAcked = FALSE;
+  Status             = Mtftp6RrqSendAck (Instance, (UINT16) (Expected - 1));
+  Instance->CurRetry = Retry;
+
+  return Status;
+}
+
+
 /**
   Deliver the received data block to the user, which can be saved
   in the user provide buffer or through the CheckPacket callback.
@@ -242,6 +283,23 @@ Mtftp6RrqHandleData (
     NetbufFree (*UdpPacket);
     *UdpPacket = NULL;
 
+    if (Instance->WindowSize > 1) {
+      //
+      // When a window is negotiated, an old block is a duplicate from
+      // a window already ACKed, drop it silently. A gap means some block
+      // in the window is lost: ACK the last in-order block once so that
+      // the server restarts the window from there, and ignore the rest
+      // of the broken window. Neither is counted into the new window. If
+      // the ACK is lost, the time out ACKs the last in-order block again.
+      //
+      if ((BlockNum < Expected) || Instance->GapAcked) {
+        return EFI_SUCCESS;
+      }
+
+      Instance->GapAcked = TRUE;
+      return Mtftp6RrqSendAck (Instance, (UINT16) (Expected - 1));
+    }
+
     Mtftp6TransmitPacket (Instance, Instance->LastPacket);
     return EFI_SUCCESS;
   }
@@ -266,6 +324,8 @@ Mtftp6RrqHandleData (
   // to tell the server that we are done.
   //
   Expected = Mtftp6GetNextBlockNum (&Instance->BlkList);
+  Instance->WindowBlk++;
+  Instance->GapAcked = FALSE;
 
   if (Instance->IsMaster || Expected < 0) {
     if (Expected < 0) {
@@ -280,6 +340,14 @@ Mtftp6RrqHandleData (
 
     } else {
       BlockNum     = (UINT16) (Expected - 1);
+
+      //
+      // Only ACK at the window boundary, the server keeps sending
+      // the rest of the window without waiting for us.
+      //
+      if (Instance->WindowBlk < Instance->WindowSize) {
+        return EFI_SUCCESS;
+      }
     }
     //
     // Free the received packet before send new packet in ReceiveNotify,
@@ -301,7 +369,8 @@ Mtftp6RrqHandleData (
   1. The server doesn't include options not requested by us.
   2. The server can only use smaller blksize than that is requested.
   3. The server can only use the same timeout as requested.
-  4. The server doesn't change its multicast channel.
+  4. The server can only use smaller windowsize than that is requested.
+  5. The server doesn't change its multicast channel.
 
   @param[in]  Instance              The pointer to the Mtftp6 instance.
   @param[in]  ReplyInfo             The pointer to options information in reply packet.
@@ -330,7 +399,8 @@ Mtftp6RrqOackValid (
   // return the timeout matches that requested.
   //
   if ((((ReplyInfo->BitMap & MTFTP6_OPT_BLKSIZE_BIT) != 0) && (ReplyInfo->BlkSize > RequestInfo->BlkSize)) ||
-      (((ReplyInfo->BitMap & MTFTP6_OPT_TIMEOUT_BIT) != 0) && (ReplyInfo->Timeout != RequestInfo->Timeout))
+      (((ReplyInfo->BitMap & MTFTP6_OPT_TIMEOUT_BIT) != 0) && (ReplyInfo->Timeout != RequestInfo->Timeout)) ||
+      (((ReplyInfo->BitMap & MTFTP6_OPT_WINDOWSIZE_BIT) != 0) && (ReplyInfo->WindowSize > RequestInfo->WindowSize))
       ) {
     return FALSE;
   }
@@ -628,6 +698,14 @@ Mtftp6RrqHandleOack (
     if (ExtInfo.Timeout != 0) {
       Instance->Timeout = ExtInfo.Timeout;
     }
+
+    //
+    // Servers that don't know the windowsize option leave it out of
+    // the OACK, then the transfer stays in lockstep.
+    //
+    if (ExtInfo.WindowSize != 0) {
+      Instance->WindowSize = ExtInfo.WindowSize;
+    }
   }
 
   //
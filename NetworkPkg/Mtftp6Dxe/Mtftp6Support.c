@@ -980,6 +980,9 @@ Mtftp6OperationClean (
   Instance->McastPort      = 0;
   Instance->BlkSize        = 0;
   Instance->LastBlk        = 0;
+  Instance->WindowSize     = 0;
+  Instance->WindowBlk      = 0;
+  Instance->GapAcked       = FALSE;
   Instance->PacketToLive   = 0;
   Instance->MaxRetry       = 0;
   Instance->CurRetry       = 0;
@@ -1066,6 +1069,15 @@ Mtftp6OperationStart (
     if (EFI_ERROR (Status)) {
       goto ON_ERROR;
     }
+
+    //
+    // The upload path sends one block per ACK, so don't let the
+    // server expect a window of blocks from us.
+    //
+    if (OpCode == EFI_MTFTP6_OPCODE_WRQ && (Instance->ExtInfo.BitMap & MTFTP6_OPT_WINDOWSIZE_BIT) != 0) {
+      Status = EFI_UNSUPPORTED;
+      goto ON_ERROR;
+    }
   }
 
   //
@@ -1105,6 +1117,9 @@ Mtftp6OperationStart (
   if (Instance->BlkSize == 0) {
     Instance->BlkSize = MTFTP6_DEFAULT_BLK_SIZE;
   }
+  if (Instance->WindowSize == 0) {
+    Instance->WindowSize = MTFTP6_DEFAULT_WINDOW_SIZE;
+  }
   if (Instance->MaxRetry == 0) {
     Instance->MaxRetry = MTFTP6_DEFAULT_MAX_RETRY;
   }
@@ -1227,7 +1242,19 @@ Mtftp6OnTimerTick (
     // otherwise exit the transfer.
     //
     if (Instance->CurRetry < Instance->MaxRetry) {
-      Mtftp6TransmitPacket (Instance, Instance->LastPacket);
+      //
+      // A window is only negotiated by a download. ACK the last in-order
+      // block there rather than the last window boundary.
+      //
+      if ((Instance->WindowSize > 1) && Instance->IsMaster) {
+        Mtftp6RrqRetransmit (Instance);
+      } else {
+        //
+        // The retransmitted ACK opens a new window at the server.
+        //
+        Instance->WindowBlk = 0;
+        Mtftp6TransmitPacket (Instance, Instance->LastPacket);
+      }
     } else {
       Mtftp6OperationClean (Instance, EFI_TIMEOUT);
       continue;
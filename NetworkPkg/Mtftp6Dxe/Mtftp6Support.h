@@ -356,4 +356,25 @@ Mtftp6RrqStart (
   IN UINT16                 Operation
   );
 
+
+/**
+  Retransmit on a time out of a download with a window negotiated.
+
+  The last packet sent is the ACK of an earlier window boundary, which would
+  make the server resend a window of blocks mostly received already. ACK the
+  last in-order block instead, so that the server starts a new window at the
+  first missing block. The retry count of the time out is kept.
+
+  @param[in]  Instance              The pointer to the Mtftp6 instance.
+
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for the packet.
+  @retval EFI_SUCCESS           The ACK has been sent.
+  @retval Others                Failed to send the ACK.
+
+**/
+EFI_STATUS
+Mtftp6RrqRetransmit (
+  IN MTFTP6_INSTANCE        *Instance
+  );
+
 #endif
@@ -35,9 +35,140 @@ TcpSeqAcceptable (
           TCP_SEQ_LT (Seg->Seq, Tcb->RcvWl2 + Tcb->RcvWnd));
 }
 
+/**
+  Merge the SACK blocks reported by the peer into the scoreboard, and drop
+  the parts of the scoreboard that are cumulatively acknowledged.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Option   Pointer to the options of the incoming segment.
+  @param[in]       Ack      The acknowledge sequence number of the segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_OPTION *Option,
+  IN     TCP_SEQNO  Ack
+  )
+{
+  TCP_SACK_BLOCK  Block[TCP_SACK_BLOCK_MAX * 2];
+  TCP_SACK_BLOCK  Swap;
+  UINT8           Count;
+  UINT8           Index;
+  UINT8           Cur;
+
+  Count = 0;
+
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    Block[Count++] = Tcb->SackBlock[Index];
+  }
+
+  if (TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+    for (Index = 0; Index < Option->SackCount; Index++) {
+      //
+      // Ignore the blocks that are not within the data sent out.
+      //
+      if (TCP_SEQ_GEQ (Option->Sack[Index].Left, Option->Sack[Index].Right) ||
+          TCP_SEQ_GT (Option->Sack[Index].Right, Tcb->SndNxt)) {
+        continue;
+      }
+
+      Block[Count++] = Option->Sack[Index];
+    }
+  }
+
+  //
+  // Sort the blocks by the left edge. There are at most
+  // 2 * TCP_SACK_BLOCK_MAX of them.
+  //
+  for (Index = 1; Index < Count; Index++) {
+    for (Cur = Index; (Cur > 0) && TCP_SEQ_LT (Block[Cur].Left, Block[Cur - 1].Left); Cur--) {
+      Swap           = Block[Cur];
+      Block[Cur]     = Block[Cur - 1];
+      Block[Cur - 1] = Swap;
+    }
+  }
+
+  //
+  // Trim the blocks against Ack and merge the overlapped ones. The lowest
+  // blocks are kept, they describe the holes to be retransmitted first.
+  //
+  Tcb->SackCount = 0;
+
+  for (Index = 0; Index < Count; Index++) {
+    if (TCP_SEQ_LEQ (Block[Index].Right, Ack)) {
+      continue;
+    }
+
+    if (TCP_SEQ_LT (Block[Index].Left, Ack)) {
+      Block[Index].Left = Ack;
+    }
+
+    Cur = Tcb->SackCount;
+    if ((Cur != 0) && TCP_SEQ_LEQ (Block[Index].Left, Tcb->SackBlock[Cur - 1].Right)) {
+      if (TCP_SEQ_GT (Block[Index].Right, Tcb->SackBlock[Cur - 1].Right)) {
+        Tcb->SackBlock[Cur - 1].Right = Block[Index].Right;
+      }
+
+      continue;
+    }
+
+    if (Cur == TCP_SACK_BLOCK_MAX) {
+      break;
+    }
+
+    Tcb->SackBlock[Cur] = Block[Index];
+    Tcb->SackCount++;
+  }
+}
+
+/**
+  Find the first hole in the scoreboard at or above sequence From. A hole
+  is the data not SACKed by the peer below the highest SACKed sequence.
+
+  @param[in]   Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]   From     The sequence number to start the search.
+  @param[out]  Seq      The first sequence number of the hole.
+  @param[out]  Len      The length of the hole.
+
+  @retval TRUE          A hole is found.
+  @retval FALSE         No hole is found.
+
+**/
+BOOLEAN
+TcpSackNextHole (
+  IN     TCP_CB    *Tcb,
+  IN     TCP_SEQNO From,
+     OUT TCP_SEQNO *Seq,
+     OUT UINT32    *Len
+  )
+{
+  UINT8  Index;
+
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    if (TCP_SEQ_LEQ (Tcb->SackBlock[Index].Right, From)) {
+      continue;
+    }
+
+    if (TCP_SEQ_LT (From, Tcb->SackBlock[Index].Left)) {
+      *Seq = From;
+      *Len = TCP_SUB_SEQ (Tcb->SackBlock[Index].Left, From);
+      return TRUE;
+    }
+
+    From = Tcb->SackBlock[Index].Right;
+  }
+
+  return FALSE;
+}
+
 /**
   NewReno fast recovery defined in RFC3782.
 
+  If the peer supports SACK, every duplicated ACK during the recovery
+  retransmits the next hole reported by the scoreboard as well, instead of
+  waiting for one partial ACK per lost segment.
+
   @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
   @param[in]       Seg      Segment that triggers the fast recovery.
 
@@ -48,8 +179,10 @@ TcpFastRecover (
   IN     TCP_SEG *Seg
   )
 {
-  UINT32  FlightSize;
-  UINT32  Acked;
+  UINT32    FlightSize;
+  UINT32    Acked;
+  TCP_SEQNO Seq;
+  UINT32    Len;
 
   //
   // Step 1: Three duplicate ACKs and not in fast recovery
@@ -71,7 +204,8 @@ TcpFastRecover (
     // Step 2: Entering fast retransmission
     //
     TcpRetransmit (Tcb, Tcb->SndUna);
-    Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->CWnd       = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->SackRexmit = Tcb->SndUna + Tcb->SndMss;
 
     DEBUG (
       (EFI_D_INFO,
@@ -95,7 +229,19 @@ TcpFastRecover (
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
-    Tcb->CWnd += Tcb->SndMss;
+    // With SACK, spend the ACK on the next hole instead if
+    // there is one, rather than on new data.
+    //
+    if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK) &&
+        TcpSackNextHole (Tcb, Tcb->SackRexmit, &Seq, &Len)
+        ) {
+
+      TcpRetransmit (Tcb, Seq);
+      Tcb->SackRexmit = Seq + MIN (Len, Tcb->SndMss);
+    } else {
+
+      Tcb->CWnd += Tcb->SndMss;
+    }
     DEBUG (
       (EFI_D_INFO,
       "TcpFastRecover: received another duplicated ACK (%d) for TCB %p\n",
@@ -135,6 +281,9 @@ TcpFastRecover (
       // , then deflate the CWnd
       //
       TcpRetransmit (Tcb, Seg->Ack);
+      if (TCP_SEQ_LT (Tcb->SackRexmit, Seg->Ack + Tcb->SndMss)) {
+        Tcb->SackRexmit = Seg->Ack + Tcb->SndMss;
+      }
       Acked = TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna);
 
       //
@@ -581,6 +730,11 @@ TcpQueueData (
   Seg   = TCPSEG_NETBUF (Nbuf);
   Head  = &Tcb->RcvQue;
 
+  //
+  // The first SACK block reported must hold the latest segment.
+  //
+  Tcb->SackRcvSeq = Seg->Seq;
+
   //
   // Fast path to process normal case. That is,
   // no out-of-order segments are received.
@@ -1210,6 +1364,13 @@ TcpInput (
     TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
   }
 
+  //
+  // Update the SACK scoreboard before the recovery consults it.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)) {
+    TcpSackUpdate (Tcb, &Option, Seg->Ack);
+  }
+
   //
   // Count duplicate acks.
   //
@@ -68,6 +68,104 @@ TcpPutUint32 (
   CopyMem (Buf, &Data, sizeof (UINT32));
 }
 
+/**
+  Get the next block of out-of-order data in the reassemble queue.
+
+  @param[in]       Tcb        Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Entry      On input, the queue entry to start from. On output,
+                              the queue entry following the block.
+  @param[out]      Block      Pointer to the block.
+
+  @retval TRUE                A block is returned.
+  @retval FALSE               There is no more out-of-order data.
+
+**/
+BOOLEAN
+TcpSackNextBlock (
+  IN     TCP_CB         *Tcb,
+  IN OUT LIST_ENTRY     **Entry,
+     OUT TCP_SACK_BLOCK *Block
+  )
+{
+  NET_BUF     *Node;
+  TCP_SEG     *Seg;
+  BOOLEAN     Found;
+
+  Found = FALSE;
+
+  for (; *Entry != &Tcb->RcvQue; *Entry = (*Entry)->ForwardLink) {
+    Node = NET_LIST_USER_STRUCT (*Entry, NET_BUF, List);
+    Seg  = TCPSEG_NETBUF (Node);
+
+    if (TCP_SEQ_LEQ (Seg->Seq, Tcb->RcvNxt)) {
+      continue;
+    }
+
+    //
+    // The reassemble queue is sorted and does not overlap, merge the
+    // adjacent segments into one block.
+    //
+    if (!Found) {
+      Block->Left  = Seg->Seq;
+      Block->Right = Seg->End;
+      Found        = TRUE;
+    } else if (Block->Right == Seg->Seq) {
+      Block->Right = Seg->End;
+    } else {
+      break;
+    }
+  }
+
+  return Found;
+}
+
+/**
+  Collect the out-of-order data in the reassemble queue as SACK blocks.
+
+  As RFC2018 section 4 requires, the first block holds the most recently
+  received segment. The other blocks follow in sequence order.
+
+  @param[in]   Tcb        Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Block      Pointer to the array to store the blocks.
+  @param[in]   MaxCount   The maximum number of blocks to collect.
+
+  @return                 The number of blocks collected.
+
+**/
+UINT8
+TcpSackBuildBlocks (
+  IN     TCP_CB         *Tcb,
+     OUT TCP_SACK_BLOCK *Block,
+  IN     UINT8          MaxCount
+  )
+{
+  LIST_ENTRY      *Entry;
+  TCP_SACK_BLOCK  Cur;
+  UINT8           Count;
+
+  Count = 0;
+  if (MaxCount == 0) {
+    return 0;
+  }
+
+  Entry = Tcb->RcvQue.ForwardLink;
+  while (TcpSackNextBlock (Tcb, &Entry, &Cur)) {
+    if (TCP_SEQ_LEQ (Cur.Left, Tcb->SackRcvSeq) && TCP_SEQ_LT (Tcb->SackRcvSeq, Cur.Right)) {
+      Block[Count++] = Cur;
+      break;
+    }
+  }
+
+  Entry = Tcb->RcvQue.ForwardLink;
+  while ((Count < MaxCount) && TcpSackNextBlock (Tcb, &Entry, &Cur)) {
+    if ((Count == 0) || (Cur.Left != Block[0].Left)) {
+      Block[Count++] = Cur;
+    }
+  }
+
+  return Count;
+}
+
 /**
   Compute the window scale value according to the given buffer size.
 
@@ -165,6 +263,26 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build the SACK permitted option when doing active open with
+  // SACK enabled, or the peer has permitted SACK.
+  //
+  if ((!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK)) ||
+      TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK)
+      ) {
+
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -192,11 +310,16 @@ TcpBuildOption (
   IN NET_BUF *Nbuf
   )
 {
-  UINT8   *Data;
-  UINT16  Len;
+  UINT8           *Data;
+  UINT16          Len;
+  UINT32          DataLen;
+  TCP_SACK_BLOCK  Block[TCP_SACK_BLOCK_MAX];
+  UINT8           Count;
+  UINT8           Index;
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
-  Len = 0;
+  Len     = 0;
+  DataLen = Nbuf->TotalSize;
 
   //
   // Build the Timestamp option.
@@ -219,6 +342,40 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Report the out-of-order data in the reassemble queue as SACK
+  // blocks. Only segments without data carry them, so that the
+  // data segments are not enlarged beyond SndMss.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SACK) &&
+      (DataLen == 0) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST)
+      ) {
+
+    Count = TcpSackBuildBlocks (
+              Tcb,
+              Block,
+              (UINT8) MIN (TCP_SACK_BLOCK_MAX, (TCP_OPTION_MAX_LEN - Len - 4) / TCP_OPTION_SACK_BLOCK_LEN)
+              );
+
+    if (Count != 0) {
+      Data = NetbufAllocSpace (
+               Nbuf,
+               4 + Count * TCP_OPTION_SACK_BLOCK_LEN,
+               NET_BUF_HEAD
+               );
+
+      ASSERT (Data != NULL);
+      Len = (UINT16) (Len + 4 + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+      TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (2 + Count * TCP_OPTION_SACK_BLOCK_LEN));
+      for (Index = 0; Index < Count; Index++) {
+        TcpPutUint32 (Data + 4 + Index * TCP_OPTION_SACK_BLOCK_LEN, Block[Index].Left);
+        TcpPutUint32 (Data + 8 + Index * TCP_OPTION_SACK_BLOCK_LEN, Block[Index].Right);
+      }
+    }
+  }
+
   return Len;
 }
 
@@ -244,10 +401,12 @@ TcpParseOption (
   UINT8 Cur;
   UINT8 Type;
   UINT8 Len;
+  UINT8 Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
-  Option->Flag  = 0;
+  Option->Flag      = 0;
+  Option->SackCount = 0;
 
   TotalLen      = (UINT8) ((Tcp->HeadLen << 2) - sizeof (TCP_HEAD));
   if (TotalLen <= 0) {
@@ -319,6 +478,39 @@ TcpParseOption (
       Cur += TCP_OPTION_TS_LEN;
       break;
 
+    case TCP_OPTION_SACK_PERM:
+      Len = Head[Cur + 1];
+
+      if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+
+        return -1;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+      Cur += TCP_OPTION_SACK_PERM_LEN;
+      break;
+
+    case TCP_OPTION_SACK:
+      Len = Head[Cur + 1];
+
+      if ((Len < 2 + TCP_OPTION_SACK_BLOCK_LEN) ||
+          (((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN) != 0) ||
+          (TotalLen - Cur < Len)) {
+
+        return -1;
+      }
+
+      Option->SackCount = (UINT8) MIN (TCP_SACK_BLOCK_MAX, (Len - 2) / TCP_OPTION_SACK_BLOCK_LEN);
+      for (Index = 0; Index < Option->SackCount; Index++) {
+        Option->Sack[Index].Left  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->Sack[Index].Right = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+      }
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+      Cur = (UINT8) (Cur + Len);
+      break;
+
     case TCP_OPTION_NOP:
       Cur++;
       break;
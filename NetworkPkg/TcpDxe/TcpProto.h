@@ -78,6 +78,8 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_SACK            0x8000 ///< Both ends permitted the SACK option.
+#define TCP_CTRL_NO_SACK         0x10000 ///< Disable SACK option.
 
 //
 // Timer related values
@@ -213,6 +215,20 @@
 
 #define TCP_MAX_WIN                   0xFFFFU
 
+//
+// Maximum number of SACK blocks kept in the scoreboard or carried in one
+// segment (RFC2018).
+//
+#define TCP_SACK_BLOCK_MAX            4
+
+///
+/// A block of data received by the peer out of order, as [Left, Right).
+///
+typedef struct _TCP_SACK_BLOCK {
+  TCP_SEQNO Left;   ///< First sequence number of the block.
+  TCP_SEQNO Right;  ///< The sequence of the last byte of the block + 1.
+} TCP_SACK_BLOCK;
+
 ///
 /// TCP segmentation data.
 ///
@@ -315,6 +331,15 @@ struct _TCP_CONTROL_BLOCK {
   UINT8             LossTimes;    ///< Number of retxmit timeouts in a row.
   TCP_SEQNO         LossRecover;  ///< Recover point for retxmit.
 
+  //
+  // RFC2018 SACK scoreboard: the blocks above SndUna the peer has
+  // reported, sorted by sequence number.
+  //
+  TCP_SACK_BLOCK    SackBlock[TCP_SACK_BLOCK_MAX];
+  UINT8             SackCount;    ///< Number of valid blocks in SackBlock.
+  TCP_SEQNO         SackRexmit;   ///< End of the last hole retxmitted in recovery.
+  TCP_SEQNO         SackRcvSeq;   ///< Seq of the last segment queued for reassembly.
+
   //
   // configuration parameters, for EFI_TCP4_PROTOCOL specification
   //
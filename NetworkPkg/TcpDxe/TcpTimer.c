@@ -209,6 +209,12 @@ TcpRexmitTimeout (
   Tcb->CWnd         = Tcb->SndMss;
   Tcb->LossRecover  = Tcb->SndNxt;
 
+  //
+  // The receiver may have discarded the data it SACKed (RFC2018
+  // section 8), start over with an empty scoreboard.
+  //
+  Tcb->SackCount    = 0;
+
   Tcb->LossTimes++;
   if ((Tcb->LossTimes > Tcb->MaxRexmit) && !TCP_TIMER_ON (Tcb->EnabledTimer, TCP_TIMER_CONNECT)) {
 
@@ -225,6 +225,8 @@ EfiPxeBcStart (
     Private->BlockSize   = (UINTN) PcdGet64 (PcdTftpBlockSize);
   }
 
+  Private->WindowSize = (UINTN) MIN (PcdGet64 (PcdTftpWindowSize), MAX_UINT16);
+
   //
   // Create event for UdpRead/UdpWrite timeout since they are both blocking API.
   //
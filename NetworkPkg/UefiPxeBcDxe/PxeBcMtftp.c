@@ -19,7 +19,8 @@ CHAR8 *mMtftpOptions[PXE_MTFTP_OPTION_MAXIMUM_INDEX] = {
   "blksize",
   "timeout",
   "tsize",
-  "multicast"
+  "multicast",
+  "windowsize"
 };
 
 
@@ -257,7 +258,7 @@ PxeBcMtftp6ReadFile (
 {
   EFI_MTFTP6_PROTOCOL                 *Mtftp6;
   EFI_MTFTP6_TOKEN                    Token;
-  EFI_MTFTP6_OPTION                   ReqOpt[1];
+  EFI_MTFTP6_OPTION                   ReqOpt[2];
   UINT32                              OptCnt;
   UINT8                               OptBuf[128];
   EFI_STATUS                          Status;
@@ -279,6 +280,17 @@ PxeBcMtftp6ReadFile (
     OptCnt++;
   }
 
+  //
+  // Ask the server to send several blocks per ACK. Servers that don't
+  // support windowsize ignore it and the download stays in lockstep.
+  //
+  if (Private->WindowSize > 1) {
+    ReqOpt[OptCnt].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_WINDOWSIZE_INDEX];
+    ReqOpt[OptCnt].ValueStr  = OptBuf + PXE_MTFTP_OPTBUF_MAXNUM_INDEX / 2;
+    PxeBcUintnToAscDec (Private->WindowSize, ReqOpt[OptCnt].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX / 2);
+    OptCnt++;
+  }
+
   Token.Event         = NULL;
   Token.OverrideData  = NULL;
   Token.Filename      = Filename;
@@ -703,7 +715,7 @@ PxeBcMtftp4ReadFile (
 {
   EFI_MTFTP4_PROTOCOL *Mtftp4;
   EFI_MTFTP4_TOKEN    Token;
-  EFI_MTFTP4_OPTION   ReqOpt[1];
+  EFI_MTFTP4_OPTION   ReqOpt[2];
   UINT32              OptCnt;
   UINT8               OptBuf[128];
   EFI_STATUS          Status;
@@ -725,6 +737,17 @@ PxeBcMtftp4ReadFile (
     OptCnt++;
   }
 
+  //
+  // Ask the server to send several blocks per ACK. Servers that don't
+  // support windowsize ignore it and the download stays in lockstep.
+  //
+  if (Private->WindowSize > 1) {
+    ReqOpt[OptCnt].OptionStr = (UINT8 *) mMtftpOptions[PXE_MTFTP_OPTION_WINDOWSIZE_INDEX];
+    ReqOpt[OptCnt].ValueStr  = OptBuf + PXE_MTFTP_OPTBUF_MAXNUM_INDEX / 2;
+    PxeBcUintnToAscDec (Private->WindowSize, ReqOpt[OptCnt].ValueStr, PXE_MTFTP_OPTBUF_MAXNUM_INDEX / 2);
+    OptCnt++;
+  }
+
   Token.Event         = NULL;
   Token.OverrideData  = NULL;
   Token.Filename      = Filename;